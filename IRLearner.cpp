@@ -1,5 +1,6 @@
 #include "IRLearner.h"
 #include "prefferences.h"
+#include "diagnostics/diag.h"
 
 #if __has_include(<Arduino.h>)
 #define RECORD_GAP_MICROS 5000
@@ -99,8 +100,8 @@ void IRLearner::beginSend() {
     IrSender.begin(kIrTxPin);
     IrReceiver.begin(kIrRxPin, DISABLE_LED_FEEDBACK);
     IrReceiver.stop();   // keep it paused until beginListen() is called
-    Serial.printf("[LEARN] IR hardware ready — TX GPIO %d  RX GPIO %d\n",
-                  kIrTxPin, kIrRxPin);
+    DIAG_LOGF(INFO, "LEARN", "IR hardware ready — TX GPIO %d  RX GPIO %d",
+              kIrTxPin, kIrRxPin);
 #endif
 }
 
@@ -115,7 +116,7 @@ void IRLearner::sendCodeDirect(uint8_t protocol, uint16_t address, uint16_t comm
 void IRLearner::beginListen() {
 #if IRLEARNER_HW
     IrReceiver.begin(kIrRxPin, DISABLE_LED_FEEDBACK);
-    Serial.printf("[LEARN] Listening on GPIO %d…\n", kIrRxPin);
+    DIAG_LOGF(INFO, "LEARN", "Listening on GPIO %d…", kIrRxPin);
 #endif
 }
 
@@ -155,8 +156,8 @@ LearnPollResult IRLearner::poll(Command targetCmd) {
     code.protocol = static_cast<uint8_t>(d.protocol);
     code.address  = d.address;
     code.command  = d.command;
-    Serial.printf("[LEARN] Got protocol %d addr=0x%04X cmd=0x%04X\n",
-                  code.protocol, code.address, code.command);
+    DIAG_LOGF(INFO, "LEARN", "Got protocol %d addr=0x%04X cmd=0x%04X",
+              code.protocol, code.address, code.command);
 
     IrReceiver.resume();
 
@@ -167,7 +168,7 @@ LearnPollResult IRLearner::poll(Command targetCmd) {
     const char* pfx = nvsPrefix(targetCmd);
     if (pfx) {
         saveCode(pfx, code);
-        Serial.printf("[LEARN] Saved to NVS under prefix '%s'\n", pfx);
+        DIAG_LOGF(INFO, "LEARN", "Saved to NVS under prefix '%s'", pfx);
     }
 
     return LearnPollResult::OK;
@@ -0,0 +1,132 @@
+#include "control_task.h"
+
+#include "../prefferences.h"
+
+#if __has_include(<Arduino.h>)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+ControlTask::ControlTask(ControlStep& step, uint32_t periodMs)
+    : step_(step), periodMs_(periodMs ? periodMs : 1U) {}
+
+ControlTask::~ControlTask() {
+    stop();
+}
+
+uint32_t ControlTask::nowMs() {
+#if __has_include(<Arduino.h>)
+    return millis();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+uint32_t ControlTask::nowUs() {
+#if __has_include(<Arduino.h>)
+    return micros();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+bool ControlTask::begin() {
+    if (running_.load()) {
+        return true;
+    }
+    stopRequested_.store(false);
+    running_.store(true);
+#if CONTROLTASK_HAS_FREERTOS
+    const BaseType_t created = xTaskCreatePinnedToCore(
+        [](void* self) { static_cast<ControlTask*>(self)->run(); },
+        "control", kControlTaskStackBytes, this, kControlTaskPriority, &task_, kControlTaskCore);
+    if (created != pdPASS) {
+        task_ = nullptr;
+        running_.store(false);
+        return false;
+    }
+#else
+    thread_ = std::thread([this] { run(); });
+#endif
+    return true;
+}
+
+void ControlTask::stop() {
+#if !CONTROLTASK_HAS_FREERTOS
+    stopRequested_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+#endif
+}
+
+ControlTask::Stats ControlTask::stats() const {
+    Stats stats;
+    stats.cycles        = cycles_.load();
+    stats.overruns      = overruns_.load();
+    stats.maxStepUs     = maxStepUs_.load();
+    stats.maxLatenessUs = maxLatenessUs_.load();
+    return stats;
+}
+
+void ControlTask::record(uint32_t latenessUs, uint32_t stepUs) {
+    cycles_.fetch_add(1);
+    if (stepUs > periodMs_ * 1000U) {
+        overruns_.fetch_add(1);
+    }
+    if (stepUs > maxStepUs_.load()) {
+        maxStepUs_.store(stepUs);
+    }
+    if (latenessUs > maxLatenessUs_.load()) {
+        maxLatenessUs_.store(latenessUs);
+    }
+}
+
+void ControlTask::run() {
+    const uint32_t periodUs = periodMs_ * 1000U;
+    uint32_t dueUs = nowUs();
+#if CONTROLTASK_HAS_FREERTOS
+    const TickType_t periodTicks = pdMS_TO_TICKS(periodMs_) ? pdMS_TO_TICKS(periodMs_) : 1;
+    TickType_t lastWake = xTaskGetTickCount();
+#else
+    using namespace std::chrono;
+    steady_clock::time_point due = steady_clock::now();
+#endif
+    while (!stopRequested_.load()) {
+#if CONTROLTASK_HAS_FREERTOS
+        vTaskDelayUntil(&lastWake, periodTicks);
+#else
+        due += milliseconds(periodMs_);
+        std::this_thread::sleep_until(due);
+#endif
+        dueUs += periodUs;
+        const uint32_t startUs = nowUs();
+        step_.controlStep(nowMs());
+        const uint32_t endUs = nowUs();
+
+        const int32_t lateUs = static_cast<int32_t>(startUs - dueUs);
+        record(lateUs > 0 ? static_cast<uint32_t>(lateUs) : 0U, endUs - startUs);
+
+        // After an overrun start counting again from now rather than running
+        // the missed cycles back to back.
+        if (endUs - dueUs > periodUs) {
+            dueUs = endUs;
+#if CONTROLTASK_HAS_FREERTOS
+            lastWake = xTaskGetTickCount();
+#else
+            due = steady_clock::now();
+#endif
+        }
+    }
+#if CONTROLTASK_HAS_FREERTOS
+    // FreeRTOS tasks must not return.
+    running_.store(false);
+    vTaskDelete(nullptr);
+#endif
+}
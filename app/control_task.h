@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if __has_include(<freertos/FreeRTOS.h>)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define CONTROLTASK_HAS_FREERTOS 1
+#else
+#include <thread>
+#define CONTROLTASK_HAS_FREERTOS 0
+#endif
+
+// One pass of the control pipeline (sensor -> PID -> IR).
+class ControlStep {
+public:
+    virtual ~ControlStep() = default;
+    virtual void controlStep(uint32_t nowMs) = 0;
+};
+
+// Runs a ControlStep at a fixed period on its own task: a FreeRTOS task pinned
+// to kControlTaskCore on the ESP32 (vTaskDelayUntil), a std::thread on the
+// host. Unlike HubWorker the period is measured start to start, so a slow step
+// shortens the next sleep instead of shifting every later cycle.
+class ControlTask {
+public:
+    struct Stats {
+        uint32_t cycles        = 0;
+        uint32_t overruns      = 0;  // steps that took longer than the period
+        uint32_t maxStepUs     = 0;
+        uint32_t maxLatenessUs = 0;  // worst start delay past the scheduled time
+    };
+
+    explicit ControlTask(ControlStep& step, uint32_t periodMs = 50U);
+    ~ControlTask();
+
+    ControlTask(const ControlTask&) = delete;
+    ControlTask& operator=(const ControlTask&) = delete;
+
+    // False if the task could not be created; loop() then calls
+    // step.controlStep() itself.
+    bool begin();
+    // Host only: asks the thread to exit and joins it.
+    void stop();
+    bool running() const { return running_.load(); }
+
+    uint32_t periodMs() const { return periodMs_; }
+    Stats stats() const;
+
+private:
+    void run();
+    void record(uint32_t latenessUs, uint32_t stepUs);
+    static uint32_t nowMs();
+    static uint32_t nowUs();
+
+    ControlStep& step_;
+    uint32_t     periodMs_;
+    std::atomic<bool>     running_{false};
+    std::atomic<bool>     stopRequested_{false};
+    std::atomic<uint32_t> cycles_{0};
+    std::atomic<uint32_t> overruns_{0};
+    std::atomic<uint32_t> maxStepUs_{0};
+    std::atomic<uint32_t> maxLatenessUs_{0};
+#if CONTROLTASK_HAS_FREERTOS
+    TaskHandle_t task_ = nullptr;
+#else
+    std::thread  thread_;
+#endif
+};
@@ -79,12 +79,10 @@ bool ThermoDeviceController::chooseNextCommand(uint32_t nowMs,
         return true;
     }
 
-    if (scheduler_.enabled()) {
-        if (scheduler_.nextDueCommand(nowMs, wallNow, outCommand)) {
-            sourceType = LogEventType::SCHEDULE_COMMAND;
-            return true;
-        }
-        return false;
+    // Called even when disabled: the scheduler keeps its relative timers' time.
+    if (scheduler_.nextDueCommand(nowMs, wallNow, outCommand)) {
+        sourceType = LogEventType::SCHEDULE_COMMAND;
+        return true;
     }
     return false;
 }
@@ -143,15 +141,8 @@ void ThermoDeviceController::runThermostatLoop(uint32_t nowMs,
 void ThermoDeviceController::sendCommand(Command command, const WallClockSnapshot& wallNow, LogEventType sourceType) {
     logger_.log(wallNow, sourceType, command, true);
 
-    if (diag::enabled(DiagLevel::INFO)) {
-        diag::log(DiagLevel::INFO, "TX", "Preparing IR transmit");
-#if __has_include(<Arduino.h>)
-        Serial.print("  reason=");
-        Serial.print(sourceLabel(sourceType));
-        Serial.print(" cmd=");
-        Serial.println(commandToString(command));
-#endif
-    }
+    DIAG_LOGF(INFO, "TX", "Preparing IR transmit reason=%s cmd=%s",
+              sourceLabel(sourceType), commandToString(command));
 
     const TxFailureCode txResult = irSender_.sendCommand(command);
     if (txResult != TxFailureCode::NONE) {
@@ -161,17 +152,9 @@ void ThermoDeviceController::sendCommand(Command command, const WallClockSnapsho
                     command,
                     false,
                     static_cast<uint8_t>(txResult));
-        if (diag::enabled(DiagLevel::ERROR)) {
-            diag::log(DiagLevel::ERROR, "TX", "IR transmit failed");
-#if __has_include(<Arduino.h>)
-            Serial.print("  reason=");
-            Serial.print(sourceLabel(sourceType));
-            Serial.print(" cmd=");
-            Serial.print(commandToString(command));
-            Serial.print(" code=");
-            Serial.println(static_cast<uint8_t>(txResult));
-#endif
-        }
+        DIAG_LOGF(ERROR, "TX", "IR transmit failed reason=%s cmd=%s code=%u",
+                  sourceLabel(sourceType), commandToString(command),
+                  static_cast<unsigned>(txResult));
         return;
     }
     lastTxFailure_ = TxFailureCode::NONE;
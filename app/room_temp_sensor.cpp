@@ -11,17 +11,39 @@ static DallasTemperature sensors(&oneWire);
 
 void RoomTempSensor::begin() {
     sensors.begin();
+    hasAddress_ = sensors.getAddress(address_, 0);
+
+    // One blocking read for the initial value, then conversions run in the
+    // background so the control task never waits ~750 ms on the bus.
+    sensors.requestTemperatures();
+    const float temp = hasAddress_ ? sensors.getTempC(address_) : DEVICE_DISCONNECTED_C;
+    lastTempC_ = temp == DEVICE_DISCONNECTED_C ? -999.0f : temp;
+
+    sensors.setWaitForConversion(false);
+    conversionMs_ = sensors.millisToWaitForConversion(sensors.getResolution());
+    sensors.requestTemperatures();
+    conversionStartMs_ = millis();
     Serial.println("[TEMP] DS18B20 initialized");
 }
 
 float RoomTempSensor::readTemperatureC() {
+    if (millis() - conversionStartMs_ < conversionMs_) {
+        return lastTempC_;
+    }
+    if (!hasAddress_) {
+        hasAddress_ = sensors.getAddress(address_, 0);  // sensor plugged in late
+    }
+    const float temp = hasAddress_ ? sensors.getTempC(address_) : DEVICE_DISCONNECTED_C;
     sensors.requestTemperatures();
-    const float temp = sensors.getTempCByIndex(0);
+    conversionStartMs_ = millis();
     if (temp == DEVICE_DISCONNECTED_C) {
         Serial.println("[TEMP] Sensor disconnected!");
-        return -999.0f;
+        hasAddress_ = false;
+        lastTempC_  = -999.0f;
+    } else {
+        lastTempC_ = temp;
     }
-    return temp;
+    return lastTempC_;
 }
 
 #else
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <cstdint>
+
 class RoomTempSensor {
 public:
     void begin();
+    // Never blocks on the DS18B20: returns the last finished conversion and
+    // starts the next one once it is ready (the first is read in begin()).
     float readTemperatureC();
 private:
-    float mockTemperatureC_ = 21.5F;
+    float    mockTemperatureC_  = 21.5F;
+    float    lastTempC_         = -999.0F;
+    uint8_t  address_[8]        = {};
+    bool     hasAddress_        = false;
+    uint32_t conversionStartMs_ = 0;
+    uint32_t conversionMs_      = 750U;
 };
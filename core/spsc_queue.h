@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer / single-consumer queue. One thread (or task) may
+// push and one other may pop, with no locks and no allocation. Holds
+// Capacity - 1 items; push() returns false instead of blocking when full.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2, "SpscQueue needs room for at least one item");
+
+public:
+    bool push(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = increment(tail);
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        items_[tail] = item;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = items_[head];
+        head_.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a thread that is neither producer nor consumer.
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    size_t size() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : Capacity - head + tail;
+    }
+    static constexpr size_t capacity() { return Capacity - 1; }
+
+private:
+    static size_t increment(size_t index) { return index + 1 == Capacity ? 0 : index + 1; }
+
+    T items_[Capacity] = {};
+    std::atomic<size_t> head_{0};  // next slot to pop (consumer owns)
+    std::atomic<size_t> tail_{0};  // next slot to push (producer owns)
+};
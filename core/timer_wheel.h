@@ -0,0 +1,347 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Handle to a running timer; kNoTimer is never handed out. A handle goes
+// stale when its timer expires (one-shot) or is cancelled, and a stale
+// handle is safe to cancel.
+using TimerId = uint32_t;
+constexpr TimerId kNoTimer = 0;
+
+struct TimerExpiry {
+    TimerId  id     = kNoTimer;
+    uint32_t cookie = 0;  // caller's tag from start()
+    uint32_t atMs   = 0;  // when it was due
+};
+
+// Hierarchical timer wheel for up to N one-shot or periodic millisecond
+// timers, without allocation. Eight levels of 16 slots cover the uint32_t
+// millis() range: a timer sits at the highest 4-bit group in which its due
+// time differs from the wheel's time and drops a level each time the wheel
+// reaches its slot, so it moves at most 7 times. Due times are compared as
+// signed differences, so millis() wrapping after ~49.7 days is harmless as
+// long as they are within 2^31 ms (~24.8 days) of the last poll().
+//
+// start() and cancel() are O(1). The wheel keeps the start of its first
+// occupied slot, so a poll() with nothing due is one compare; reaching a
+// slot finds the next with a bitmap per level, so a long gap between polls
+// costs one step per occupied slot rather than one per millisecond. Timers
+// due at the same millisecond expire in start() order.
+template <size_t N>
+class TimerWheel {
+public:
+    static constexpr size_t kCapacity = N;
+    static_assert(N > 0 && N < 0xFFFFU, "timers are indexed by uint16_t");
+
+    explicit TimerWheel(uint32_t nowMs = 0) { reset(nowMs); }
+
+    // Drops every timer; their handles go stale.
+    void reset(uint32_t nowMs) {
+        nowMs_ = nowMs;
+        heads_.fill(kNil);
+        occupied_.fill(0);
+        for (size_t i = 0; i < N; ++i) {
+            Node& node = nodes_[i];
+            if (node.list != kFreeList) {
+                bumpGeneration(node);
+            }
+            node.list = kFreeList;
+            node.next = static_cast<uint16_t>(i + 1 < N ? i + 1 : kNil);
+        }
+        freeHead_ = 0;
+        count_    = 0;
+        slotDue_  = false;
+    }
+
+    // Starts a timer due at atMs, then every periodMs if that is nonzero. A
+    // due time at or before the wheel's time expires on the next poll().
+    // kNoTimer when all N are running.
+    TimerId start(uint32_t atMs, uint32_t cookie, uint32_t periodMs = 0) {
+        if (freeHead_ == kNil) {
+            return kNoTimer;
+        }
+        const uint16_t index = freeHead_;
+        Node& node = nodes_[index];
+        freeHead_   = node.next;
+        node.atMs   = atMs;
+        node.period = periodMs;
+        node.cookie = cookie;
+        ++count_;
+        place(index);
+        return idOf(index);
+    }
+
+    // False for a stale handle.
+    bool cancel(TimerId id) {
+        const uint16_t index = indexOf(id);
+        if (index == kNil) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Moves the wheel to nowMs without handing anything out; timers due by
+    // then wait for the next poll(). Keeps an idle owner's wheel within
+    // 2^31 ms of the time it will start() against.
+    void advanceTo(uint32_t nowMs) {
+        if (count_ == 0) {
+            nowMs_   = nowMs;
+            slotDue_ = false;
+            return;
+        }
+        while (advance(nowMs)) {
+        }
+    }
+
+    bool   pending(TimerId id) const { return indexOf(id) != kNil; }
+    size_t size() const { return count_; }
+    uint32_t nowMs() const { return nowMs_; }
+
+    // Advances the wheel to nowMs and hands out the timers due by then, one
+    // per call, earliest first. A periodic timer is started again for its
+    // next period after nowMs, in phase, before it is returned: a late poll
+    // gets one expiry, not one per missed period.
+    bool poll(uint32_t nowMs, TimerExpiry& out) {
+        if (count_ == 0) {
+            nowMs_   = nowMs;
+            slotDue_ = false;
+            return false;
+        }
+        for (;;) {
+            const uint16_t index = heads_[kReadyList];
+            if (index != kNil) {
+                Node& node = nodes_[index];
+                out.id     = idOf(index);
+                out.cookie = node.cookie;
+                out.atMs   = node.atMs;
+                unlink(index);
+                if (node.period == 0) {
+                    release(index);
+                } else {
+                    node.atMs += node.period;
+                    if (static_cast<int32_t>(node.atMs - nowMs) <= 0) {
+                        node.atMs += ((nowMs - node.atMs) / node.period + 1U) * node.period;
+                    }
+                    place(index);
+                }
+                return true;
+            }
+            if (!advance(nowMs)) {
+                return false;
+            }
+        }
+    }
+
+    // The timer that expires first, without advancing the wheel.
+    bool next(TimerExpiry& out) const {
+        uint16_t list = heads_[kReadyList] != kNil ? kReadyList : kNil;
+        for (uint8_t level = 0; list == kNil && level < kLevels; ++level) {
+            if (occupied_[level] != 0U) {
+                list = static_cast<uint16_t>(level * kSlots + nextSlot(level));
+            }
+        }
+        if (list == kNil) {
+            return false;
+        }
+        // A level-0 slot holds timers due at one millisecond; a higher slot
+        // spans many, so take its earliest.
+        const uint16_t head = heads_[list];
+        uint16_t best = head;
+        for (uint16_t i = nodes_[head].next; i != head; i = nodes_[i].next) {
+            if (static_cast<int32_t>(nodes_[i].atMs - nodes_[best].atMs) < 0) {
+                best = i;
+            }
+        }
+        out.id     = idOf(best);
+        out.cookie = nodes_[best].cookie;
+        out.atMs   = nodes_[best].atMs;
+        return true;
+    }
+
+private:
+    static constexpr uint8_t  kSlotBits  = 4;
+    static constexpr uint8_t  kSlots     = 1U << kSlotBits;
+    static constexpr uint8_t  kLevels    = 32U / kSlotBits;
+    static constexpr uint16_t kReadyList = kLevels * kSlots;
+    static constexpr uint16_t kFreeList  = 0xFFFFU;
+    static constexpr uint16_t kNil       = 0xFFFFU;
+
+    struct Node {
+        uint32_t atMs       = 0;
+        uint32_t period     = 0;
+        uint32_t cookie     = 0;
+        uint16_t next       = kNil;  // circular within a slot, singly linked when free
+        uint16_t prev       = kNil;
+        uint16_t generation = 1;
+        uint16_t list       = kFreeList;
+    };
+
+    static void bumpGeneration(Node& node) {
+        node.generation = static_cast<uint16_t>(node.generation == 0xFFFFU ? 1U : node.generation + 1U);
+    }
+
+    TimerId idOf(uint16_t index) const {
+        return (static_cast<uint32_t>(nodes_[index].generation) << 16) | index;
+    }
+
+    uint16_t indexOf(TimerId id) const {
+        const uint16_t index = static_cast<uint16_t>(id & 0xFFFFU);
+        if (index >= N || nodes_[index].list == kFreeList ||
+            nodes_[index].generation != static_cast<uint16_t>(id >> 16)) {
+            return kNil;
+        }
+        return index;
+    }
+
+    static uint8_t levelShift(uint8_t level) { return static_cast<uint8_t>(level * kSlotBits); }
+
+    uint8_t slotAt(uint8_t level, uint32_t timeMs) const {
+        return static_cast<uint8_t>((timeMs >> levelShift(level)) & (kSlots - 1U));
+    }
+
+    // First occupied slot the wheel reaches at this level: the next one
+    // after the current slot, else the first one from slot 0. Only the top
+    // level can need that wrap: below it, the wheel stops at every occupied
+    // slot before leaving the window its group is in.
+    uint8_t nextSlot(uint8_t level) const {
+        const uint32_t mask  = occupied_[level];
+        const uint8_t  cur   = slotAt(level, nowMs_);
+        const uint32_t ahead = mask & ~((2UL << cur) - 1U);
+        return static_cast<uint8_t>(__builtin_ctz(ahead != 0U ? ahead : mask));
+    }
+
+    // Milliseconds until the wheel reaches the start of `slot` at `level`.
+    uint32_t distanceTo(uint8_t level, uint8_t slot) const {
+        const uint8_t  shift  = levelShift(level);
+        const uint32_t window =
+            level + 1U < kLevels ? ~((static_cast<uint32_t>(kSlots) << shift) - 1U) : 0U;
+        const uint32_t at     = (nowMs_ & window) | (static_cast<uint32_t>(slot) << shift);
+        return at - nowMs_;
+    }
+
+    void place(uint16_t index) {
+        const uint32_t atMs = nodes_[index].atMs;
+        if (static_cast<int32_t>(atMs - nowMs_) <= 0) {
+            link(index, kReadyList);
+            return;
+        }
+        const uint32_t differs = atMs ^ nowMs_;
+        const uint8_t  level   = static_cast<uint8_t>((31 - __builtin_clz(differs)) / kSlotBits);
+        const uint8_t  slot    = slotAt(level, atMs);
+        link(index, static_cast<uint16_t>(level * kSlots + slot));
+        occupied_[level] |= 1UL << slot;
+        noteSlot(level, slot);
+    }
+
+    void noteSlot(uint8_t level, uint8_t slot) {
+        const uint32_t startMs = nowMs_ + distanceTo(level, slot);
+        if (!slotDue_ || static_cast<int32_t>(startMs - slotDueMs_) < 0) {
+            slotDueMs_ = startMs;
+            slotDue_   = true;
+        }
+    }
+
+    void refreshSlotDue() {
+        slotDue_ = false;
+        for (uint8_t level = 0; level < kLevels; ++level) {
+            if (occupied_[level] != 0U) {
+                noteSlot(level, nextSlot(level));
+            }
+        }
+    }
+
+    void link(uint16_t index, uint16_t list) {
+        Node& node = nodes_[index];
+        node.list = list;
+        const uint16_t head = heads_[list];
+        if (head == kNil) {
+            node.next = node.prev = index;
+            heads_[list] = index;
+            return;
+        }
+        const uint16_t tail = nodes_[head].prev;
+        node.prev = tail;
+        node.next = head;
+        nodes_[tail].next = index;
+        nodes_[head].prev = index;
+    }
+
+    void unlink(uint16_t index) {
+        Node& node = nodes_[index];
+        const uint16_t list = node.list;
+        if (node.next == index) {
+            heads_[list] = kNil;
+            if (list != kReadyList) {
+                occupied_[list / kSlots] &= ~(1UL << (list % kSlots));
+            }
+        } else {
+            nodes_[node.prev].next = node.next;
+            nodes_[node.next].prev = node.prev;
+            if (heads_[list] == index) {
+                heads_[list] = node.next;
+            }
+        }
+    }
+
+    void release(uint16_t index) {
+        Node& node = nodes_[index];
+        bumpGeneration(node);
+        node.list = kFreeList;
+        node.next = freeHead_;
+        freeHead_ = index;
+        --count_;
+    }
+
+    // Moves the wheel to the next occupied slot due by nowMs and empties it:
+    // level-0 timers become ready, higher ones drop to a lower level. False,
+    // with the wheel at nowMs, when no slot is due by then; that check is one
+    // compare against slotDueMs_.
+    bool advance(uint32_t nowMs) {
+        if (static_cast<int32_t>(nowMs - nowMs_) <= 0) {
+            return false;
+        }
+        if (!slotDue_ || static_cast<int32_t>(nowMs - slotDueMs_) < 0) {
+            nowMs_ = nowMs;
+            return false;
+        }
+        nowMs_ = slotDueMs_;
+        // Every level whose slot starts here; a cascaded timer lands in a
+        // later slot or on the ready list.
+        for (uint8_t level = kLevels; level-- > 0;) {
+            const uint32_t below = (1UL << levelShift(level)) - 1U;
+            const uint8_t  slot  = slotAt(level, nowMs_);
+            if ((nowMs_ & below) != 0U || (occupied_[level] & (1UL << slot)) == 0U) {
+                continue;
+            }
+            const uint16_t list = static_cast<uint16_t>(level * kSlots + slot);
+            uint16_t index = heads_[list];
+            const uint16_t tail = nodes_[index].prev;
+            heads_[list] = kNil;
+            occupied_[level] &= ~(1UL << slot);
+            for (;;) {
+                const uint16_t next = nodes_[index].next;
+                const bool     last = index == tail;
+                place(index);
+                if (last) {
+                    break;
+                }
+                index = next;
+            }
+        }
+        refreshSlotDue();
+        return true;
+    }
+
+    std::array<Node, N>                        nodes_{};
+    std::array<uint16_t, kLevels * kSlots + 1> heads_{};  // + the ready list
+    std::array<uint16_t, kLevels>              occupied_{};
+    uint32_t nowMs_     = 0;
+    uint32_t slotDueMs_ = 0;  // first occupied slot's start; early after a cancel, never late
+    bool     slotDue_   = false;
+    uint16_t freeHead_  = kNil;
+    uint16_t count_     = 0;
+};
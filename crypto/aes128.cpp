@@ -0,0 +1,128 @@
+#include "aes128.h"
+
+namespace {
+constexpr uint8_t kSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+constexpr uint8_t xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+constexpr uint32_t rotr8(uint32_t x) { return (x >> 8) | (x << 24); }
+
+// Te[x] = SubBytes + MixColumns for one input byte, as a big-endian column
+// (2s, s, s, 3s). The other three columns are byte rotations of it.
+struct EncryptTable {
+    uint32_t te[256];
+    constexpr EncryptTable() : te() {
+        for (int i = 0; i < 256; ++i) {
+            const uint8_t s  = kSbox[i];
+            const uint8_t s2 = xtime(s);
+            const uint8_t s3 = static_cast<uint8_t>(s2 ^ s);
+            te[i] = (static_cast<uint32_t>(s2) << 24) | (static_cast<uint32_t>(s) << 16) |
+                    (static_cast<uint32_t>(s) << 8) | s3;
+        }
+    }
+};
+
+constexpr EncryptTable kTe{};
+
+inline uint32_t loadBe(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline void storeBe(uint32_t v, uint8_t* p) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+inline uint32_t subWord(uint32_t w) {
+    return (static_cast<uint32_t>(kSbox[w >> 24]) << 24) |
+           (static_cast<uint32_t>(kSbox[(w >> 16) & 0xFF]) << 16) |
+           (static_cast<uint32_t>(kSbox[(w >> 8) & 0xFF]) << 8) | kSbox[w & 0xFF];
+}
+
+// One round column: SubBytes + ShiftRows + MixColumns for output column c.
+inline uint32_t roundColumn(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    return kTe.te[a >> 24] ^ rotr8(kTe.te[(b >> 16) & 0xFF]) ^
+           rotr8(rotr8(kTe.te[(c >> 8) & 0xFF])) ^ rotr8(rotr8(rotr8(kTe.te[d & 0xFF])));
+}
+
+// Last round: no MixColumns.
+inline uint32_t finalColumn(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    return (static_cast<uint32_t>(kSbox[a >> 24]) << 24) |
+           (static_cast<uint32_t>(kSbox[(b >> 16) & 0xFF]) << 16) |
+           (static_cast<uint32_t>(kSbox[(c >> 8) & 0xFF]) << 8) | kSbox[d & 0xFF];
+}
+}  // namespace
+
+void Aes128::setKey(const uint8_t key[16]) {
+    uint8_t rcon = 0x01;
+    for (int i = 0; i < 4; ++i) {
+        roundKeys_[i] = loadBe(key + 4 * i);
+    }
+    for (int i = 4; i < 44; ++i) {
+        uint32_t t = roundKeys_[i - 1];
+        if (i % 4 == 0) {
+            t = subWord((t << 8) | (t >> 24)) ^ (static_cast<uint32_t>(rcon) << 24);
+            rcon = xtime(rcon);
+        }
+        roundKeys_[i] = roundKeys_[i - 4] ^ t;
+    }
+}
+
+void Aes128::encryptBlock(const uint8_t in[16], uint8_t out[16]) const {
+    const uint32_t* rk = roundKeys_;
+    uint32_t s0 = loadBe(in) ^ rk[0];
+    uint32_t s1 = loadBe(in + 4) ^ rk[1];
+    uint32_t s2 = loadBe(in + 8) ^ rk[2];
+    uint32_t s3 = loadBe(in + 12) ^ rk[3];
+    for (int round = 1; round < 10; ++round) {
+        rk += 4;
+        const uint32_t t0 = roundColumn(s0, s1, s2, s3) ^ rk[0];
+        const uint32_t t1 = roundColumn(s1, s2, s3, s0) ^ rk[1];
+        const uint32_t t2 = roundColumn(s2, s3, s0, s1) ^ rk[2];
+        const uint32_t t3 = roundColumn(s3, s0, s1, s2) ^ rk[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    rk += 4;
+    storeBe(finalColumn(s0, s1, s2, s3) ^ rk[0], out);
+    storeBe(finalColumn(s1, s2, s3, s0) ^ rk[1], out + 4);
+    storeBe(finalColumn(s2, s3, s0, s1) ^ rk[2], out + 8);
+    storeBe(finalColumn(s3, s0, s1, s2) ^ rk[3], out + 12);
+}
+
+void Aes128::ctr(uint8_t counter[16], uint8_t stream[16], size_t& offset,
+                 const uint8_t* in, uint8_t* out, size_t len) const {
+    size_t n = offset;
+    for (size_t i = 0; i < len; ++i) {
+        if (n == 0) {
+            encryptBlock(counter, stream);
+            for (int j = 15; j >= 0; --j) {
+                if (++counter[j] != 0) break;
+            }
+        }
+        out[i] = in[i] ^ stream[n];
+        n = (n + 1) & 0x0F;
+    }
+    offset = n;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Portable AES-128 (encryption direction only, which is all CTR needs).
+// Table-driven; used by MessageCrypto where mbedtls is not available.
+class Aes128 {
+public:
+    void setKey(const uint8_t key[16]);
+    void encryptBlock(const uint8_t in[16], uint8_t out[16]) const;
+
+    // CTR with the same streaming state as mbedtls_aes_crypt_ctr: counter is
+    // incremented big-endian per block, stream/offset carry a partial block
+    // between calls. in and out may be the same buffer.
+    void ctr(uint8_t counter[16], uint8_t stream[16], size_t& offset,
+             const uint8_t* in, uint8_t* out, size_t len) const;
+
+private:
+    uint32_t roundKeys_[44] = {};
+};
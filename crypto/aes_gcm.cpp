@@ -0,0 +1,144 @@
+#include "aes_gcm.h"
+
+#include <cstring>
+
+namespace {
+// Reduction constants for shifting the GHASH state 4 bits at a time.
+const uint64_t kLast4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+};
+
+inline uint64_t loadBe64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline void storeBe64(uint64_t v, uint8_t* p) {
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+inline void incrementCounter(uint8_t block[16]) {
+    for (int i = 15; i >= 12; --i) {
+        if (++block[i] != 0) break;
+    }
+}
+}  // namespace
+
+void AesGcm128::setKey(const uint8_t key[16]) {
+    aes_.setKey(key);
+    uint8_t h[16] = {};
+    aes_.encryptBlock(h, h);
+
+    uint64_t vh = loadBe64(h);
+    uint64_t vl = loadBe64(h + 8);
+    hl_[8] = vl;
+    hh_[8] = vh;
+    hl_[0] = 0;
+    hh_[0] = 0;
+    for (int i = 4; i > 0; i >>= 1) {
+        const uint64_t t = (vl & 1) * 0xe1000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (t << 32);
+        hl_[i] = vl;
+        hh_[i] = vh;
+    }
+    for (int i = 2; i <= 8; i *= 2) {
+        for (int j = 1; j < i; ++j) {
+            hh_[i + j] = hh_[i] ^ hh_[j];
+            hl_[i + j] = hl_[i] ^ hl_[j];
+        }
+    }
+}
+
+void AesGcm128::ghashMultiply(uint8_t x[16]) const {
+    uint8_t lo = x[15] & 0x0F;
+    uint64_t zh = hh_[lo];
+    uint64_t zl = hl_[lo];
+    for (int i = 15; i >= 0; --i) {
+        lo = x[i] & 0x0F;
+        const uint8_t hi = (x[i] >> 4) & 0x0F;
+        if (i != 15) {
+            const uint8_t rem = static_cast<uint8_t>(zl & 0x0F);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (kLast4[rem] << 48);
+            zh ^= hh_[lo];
+            zl ^= hl_[lo];
+        }
+        const uint8_t rem = static_cast<uint8_t>(zl & 0x0F);
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (kLast4[rem] << 48);
+        zh ^= hh_[hi];
+        zl ^= hl_[hi];
+    }
+    storeBe64(zh, x);
+    storeBe64(zl, x + 8);
+}
+
+void AesGcm128::ghashUpdate(uint8_t state[16], const uint8_t* data, size_t len) const {
+    for (size_t i = 0; i < len; i += 16) {
+        const size_t n = len - i < 16 ? len - i : 16;
+        for (size_t j = 0; j < n; ++j) state[j] ^= data[i + j];
+        ghashMultiply(state);
+    }
+}
+
+void AesGcm128::crypt(const uint8_t iv[12], const uint8_t* aad, size_t aadLen, const uint8_t* in,
+                      uint8_t* out, size_t len, bool encrypt, uint8_t tag[16]) const {
+    uint8_t j0[16];
+    memcpy(j0, iv, 12);
+    j0[12] = 0;
+    j0[13] = 0;
+    j0[14] = 0;
+    j0[15] = 1;
+
+    uint8_t ghash[16] = {};
+    ghashUpdate(ghash, aad, aadLen);
+
+    // One pass: each block is encrypted and folded into GHASH (ciphertext
+    // side) before moving on.
+    uint8_t counter[16];
+    memcpy(counter, j0, 16);
+    uint8_t stream[16];
+    for (size_t i = 0; i < len; i += 16) {
+        const size_t n = len - i < 16 ? len - i : 16;
+        incrementCounter(counter);
+        aes_.encryptBlock(counter, stream);
+        for (size_t j = 0; j < n; ++j) {
+            const uint8_t c = encrypt ? static_cast<uint8_t>(in[i + j] ^ stream[j]) : in[i + j];
+            out[i + j] = static_cast<uint8_t>(in[i + j] ^ stream[j]);
+            ghash[j] ^= c;
+        }
+        ghashMultiply(ghash);
+    }
+
+    uint8_t lengths[16];
+    storeBe64(static_cast<uint64_t>(aadLen) * 8, lengths);
+    storeBe64(static_cast<uint64_t>(len) * 8, lengths + 8);
+    ghashUpdate(ghash, lengths, sizeof(lengths));
+
+    aes_.encryptBlock(j0, tag);
+    for (int i = 0; i < 16; ++i) tag[i] ^= ghash[i];
+}
+
+void AesGcm128::seal(const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+                     const uint8_t* in, uint8_t* out, size_t len, uint8_t tag[16]) const {
+    crypt(iv, aad, aadLen, in, out, len, true, tag);
+}
+
+bool AesGcm128::open(const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+                     const uint8_t* in, uint8_t* out, size_t len, const uint8_t tag[16]) const {
+    uint8_t expected[16];
+    crypt(iv, aad, aadLen, in, out, len, false, expected);
+    uint8_t diff = 0;
+    for (int i = 0; i < 16; ++i) diff |= expected[i] ^ tag[i];
+    if (diff != 0) {
+        memset(out, 0, len);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "aes128.h"
+
+// Portable AES-128-GCM with 96-bit IVs and 16-byte tags (NIST SP 800-38D).
+// Encrypts and authenticates in one pass over the data; GHASH uses 4-bit
+// tables. Used by MessageCrypto where mbedtls is not available.
+class AesGcm128 {
+public:
+    void setKey(const uint8_t key[16]);
+
+    // in and out may be the same buffer.
+    void seal(const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+              const uint8_t* in, uint8_t* out, size_t len, uint8_t tag[16]) const;
+    // Decrypts and checks the tag in the same pass; on a mismatch out is
+    // zeroed and false returned.
+    bool open(const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+              const uint8_t* in, uint8_t* out, size_t len, const uint8_t tag[16]) const;
+
+private:
+    void ghashMultiply(uint8_t x[16]) const;  // x = x * H
+    void ghashUpdate(uint8_t state[16], const uint8_t* data, size_t len) const;
+    void crypt(const uint8_t iv[12], const uint8_t* aad, size_t aadLen, const uint8_t* in,
+               uint8_t* out, size_t len, bool encrypt, uint8_t tag[16]) const;
+
+    Aes128   aes_;
+    uint64_t hl_[16] = {};  // multiples of H, low/high halves
+    uint64_t hh_[16] = {};
+};
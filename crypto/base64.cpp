@@ -0,0 +1,76 @@
+#include "base64.h"
+
+namespace base64 {
+namespace {
+const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// 0..63 for alphabet characters, 64 for '=', 0xFF for anything else.
+struct DecodeTable {
+    uint8_t value[256];
+    constexpr DecodeTable() : value() {
+        for (int i = 0; i < 256; ++i) value[i] = 0xFF;
+        for (int i = 0; i < 64; ++i) value[static_cast<uint8_t>(kAlphabet[i])] = static_cast<uint8_t>(i);
+        value[static_cast<uint8_t>('=')] = 64;
+    }
+};
+constexpr DecodeTable kDecode{};
+}  // namespace
+
+size_t encode(const uint8_t* data, size_t len, char* out, size_t outSize) {
+    const size_t needed = encodedSize(len);
+    if (outSize < needed + 1) {
+        return 0;
+    }
+    char* p = out;
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3) {
+        const uint32_t v = (static_cast<uint32_t>(data[i]) << 16) |
+                           (static_cast<uint32_t>(data[i + 1]) << 8) | data[i + 2];
+        *p++ = kAlphabet[(v >> 18) & 0x3F];
+        *p++ = kAlphabet[(v >> 12) & 0x3F];
+        *p++ = kAlphabet[(v >> 6) & 0x3F];
+        *p++ = kAlphabet[v & 0x3F];
+    }
+    if (i < len) {
+        const bool two = i + 1 < len;
+        const uint32_t v = (static_cast<uint32_t>(data[i]) << 16) |
+                           (two ? static_cast<uint32_t>(data[i + 1]) << 8 : 0U);
+        *p++ = kAlphabet[(v >> 18) & 0x3F];
+        *p++ = kAlphabet[(v >> 12) & 0x3F];
+        *p++ = two ? kAlphabet[(v >> 6) & 0x3F] : '=';
+        *p++ = '=';
+    }
+    *p = '\0';
+    return needed;
+}
+
+bool decode(const char* text, size_t len, uint8_t* out, size_t outSize, size_t& outLen) {
+    outLen = 0;
+    if (len % 4 != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i += 4) {
+        const uint8_t a = kDecode.value[static_cast<uint8_t>(text[i])];
+        const uint8_t b = kDecode.value[static_cast<uint8_t>(text[i + 1])];
+        const uint8_t c = kDecode.value[static_cast<uint8_t>(text[i + 2])];
+        const uint8_t d = kDecode.value[static_cast<uint8_t>(text[i + 3])];
+        const bool last = i + 4 == len;
+        // '=' may only pad the end of the last quantum.
+        if (a > 63 || b > 63 || c == 0xFF || d == 0xFF ||
+            (!last && (c == 64 || d == 64)) || (c == 64 && d != 64)) {
+            return false;
+        }
+        const size_t bytes = c == 64 ? 1 : (d == 64 ? 2 : 3);
+        if (outLen + bytes > outSize) {
+            return false;
+        }
+        const uint32_t v = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) |
+                           (static_cast<uint32_t>(c & 0x3F) << 6) | (d & 0x3F);
+        out[outLen++] = static_cast<uint8_t>(v >> 16);
+        if (bytes > 1) out[outLen++] = static_cast<uint8_t>(v >> 8);
+        if (bytes > 2) out[outLen++] = static_cast<uint8_t>(v);
+    }
+    return true;
+}
+
+}  // namespace base64
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Table-driven standard base64 (RFC 4648, padded). No allocation: callers pass
+// the output buffer.
+namespace base64 {
+
+constexpr size_t encodedSize(size_t len) { return (len + 2) / 3 * 4; }
+constexpr size_t decodedMaxSize(size_t len) { return len / 4 * 3; }
+
+// Writes encodedSize(len) chars plus a terminating NUL; returns the char count,
+// or 0 if out is too small.
+size_t encode(const uint8_t* data, size_t len, char* out, size_t outSize);
+// Returns false on a bad length, a character outside the alphabet, or a full
+// output buffer.
+bool decode(const char* text, size_t len, uint8_t* out, size_t outSize, size_t& outLen);
+
+}  // namespace base64
@@ -1,173 +1,451 @@
 #include "message_crypto.h"
 
-#if MESSAGE_CRYPTO_AVAILABLE
+#include "base64.h"
+
+#if !__has_include(<Arduino.h>)
+#include <chrono>
+#include <random>
+#endif
+
+namespace {
+// ── Backend ───────────────────────────────────────────────────
+#if MESSAGE_CRYPTO_MBEDTLS
+void aesInit(mbedtls_aes_context& aes) { mbedtls_aes_init(&aes); }
+void aesFree(mbedtls_aes_context& aes) { mbedtls_aes_free(&aes); }
+bool aesSetKey(mbedtls_aes_context& aes, const uint8_t key[16]) {
+    return mbedtls_aes_setkey_enc(&aes, key, 128) == 0;
+}
+bool aesCtrStream(mbedtls_aes_context& aes, uint8_t counter[16], uint8_t stream[16],
+                  size_t& offset, const uint8_t* in, uint8_t* out, size_t len) {
+    return mbedtls_aes_crypt_ctr(&aes, len, &offset, counter, stream, in, out) == 0;
+}
+
+void hashInit(mbedtls_sha256_context& h) { mbedtls_sha256_init(&h); }
+void hashStart(mbedtls_sha256_context& h) {
+    mbedtls_sha256_init(&h);
+    mbedtls_sha256_starts(&h, /*is224=*/0);
+}
+void hashUpdate(mbedtls_sha256_context& h, const uint8_t* data, size_t len) {
+    mbedtls_sha256_update(&h, data, len);
+}
+void hashFinish(mbedtls_sha256_context& h, uint8_t out[32]) { mbedtls_sha256_finish(&h, out); }
+void hashCopy(mbedtls_sha256_context& to, const mbedtls_sha256_context& from) {
+    mbedtls_sha256_clone(&to, &from);
+}
+void hashFree(mbedtls_sha256_context& h) { mbedtls_sha256_free(&h); }
+
+void gcmInit(mbedtls_gcm_context& gcm) { mbedtls_gcm_init(&gcm); }
+void gcmFree(mbedtls_gcm_context& gcm) { mbedtls_gcm_free(&gcm); }
+bool gcmSetKey(mbedtls_gcm_context& gcm, const uint8_t key[16]) {
+    return mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, 128) == 0;
+}
+bool gcmSeal(mbedtls_gcm_context& gcm, const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+             const uint8_t* in, uint8_t* out, size_t len, uint8_t tag[16]) {
+    return mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, iv, 12, aad, aadLen, in, out,
+                                     16, tag) == 0;
+}
+bool gcmOpen(mbedtls_gcm_context& gcm, const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+             const uint8_t* in, uint8_t* out, size_t len, const uint8_t tag[16]) {
+    return mbedtls_gcm_auth_decrypt(&gcm, len, iv, 12, aad, aadLen, tag, 16, in, out) == 0;
+}
+#else
+void aesInit(Aes128&) {}
+void aesFree(Aes128&) {}
+bool aesSetKey(Aes128& aes, const uint8_t key[16]) {
+    aes.setKey(key);
+    return true;
+}
+bool aesCtrStream(const Aes128& aes, uint8_t counter[16], uint8_t stream[16],
+                  size_t& offset, const uint8_t* in, uint8_t* out, size_t len) {
+    aes.ctr(counter, stream, offset, in, out, len);
+    return true;
+}
+
+void hashInit(Sha256&) {}
+void hashStart(Sha256& h) { h.reset(); }
+void hashUpdate(Sha256& h, const uint8_t* data, size_t len) { h.update(data, len); }
+void hashFinish(Sha256& h, uint8_t out[32]) { h.finish(out); }
+void hashCopy(Sha256& to, const Sha256& from) { to = from; }
+void hashFree(Sha256&) {}
+
+void gcmInit(AesGcm128&) {}
+void gcmFree(AesGcm128&) {}
+bool gcmSetKey(AesGcm128& gcm, const uint8_t key[16]) {
+    gcm.setKey(key);
+    return true;
+}
+bool gcmSeal(const AesGcm128& gcm, const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+             const uint8_t* in, uint8_t* out, size_t len, uint8_t tag[16]) {
+    gcm.seal(iv, aad, aadLen, in, out, len, tag);
+    return true;
+}
+bool gcmOpen(const AesGcm128& gcm, const uint8_t iv[12], const uint8_t* aad, size_t aadLen,
+             const uint8_t* in, uint8_t* out, size_t len, const uint8_t tag[16]) {
+    return gcm.open(iv, aad, aadLen, in, out, len, tag);
+}
+#endif
+
+// ── Platform ──────────────────────────────────────────────────
+// Envelope timestamp: uptime ms, binds the HMAC to this session.
+uint32_t uptimeMs() {
+#if __has_include(<Arduino.h>)
+    return millis();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Random nonce (len a multiple of 4) from the ESP32 hardware RNG (OS RNG on
+// the host).
+void randomNonce(uint8_t* nonce, size_t len) {
+#if !__has_include(<Arduino.h>)
+    static std::random_device rng;
+#endif
+    for (size_t i = 0; i < len; i += 4) {
+#if __has_include(<Arduino.h>)
+        uint32_t r = esp_random();
+#else
+        uint32_t r = rng();
+#endif
+        memcpy(nonce + i, &r, 4);
+    }
+}
+
+// ── Helpers ───────────────────────────────────────────────────
+bool macEqual(const uint8_t* a, const uint8_t* b) {
+    // Constant-time compare to avoid timing attacks
+    uint8_t diff = 0;
+    for (int i = 0; i < 32; ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+const char kHexDigits[] = "0123456789abcdef";
+
+int8_t hexNibble(char c) {
+    if (c >= '0' && c <= '9') return static_cast<int8_t>(c - '0');
+    if (c >= 'a' && c <= 'f') return static_cast<int8_t>(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F') return static_cast<int8_t>(c - 'A' + 10);
+    return -1;
+}
+}  // namespace
 
 // ── Key derivation ────────────────────────────────────────────
 void MessageCrypto::deriveKeys(const char* password) {
     uint8_t hash[32];
-    mbedtls_sha256_context ctx;
-    mbedtls_sha256_init(&ctx);
-    mbedtls_sha256_starts(&ctx, /*is224=*/0);
-    mbedtls_sha256_update(&ctx, reinterpret_cast<const uint8_t*>(password), strlen(password));
-    mbedtls_sha256_finish(&ctx, hash);
-    mbedtls_sha256_free(&ctx);
+    HashState ctx;
+    hashStart(ctx);
+    hashUpdate(ctx, reinterpret_cast<const uint8_t*>(password), strlen(password));
+    hashFinish(ctx, hash);
+    hashFree(ctx);
+
+    // aes_key = hash[0:16]
+    ready_ = aesSetKey(aes_, hash);
 
-    memcpy(aes_key_,  hash,      16);
-    memcpy(hmac_key_, hash,      32);
+    // hmac_key = hash[0:32]. It is shorter than the 64-byte SHA-256 block,
+    // so the HMAC pads are the key zero-extended and XORed with 0x36 / 0x5c.
+    uint8_t pad[64];
+    for (size_t i = 0; i < sizeof(pad); ++i) pad[i] = (i < 32 ? hash[i] : 0) ^ 0x36;
+    hashUpdate(hmac_inner_, pad, sizeof(pad));
+    for (size_t i = 0; i < sizeof(pad); ++i) pad[i] = (i < 32 ? hash[i] : 0) ^ 0x5c;
+    hashUpdate(hmac_outer_, pad, sizeof(pad));
+
+    // aead_key = HMAC(hmac_key, "v3-aead")[0:16], so GCM never shares a key
+    // with the v1/v2 CTR stream.
+    static const char kAeadLabel[] = "v3-aead";
+    uint8_t aeadKey[32];
+    computeHmac(reinterpret_cast<const uint8_t*>(kAeadLabel), sizeof(kAeadLabel) - 1, aeadKey);
+    ready_ = gcmSetKey(gcm_, aeadKey) && ready_;
+
+    memset(aeadKey, 0, sizeof(aeadKey));
+    memset(pad, 0, sizeof(pad));
+    memset(hash, 0, sizeof(hash));
 }
 
 // ── HMAC-SHA256 ───────────────────────────────────────────────
+// HMAC = H(key^opad || H(key^ipad || data)), resuming from the precomputed
+// pad states.
+void MessageCrypto::hmacStart(HashState& ctx) const {
+    hashInit(ctx);
+    hashCopy(ctx, hmac_inner_);
+}
+
+void MessageCrypto::hmacUpdate(HashState& ctx, const uint8_t* data, size_t len) {
+    hashUpdate(ctx, data, len);
+}
+
+void MessageCrypto::hmacFinish(HashState& ctx, uint8_t out32[32]) const {
+    uint8_t inner[32];
+    hashFinish(ctx, inner);
+    hashCopy(ctx, hmac_outer_);
+    hashUpdate(ctx, inner, sizeof(inner));
+    hashFinish(ctx, out32);
+    hashFree(ctx);
+}
+
 void MessageCrypto::computeHmac(const uint8_t* data, size_t len,
                                  uint8_t out32[32]) const {
-    mbedtls_md_context_t ctx;
-    mbedtls_md_init(&ctx);
-    const mbedtls_md_info_t* info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
-    mbedtls_md_setup(&ctx, info, /*hmac=*/1);
-    mbedtls_md_hmac_starts(&ctx, hmac_key_, 32);
-    mbedtls_md_hmac_update(&ctx, data, len);
-    mbedtls_md_hmac_finish(&ctx, out32);
-    mbedtls_md_free(&ctx);
+    HashState ctx;
+    hmacStart(ctx);
+    hmacUpdate(ctx, data, len);
+    hmacFinish(ctx, out32);
 }
 
 // ── AES-128-CTR ───────────────────────────────────────────────
 bool MessageCrypto::aesCtr(const uint8_t nonce16[16],
                             uint8_t* buf, size_t len) const {
-    mbedtls_aes_context ctx;
-    mbedtls_aes_init(&ctx);
-    if (mbedtls_aes_setkey_enc(&ctx, aes_key_, 128) != 0) {
-        mbedtls_aes_free(&ctx);
+    if (!ready_) {
         return false;
     }
     uint8_t nonce_copy[16];
     memcpy(nonce_copy, nonce16, 16);
     uint8_t stream_block[16] = {};
     size_t  nc_off = 0;
-    mbedtls_aes_crypt_ctr(&ctx, len, &nc_off, nonce_copy, stream_block, buf, buf);
-    mbedtls_aes_free(&ctx);
-    return true;
+    return aesCtrStream(aes_, nonce_copy, stream_block, nc_off, buf, buf, len);
 }
 
 // ── Hex helpers ───────────────────────────────────────────────
-String MessageCrypto::toHex(const uint8_t* data, size_t len) {
-    String s;
-    s.reserve(len * 2);
+void MessageCrypto::toHex(const uint8_t* data, size_t len, char* out) {
     for (size_t i = 0; i < len; ++i) {
-        char h[3];
-        snprintf(h, sizeof(h), "%02x", data[i]);
-        s += h;
+        *out++ = kHexDigits[data[i] >> 4];
+        *out++ = kHexDigits[data[i] & 0x0F];
     }
-    return s;
 }
 
-bool MessageCrypto::fromHex(const char* hex, uint8_t* out, size_t out_len) {
-    if (!hex || strlen(hex) != out_len * 2) return false;
-    for (size_t i = 0; i < out_len; ++i) {
-        char b[3] = { hex[i*2], hex[i*2+1], '\0' };
-        char* end;
-        out[i] = static_cast<uint8_t>(strtoul(b, &end, 16));
-        if (*end) return false;
+bool MessageCrypto::fromHex(const char* hex, size_t hexLen, uint8_t* out, size_t outLen) {
+    if (!hex || hexLen != outLen * 2) return false;
+    for (size_t i = 0; i < outLen; ++i) {
+        const int8_t hi = hexNibble(hex[i * 2]);
+        const int8_t lo = hexNibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<uint8_t>((hi << 4) | lo);
     }
     return true;
 }
 
 // ── Public API ────────────────────────────────────────────────
 MessageCrypto::MessageCrypto(const char* device_pass) {
+    aesInit(aes_);
+    gcmInit(gcm_);
+    hashStart(hmac_inner_);
+    hashStart(hmac_outer_);
     deriveKeys(device_pass);
 }
 
-String MessageCrypto::encryptEnvelope(const String& plaintext) {
+MessageCrypto::~MessageCrypto() {
+    aesFree(aes_);
+    gcmFree(gcm_);
+    hashFree(hmac_inner_);
+    hashFree(hmac_outer_);
+}
+
+size_t MessageCrypto::encryptEnvelope(const uint8_t* data, size_t len, char* out,
+                                      size_t outSize) {
+    if (!ready_ || outSize < v1EnvelopeSize(len) + 1) {
+        return 0;
+    }
+
     // 1. Random 16-byte nonce from ESP32 hardware RNG
     uint8_t nonce[16];
-    for (int i = 0; i < 16; i += 4) {
-        uint32_t r = esp_random();
-        memcpy(nonce + i, &r, 4);
-    }
+    randomNonce(nonce, 16);
 
-    // 2. Encrypt plaintext in-place
-    size_t len = plaintext.length();
-    uint8_t* buf = new uint8_t[len];
-    memcpy(buf, plaintext.c_str(), len);
-    if (!aesCtr(nonce, buf, len)) {
-        delete[] buf;
-        return "";
-    }
+    // 2. "<ts>:" — device uptime ms, binds the HMAC to this session
+    char* p = out + snprintf(out, outSize, "%lu:", static_cast<unsigned long>(uptimeMs()));
 
-    // 3. Build "enc" = hex(nonce || ciphertext)
-    const String enc = toHex(nonce, 16) + toHex(buf, len);
-    delete[] buf;
+    // 3. hex(nonce || ciphertext), encrypting one block at a time straight
+    //    into the output and hashing each piece as it is written.
+    HashState mac;
+    hmacStart(mac);
+    toHex(nonce, 16, p);
+    p += 32;
+    hmacUpdate(mac, reinterpret_cast<const uint8_t*>(out), static_cast<size_t>(p - out));
 
-    // 4. Timestamp (device uptime ms — binds HMAC to this session)
-    char ts[16];
-    snprintf(ts, sizeof(ts), "%lu", static_cast<unsigned long>(millis()));
+    uint8_t counter[16];
+    memcpy(counter, nonce, 16);
+    uint8_t stream_block[16] = {};
+    size_t  nc_off = 0;
+    uint8_t block[16];
+    for (size_t i = 0; i < len; i += sizeof(block)) {
+        const size_t n = len - i < sizeof(block) ? len - i : sizeof(block);
+        if (!aesCtrStream(aes_, counter, stream_block, nc_off, data + i, block, n)) {
+            hashFree(mac);
+            return 0;
+        }
+        toHex(block, n, p);
+        hmacUpdate(mac, reinterpret_cast<const uint8_t*>(p), n * 2);
+        p += n * 2;
+    }
 
-    // 5. HMAC over "<ts>:<enc>"
-    const String mac_input = String(ts) + ":" + enc;
+    // 4. ":" + hex(HMAC over "<ts>:<enc>")
     uint8_t sig[32];
-    computeHmac(reinterpret_cast<const uint8_t*>(mac_input.c_str()),
-                mac_input.length(), sig);
+    hmacFinish(mac, sig);
+    *p++ = ':';
+    toHex(sig, 32, p);
+    p += 64;
+    *p = '\0';
+    return static_cast<size_t>(p - out);
+}
 
-    return String(ts) + ":" + enc + ":" + toHex(sig, 32);
+bool MessageCrypto::decryptEnvelope(const char* envelope, size_t len, uint8_t* out,
+                                    size_t outSize, size_t& outLen) {
+    outLen = 0;
+    // v1 always has ':' separators, which base64 never contains.
+    if (memchr(envelope, ':', len)) {
+        return decryptV1(envelope, len, out, outSize, outLen);
+    }
+    size_t envLen = 0;
+    if (!base64::decode(envelope, len, out, outSize, envLen) || envLen == 0) {
+        return false;
+    }
+    return out[0] == kV3Version ? openV3(out, envLen, out, outSize, outLen)
+                                : openV2(out, envLen, out, outSize, outLen);
 }
 
-String MessageCrypto::decryptEnvelope(const String& envelope) {
+bool MessageCrypto::decryptV1(const char* envelope, size_t len, uint8_t* out, size_t outSize,
+                              size_t& outLen) {
     // Parse "<ts>:<enc>:<sig>"
-    const int first = envelope.indexOf(':');
-    const int last  = envelope.lastIndexOf(':');
-    if (first < 0 || last == first) return "";
-
-    const String ts_str  = envelope.substring(0, first);
-    const String enc     = envelope.substring(first + 1, last);
-    const String sig_hex = envelope.substring(last + 1);
+    const char* first = static_cast<const char*>(memchr(envelope, ':', len));
+    const char* last  = envelope + len;
+    while (last > envelope && *(last - 1) != ':') --last;
+    if (!first || last - 1 == first) return false;
+    const char* enc    = first + 1;
+    const size_t encLen = static_cast<size_t>(last - 1 - enc);
 
-    // Verify HMAC
-    const String mac_input = ts_str + ":" + enc;
+    // Verify HMAC over "<ts>:<enc>"
     uint8_t expected[32];
-    computeHmac(reinterpret_cast<const uint8_t*>(mac_input.c_str()),
-                mac_input.length(), expected);
+    computeHmac(reinterpret_cast<const uint8_t*>(envelope), static_cast<size_t>(last - 1 - envelope),
+                expected);
     uint8_t received[32];
-    if (!fromHex(sig_hex.c_str(), received, 32)) return "";
-    // Constant-time compare to avoid timing attacks
-    uint8_t diff = 0;
-    for (int i = 0; i < 32; ++i) diff |= expected[i] ^ received[i];
-    if (diff != 0) return "";
+    if (!fromHex(last, static_cast<size_t>(envelope + len - last), received, 32)) return false;
+    if (!macEqual(expected, received)) return false;
 
     // Extract nonce (first 32 hex chars = 16 bytes) and ciphertext
-    if (enc.length() < 32) return "";
+    if (encLen < 32 || encLen % 2 != 0) return false;
     uint8_t nonce[16];
-    if (!fromHex(enc.substring(0, 32).c_str(), nonce, 16)) return "";
+    if (!fromHex(enc, 32, nonce, 16)) return false;
+    const size_t cipherLen = (encLen - 32) / 2;
+    if (outSize < cipherLen || !fromHex(enc + 32, encLen - 32, out, cipherLen)) return false;
 
-    const size_t cipher_hex_len = enc.length() - 32;
-    if (cipher_hex_len % 2 != 0) return "";
-    const size_t cipher_len = cipher_hex_len / 2;
-    uint8_t* buf = new uint8_t[cipher_len];
-    if (!fromHex(enc.substring(32).c_str(), buf, cipher_len)) {
-        delete[] buf;
-        return "";
-    }
+    // Decrypt in place
+    if (!aesCtr(nonce, out, cipherLen)) return false;
+    outLen = cipherLen;
+    return true;
+}
 
-    // Decrypt
-    if (!aesCtr(nonce, buf, cipher_len)) {
-        delete[] buf;
-        return "";
+// ── Envelope v2 ───────────────────────────────────────────────
+size_t MessageCrypto::sealV2(const uint8_t* data, size_t len, uint8_t* out, size_t outSize) {
+    if (!ready_ || outSize < len + kV2Overhead) {
+        return 0;
     }
+    uint8_t* cipher = out + kV2PayloadOffset;
+    memmove(cipher, data, len);  // no-op when sealing in place
+    const uint32_t ts = uptimeMs();
+    out[0] = kV2Version;
+    for (int i = 0; i < 4; ++i) out[1 + i] = static_cast<uint8_t>(ts >> (8 * i));
+    uint8_t* nonce = out + 5;
+    randomNonce(nonce, 16);
+    if (!aesCtr(nonce, cipher, len)) {
+        return 0;
+    }
+    computeHmac(out, kV2PayloadOffset + len, cipher + len);
+    return len + kV2Overhead;
+}
 
-    String result;
-    result.reserve(cipher_len);
-    for (size_t i = 0; i < cipher_len; ++i) result += static_cast<char>(buf[i]);
-    delete[] buf;
-    return result;
+bool MessageCrypto::openV2(const uint8_t* env, size_t len, uint8_t* out, size_t outSize,
+                           size_t& outLen) {
+    outLen = 0;
+    if (len < kV2Overhead || env[0] != kV2Version) {
+        return false;
+    }
+    const size_t cipherLen = len - kV2Overhead;
+    if (outSize < cipherLen) {
+        return false;
+    }
+    uint8_t expected[32];
+    computeHmac(env, len - 32, expected);
+    if (!macEqual(expected, env + len - 32)) {
+        return false;
+    }
+    uint8_t nonce[16];
+    memcpy(nonce, env + 5, 16);
+    memmove(out, env + kV2PayloadOffset, cipherLen);
+    if (!aesCtr(nonce, out, cipherLen)) {
+        return false;
+    }
+    outLen = cipherLen;
+    return true;
 }
 
-#else  // ── Desktop stub (no mbedtls) ─────────────────────────
+// ── Envelope v3 (AES-GCM) ─────────────────────────────────────
+size_t MessageCrypto::sealV3(const uint8_t* data, size_t len, uint8_t* out, size_t outSize) {
+    if (!ready_ || outSize < len + kV3Overhead) {
+        return 0;
+    }
+    uint8_t* cipher = out + kV3PayloadOffset;
+    memmove(cipher, data, len);  // no-op when sealing in place
+    const uint32_t ts = uptimeMs();
+    out[0] = kV3Version;
+    for (int i = 0; i < 4; ++i) out[1 + i] = static_cast<uint8_t>(ts >> (8 * i));
+    uint8_t* iv = out + 5;
+    randomNonce(iv, 12);
+    if (!gcmSeal(gcm_, iv, out, 5, cipher, cipher, len, cipher + len)) {
+        return 0;
+    }
+    return len + kV3Overhead;
+}
 
-MessageCrypto::MessageCrypto(const char* /*device_pass*/) {}
+bool MessageCrypto::openV3(const uint8_t* env, size_t len, uint8_t* out, size_t outSize,
+                           size_t& outLen) {
+    outLen = 0;
+    if (!ready_ || len < kV3Overhead || env[0] != kV3Version) {
+        return false;
+    }
+    const size_t cipherLen = len - kV3Overhead;
+    if (outSize < cipherLen) {
+        return false;
+    }
+    // out may alias env, so take the header and tag before the ciphertext
+    // is moved down and decrypted in place.
+    uint8_t header[kV3PayloadOffset];
+    memcpy(header, env, sizeof(header));
+    uint8_t tag[16];
+    memcpy(tag, env + len - 16, 16);
+    memmove(out, env + kV3PayloadOffset, cipherLen);
+    if (!gcmOpen(gcm_, header + 5, header, 5, out, out, cipherLen, tag)) {
+        memset(out, 0, cipherLen);
+        return false;
+    }
+    outLen = cipherLen;
+    return true;
+}
 
+#if MESSAGE_CRYPTO_HAS_STRING
+// ── String API ────────────────────────────────────────────────
 String MessageCrypto::encryptEnvelope(const String& plaintext) {
-    return plaintext; // passthrough — no crypto on host builds
+    return encryptEnvelope(reinterpret_cast<const uint8_t*>(plaintext.c_str()),
+                           plaintext.length());
 }
 
-String MessageCrypto::decryptEnvelope(const String& envelope) {
-    return envelope;  // passthrough
+String MessageCrypto::encryptEnvelope(const uint8_t* data, size_t len) {
+    const size_t size = v1EnvelopeSize(len) + 1;
+    char* buf = new char[size];
+    String result;
+    if (encryptEnvelope(data, len, buf, size) > 0) {
+        result = buf;
+    }
+    delete[] buf;
+    return result;
 }
 
+String MessageCrypto::decryptEnvelope(const String& envelope) {
+    uint8_t* buf = new uint8_t[envelope.length() + 1];
+    size_t len = 0;
+    String result;
+    if (decryptEnvelope(envelope.c_str(), envelope.length(), buf, envelope.length(), len)) {
+        result = String(reinterpret_cast<const char*>(buf), len);
+    }
+    delete[] buf;
+    return result;
+}
 #endif
@@ -12,41 +12,133 @@
 //   aes_key  = sha256(password)[0:16]
 //   hmac_key = sha256(password)[0:32]
 //
-// Envelope format (plain ASCII string):
+// Envelope v1 (plain ASCII string):
 //   "<ts>:<hex(nonce16||ciphertext)>:<hex(hmac32)>"
+// Envelope v2 (binary, kV2Overhead bytes on top of the payload):
+//   [0x02][ts u32 LE][nonce16][ciphertext][hmac32]
+//   HMAC over every byte before it. Sent raw as application/octet-stream, or
+//   base64 where the channel needs text (hub responses). v1 hex doubles the
+//   payload; v2 adds a fixed 53 bytes.
+// Envelope v3 (binary AEAD, kV3Overhead bytes on top of the payload):
+//   [0x03][ts u32 LE][iv12][ciphertext][tag16]
+//   AES-128-GCM under aead_key = HMAC(hmac_key, "v3-aead")[0:16], with the
+//   version and ts bytes as associated data. One pass over the payload
+//   instead of CTR plus a separate SHA-256 pass; same base64/raw transport
+//   as v2.
 //
-// Uses mbedtls, which is bundled with the ESP32 Arduino core.
-// On non-ESP32 (desktop tests) the methods are no-op passthroughs.
+// The AES key schedule and the HMAC inner/outer SHA-256 states (key ^ ipad,
+// key ^ opad) are computed once in the constructor; each message only runs
+// the cipher and hashes its own bytes. The buffer API encrypts in place or
+// a block at a time and never touches the heap; the String API wraps it.
+//
+// Uses mbedtls where it is available (bundled with the ESP32 Arduino core,
+// hardware AES/SHA there; GCM runs on the AES block too). Elsewhere the
+// portable Aes128/Sha256/AesGcm128 in this directory produce the same bytes,
+// so desktop tests and benches run the real envelope format.
 
-#if __has_include(<mbedtls/md.h>) && __has_include(<mbedtls/aes.h>)
-#  define MESSAGE_CRYPTO_AVAILABLE 1
-#  include <mbedtls/md.h>
+#if __has_include(<mbedtls/aes.h>) && __has_include(<mbedtls/sha256.h>) && \
+    __has_include(<mbedtls/gcm.h>)
+#  define MESSAGE_CRYPTO_MBEDTLS 1
 #  include <mbedtls/aes.h>
+#  include <mbedtls/gcm.h>
 #  include <mbedtls/sha256.h>
 #else
-#  define MESSAGE_CRYPTO_AVAILABLE 0
+#  define MESSAGE_CRYPTO_MBEDTLS 0
+#  include "aes128.h"
+#  include "aes_gcm.h"
+#  include "sha256.h"
+#endif
+
+// The String API needs Arduino's String; host builds get the buffer API.
+#if __has_include(<Arduino.h>)
+#  define MESSAGE_CRYPTO_HAS_STRING 1
+#else
+#  define MESSAGE_CRYPTO_HAS_STRING 0
 #endif
 
 class MessageCrypto {
 public:
     explicit MessageCrypto(const char* device_pass);
+    ~MessageCrypto();
+
+    MessageCrypto(const MessageCrypto&) = delete;
+    MessageCrypto& operator=(const MessageCrypto&) = delete;
+
+    static constexpr uint8_t kV2Version  = 2;
+    static constexpr size_t  kV2Overhead = 1 + 4 + 16 + 32;
+    // Where the ciphertext starts in a v2 envelope. Plaintext written at
+    // out + kV2PayloadOffset is sealed in place.
+    static constexpr size_t  kV2PayloadOffset = 1 + 4 + 16;
+
+    static constexpr uint8_t kV3Version  = 3;
+    static constexpr size_t  kV3Overhead = 1 + 4 + 12 + 16;
+    static constexpr size_t  kV3PayloadOffset = 1 + 4 + 12;
+
+    // Largest v1 envelope for a len-byte payload, without the NUL.
+    static constexpr size_t v1EnvelopeSize(size_t len) {
+        return 10 + 1 + 2 * (16 + len) + 1 + 64;
+    }
 
+    // ── Buffer API (no heap) ──
+    // v1 "ts:enc:sig" into out, NUL-terminated. Returns its length, 0 on
+    // error or if out is smaller than v1EnvelopeSize(len) + 1.
+    size_t encryptEnvelope(const uint8_t* data, size_t len, char* out, size_t outSize);
+    // Decrypts a v1 or base64 v2/v3 envelope into out. An out buffer as large as
+    // the envelope is always enough.
+    bool   decryptEnvelope(const char* envelope, size_t len, uint8_t* out, size_t outSize,
+                           size_t& outLen);
+
+    // v2 into a caller buffer. Returns the envelope size, 0 on error or if
+    // out is smaller than len + kV2Overhead.
+    size_t sealV2(const uint8_t* data, size_t len, uint8_t* out, size_t outSize);
+    // Verifies and decrypts a binary v2 envelope into out (may alias env).
+    bool   openV2(const uint8_t* env, size_t len, uint8_t* out, size_t outSize, size_t& outLen);
+
+    // v3 (AES-GCM) counterparts, same buffer rules.
+    size_t sealV3(const uint8_t* data, size_t len, uint8_t* out, size_t outSize);
+    bool   openV3(const uint8_t* env, size_t len, uint8_t* out, size_t outSize, size_t& outLen);
+
+#if MESSAGE_CRYPTO_HAS_STRING
+    // ── String API (wrappers around the buffer API) ──
     // Encrypt plaintext -> "ts:enc:sig" envelope.  Returns "" on error.
     String encryptEnvelope(const String& plaintext);
+    // Same envelope around a binary payload (e.g. a telemetry_codec frame).
+    String encryptEnvelope(const uint8_t* data, size_t len);
 
-    // Decrypt "ts:enc:sig" -> plaintext.  Returns "" on HMAC failure or bad format.
+    // Decrypt a v1 "ts:enc:sig" or base64 v2/v3 envelope -> plaintext.
+    // Returns "" on HMAC failure or bad format.
     String decryptEnvelope(const String& envelope);
+#endif
 
 private:
-#if MESSAGE_CRYPTO_AVAILABLE
-    uint8_t aes_key_[16];
-    uint8_t hmac_key_[32];
+#if MESSAGE_CRYPTO_MBEDTLS
+    using AesState  = mbedtls_aes_context;
+    using GcmState  = mbedtls_gcm_context;
+    using HashState = mbedtls_sha256_context;
+#else
+    using AesState  = Aes128;
+    using GcmState  = AesGcm128;
+    using HashState = Sha256;
+#endif
+
+    mutable AesState aes_;  // expanded key, never changes after setup
+    mutable GcmState gcm_;  // v3 key schedule and GHASH tables
+    HashState hmac_inner_;  // state after absorbing key ^ ipad
+    HashState hmac_outer_;  // state after absorbing key ^ opad
+    bool    ready_ = false;
 
     void    deriveKeys(const char* password);
+    // Incremental HMAC: hmacStart, any number of hmacUpdate calls,
+    // hmacFinish (which releases ctx).
+    void    hmacStart (HashState& ctx) const;
+    static void hmacUpdate(HashState& ctx, const uint8_t* data, size_t len);
+    void    hmacFinish(HashState& ctx, uint8_t out32[32]) const;
     void    computeHmac(const uint8_t* data, size_t len, uint8_t out32[32]) const;
     bool    aesCtr(const uint8_t nonce16[16], uint8_t* buf, size_t len) const;
 
-    static String toHex  (const uint8_t* data, size_t len);
-    static bool   fromHex(const char* hex, uint8_t* out, size_t out_len);
-#endif
+    bool    decryptV1(const char* envelope, size_t len, uint8_t* out, size_t outSize,
+                      size_t& outLen);
+
+    static void toHex  (const uint8_t* data, size_t len, char* out);
+    static bool fromHex(const char* hex, size_t hexLen, uint8_t* out, size_t outLen);
 };
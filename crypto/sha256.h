@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Portable SHA-256 (FIPS 180-4). Copying a Sha256 clones its state, which is
+// how MessageCrypto resumes from the precomputed HMAC pad states.
+class Sha256 {
+public:
+    Sha256() { reset(); }
+
+    void reset();
+    void update(const uint8_t* data, size_t len);
+    // Writes the digest; call reset() before reusing the object.
+    void finish(uint8_t out[32]);
+
+private:
+    void compress(const uint8_t block[64]);
+
+    uint32_t state_[8];
+    uint64_t length_ = 0;  // bytes absorbed
+    uint8_t  buffer_[64];
+    size_t   buffered_ = 0;
+};
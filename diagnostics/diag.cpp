@@ -0,0 +1,45 @@
+#include "diag.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#if defined(DIAG_TOKENIZED)
+#include "../crypto/base64.h"
+#endif
+
+namespace diag {
+
+void logf(const char* format, ...) {
+#if DIAG_HAS_SERIAL
+    char line[kFormattedMaxChars];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Serial.println(line);
+#else
+    (void)format;
+#endif
+}
+
+#if defined(DIAG_TOKENIZED)
+void writeTokenized(const uint8_t* frame, size_t length) {
+#if DIAG_HAS_SERIAL
+    // '$' + unpadded base64 keeps frames on their own text line, so boot
+    // output and library prints can share the port.
+    char line[1 + base64::encodedSize(kTokenizedMaxBytes) + 2];
+    line[0] = '$';
+    size_t chars = base64::encode(frame, length, line + 1, sizeof(line) - 1);
+    while (chars > 0 && line[chars] == '=') {
+        --chars;
+    }
+    line[1 + chars] = '\n';
+    Serial.write(reinterpret_cast<const uint8_t*>(line), chars + 2);
+#else
+    (void)frame;
+    (void)length;
+#endif
+}
+#endif
+
+}  // namespace diag
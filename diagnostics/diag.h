@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "../prefferences.h"
 
@@ -58,4 +61,142 @@ inline void log(DiagLevel level, const char* tag, const char* message) {
 #endif
 }
 
+// ── Formatted logging ─────────────────────────────────────────
+// DIAG_LOGF(WARN, "HUB", "retry in %lums", ms) prints
+// "[WARN] [HUB] retry in 123ms". Built with -DDIAG_TOKENIZED, the format
+// string never reaches flash: it is hashed at compile time (FNV-1a) and the
+// line goes out as "$<base64(token u32 LE, args)>". Integers are zigzag
+// varints, floating point values 4-byte floats and strings a length byte
+// (bit 7: truncated) plus their bytes. scripts/gen_token_db.py builds the
+// token database from the sources and scripts/detokenize.py turns a serial
+// log back into text.
+
+constexpr uint32_t token(const char* text) {
+    uint32_t hash = 2166136261U;
+    for (; *text != '\0'; ++text) {
+        hash ^= static_cast<uint8_t>(*text);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+constexpr size_t kTokenizedMaxBytes = 96;
+constexpr size_t kFormattedMaxChars = 256;
+
+class TokenWriter {
+public:
+    TokenWriter(uint8_t* out, size_t size) : out_(out), size_(size) {}
+
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            put(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+    void varint(uint64_t value) {
+        while (value >= 0x80U) {
+            put(static_cast<uint8_t>(value | 0x80U));
+            value >>= 7;
+        }
+        put(static_cast<uint8_t>(value));
+    }
+    void zigzag(int64_t value) {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+    void f32(float value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+    void string(const char* text) {
+        if (text == nullptr) {
+            text = "";
+        }
+        size_t length = std::strlen(text);
+        // Always leave room for the length byte of later arguments.
+        const size_t room = length_ < size_ ? size_ - length_ - 1U : 0U;
+        uint8_t header = 0;
+        if (length > 0x7FU || length > room) {
+            length = room < 0x7FU ? room : 0x7FU;
+            header = 0x80U;
+        }
+        put(static_cast<uint8_t>(header | length));
+        for (size_t i = 0; i < length; ++i) {
+            put(static_cast<uint8_t>(text[i]));
+        }
+    }
+
+    template <typename T>
+    void arg(T value) {
+        if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) {
+            string(value);
+        } else if constexpr (std::is_floating_point<T>::value) {
+            f32(static_cast<float>(value));
+        } else if constexpr (std::is_enum<T>::value) {
+            zigzag(static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral<T>::value) {
+            zigzag(static_cast<int64_t>(value));
+        } else if constexpr (std::is_pointer<T>::value) {
+            varint(reinterpret_cast<uintptr_t>(value));
+        } else {
+            static_assert(std::is_pointer<T>::value, "unsupported DIAG_LOGF argument");
+        }
+    }
+
+    size_t size() const { return length_ < size_ ? length_ : size_; }
+    bool truncated() const { return length_ > size_; }
+
+private:
+    void put(uint8_t byte) {
+        if (length_ < size_) {
+            out_[length_] = byte;
+        }
+        ++length_;
+    }
+
+    uint8_t* out_;
+    size_t size_;
+    size_t length_ = 0;
+};
+
+// Token followed by the encoded arguments; returns the byte count (arguments
+// that do not fit are cut off).
+template <typename... Args>
+size_t encodeTokenized(uint8_t* out, size_t size, uint32_t tokenValue, Args... args) {
+    TokenWriter writer(out, size);
+    writer.u32(tokenValue);
+    (writer.arg(args), ...);
+    return writer.size();
+}
+
+// Sends one "$<base64>\n" frame (diag.cpp, DIAG_TOKENIZED builds only).
+void writeTokenized(const uint8_t* frame, size_t length);
+
+template <typename... Args>
+void logTokenized(uint32_t tokenValue, Args... args) {
+    uint8_t frame[kTokenizedMaxBytes];
+    writeTokenized(frame, encodeTokenized(frame, sizeof(frame), tokenValue, args...));
+}
+
+// Text fallback: formats and prints format + "\n".
+void logf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
 }  // namespace diag
+
+#if defined(DIAG_TOKENIZED)
+#define DIAG_EMIT_(text, ...)                                      \
+    do {                                                           \
+        constexpr uint32_t kDiagToken_ = ::diag::token(text);      \
+        ::diag::logTokenized(kDiagToken_, ##__VA_ARGS__);          \
+    } while (0)
+#else
+#define DIAG_EMIT_(text, ...) ::diag::logf(text, ##__VA_ARGS__)
+#endif
+
+// level is a DiagLevel name (ERROR, WARN, INFO, DEBUG); tag and format must
+// be string literals.
+#define DIAG_LOGF(level, tag, format, ...)                                     \
+    do {                                                                       \
+        if (::diag::enabled(DiagLevel::level)) {                               \
+            DIAG_EMIT_("[" #level "] [" tag "] " format, ##__VA_ARGS__);       \
+        }                                                                      \
+    } while (0)
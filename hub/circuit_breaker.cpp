@@ -0,0 +1,86 @@
+#include "circuit_breaker.h"
+
+CircuitBreaker::CircuitBreaker() = default;
+
+CircuitBreaker::CircuitBreaker(const Config& config) : config_(config) {}
+
+bool CircuitBreaker::allowRequest(uint32_t nowMs) {
+    switch (state_) {
+    case State::CLOSED:
+        return true;
+    case State::OPEN:
+        if (static_cast<int32_t>(nowMs - retryAtMs_) < 0) {
+            return false;
+        }
+        state_ = State::HALF_OPEN;
+        ++retries_;
+        ++outageRetries_;
+        return true;
+    case State::HALF_OPEN:
+    default:
+        return false;  // the probe is still out
+    }
+}
+
+void CircuitBreaker::recordSuccess() {
+    state_               = State::CLOSED;
+    consecutiveFailures_ = 0;
+    backoffMs_           = 0;
+    outageRetries_       = 0;
+}
+
+void CircuitBreaker::recordFailure(uint32_t nowMs) {
+    ++consecutiveFailures_;
+    if (state_ == State::HALF_OPEN ||
+        (state_ == State::CLOSED && consecutiveFailures_ >= config_.failureThreshold)) {
+        open(nowMs);
+    }
+}
+
+void CircuitBreaker::cancelProbe() {
+    if (state_ != State::HALF_OPEN) {
+        return;
+    }
+    state_ = State::OPEN;  // retryAtMs_ has passed already
+    --retries_;
+    --outageRetries_;
+}
+
+uint32_t CircuitBreaker::retryInMs(uint32_t nowMs) const {
+    if (state_ != State::OPEN || static_cast<int32_t>(retryAtMs_ - nowMs) <= 0) {
+        return 0;
+    }
+    return retryAtMs_ - nowMs;
+}
+
+const char* CircuitBreaker::stateName(State state) {
+    switch (state) {
+        case State::CLOSED:    return "closed";
+        case State::OPEN:      return "open";
+        case State::HALF_OPEN: return "half_open";
+        default:               return "?";
+    }
+}
+
+void CircuitBreaker::open(uint32_t nowMs) {
+    if (state_ == State::CLOSED) {
+        ++trips_;
+    }
+    if (backoffMs_ == 0) {
+        backoffMs_ = config_.baseBackoffMs;
+    } else {
+        backoffMs_ = backoffMs_ >= config_.maxBackoffMs / 2 ? config_.maxBackoffMs : backoffMs_ * 2;
+    }
+    const uint32_t half = backoffMs_ / 2;
+    const uint32_t wait = half + (half ? nextRandom() % (half + 1) : 0);
+    state_     = State::OPEN;
+    retryAtMs_ = nowMs + wait;
+}
+
+uint32_t CircuitBreaker::nextRandom() {
+    // xorshift32: plenty for spreading retries, and the same on every target.
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return rng_;
+}
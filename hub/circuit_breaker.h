@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-endpoint circuit breaker with jittered exponential backoff.
+//
+// CLOSED: requests flow. failureThreshold consecutive failures open it.
+// OPEN: requests are refused until the backoff runs out, then one probe is
+// let through (HALF_OPEN). A successful probe closes the breaker; a failed one
+// reopens it with twice the backoff, up to maxBackoffMs.
+//
+// Each wait is drawn from [backoff / 2, backoff] ("equal jitter"), so devices
+// that lost the hub at the same moment come back spread out instead of all at
+// once. Seed every device differently.
+class CircuitBreaker {
+public:
+    enum class State : uint8_t {
+        CLOSED = 0,
+        OPEN,
+        HALF_OPEN,
+    };
+
+    struct Config {
+        uint8_t  failureThreshold = 3;
+        uint32_t baseBackoffMs    = 1000U;
+        uint32_t maxBackoffMs     = 60000U;
+    };
+
+    CircuitBreaker();
+    explicit CircuitBreaker(const Config& config);
+
+    void seed(uint32_t seed) { rng_ = seed ? seed : 0x9E3779B9U; }
+
+    // True if a request may go out now. The OPEN -> HALF_OPEN transition
+    // happens here, and only the first caller after the backoff gets true.
+    bool allowRequest(uint32_t nowMs);
+    void recordSuccess();
+    void recordFailure(uint32_t nowMs);
+    // For a caller that got the probe but sent nothing: back to OPEN, and the
+    // next allowRequest() probes again. Without it the breaker would wait
+    // for a result that never comes.
+    void cancelProbe();
+
+    State    state() const               { return state_; }
+    uint32_t consecutiveFailures() const { return consecutiveFailures_; }
+    // Times the breaker opened, and half-open probes sent, since boot.
+    uint32_t trips() const               { return trips_; }
+    uint32_t retries() const             { return retries_; }
+    // Probes sent since the breaker last closed.
+    uint32_t outageRetries() const       { return outageRetries_; }
+    uint32_t retryInMs(uint32_t nowMs) const;
+
+    static const char* stateName(State state);
+
+private:
+    void open(uint32_t nowMs);
+    uint32_t nextRandom();
+
+    Config   config_{};
+    State    state_               = State::CLOSED;
+    uint32_t consecutiveFailures_ = 0;
+    uint32_t backoffMs_           = 0;  // 0 until the first open of an outage
+    uint32_t retryAtMs_           = 0;
+    uint32_t trips_               = 0;
+    uint32_t retries_             = 0;
+    uint32_t outageRetries_       = 0;
+    uint32_t rng_                 = 0x9E3779B9U;
+};
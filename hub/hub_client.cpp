@@ -2,7 +2,11 @@
 
 #include "../diagnostics/diag.h"
 #include "../prefferences.h"
+#include "hub_messages.h"
+#include "schedule_codec.h"
+#include "telemetry_codec.h"
 
+#include <cstdarg>
 #include <cstring>
 #include <cstdio>
 
@@ -19,292 +23,852 @@
 #define HUBCLIENT_HAS_HTTP 0
 #endif
 
-HubClient::HubClient(HubReceiver& receiver, Logger& logger)
-    : receiver_(receiver), logger_(logger), crypto_(DEVICE_PASS) {}
+namespace {
+// snprintf that appends at `len`; len keeps growing past size on overflow so
+// the caller can detect truncation with a single check at the end.
+void appendf(char* buf, size_t size, size_t& len, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int n = len < size ? vsnprintf(buf + len, size - len, fmt, args) : 0;
+    va_end(args);
+    if (n > 0) {
+        len += static_cast<size_t>(n);
+    } else if (len < size && n < 0) {
+        len = size;
+    }
+}
+
+CircuitBreaker::Config breakerConfig() {
+    CircuitBreaker::Config config;
+    config.failureThreshold = kHubBreakerFailureThreshold;
+    config.baseBackoffMs    = kHubBackoffBaseMs;
+    config.maxBackoffMs     = kHubBackoffMaxMs;
+    return config;
+}
+
+// Different on every device so a fleet that lost the hub together does not
+// retry in step.
+uint32_t breakerSeed(uint32_t salt) {
+    uint32_t hash = 2166136261U;
+    for (const char* p = DEVICE_ID; *p; ++p) {
+        hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619U;
+    }
+#if HUBCLIENT_HAS_HTTP
+    const uint64_t mac = ESP.getEfuseMac();
+    hash ^= static_cast<uint32_t>(mac) ^ static_cast<uint32_t>(mac >> 32) ^ micros();
+#endif
+    return hash ^ (salt * 0x9E3779B9U);
+}
+
+// Any HTTP answer means the hub is up; only transport and server errors
+// count against a breaker.
+bool hubFailed(int httpCode) {
+    return httpCode <= 0 || httpCode >= 500;
+}
+}  // namespace
+
+HubClient::HubClient(HubLink& link, Logger& logger)
+    : link_(link), logger_(logger), crypto_(DEVICE_PASS),
+      commandBreaker_(breakerConfig()), telemetryBreaker_(breakerConfig()) {
+    commandBreaker_.seed(breakerSeed(1));
+    telemetryBreaker_.seed(breakerSeed(2));
+}
+
+void HubClient::service(uint32_t nowMs) {
+    // IR learn listening: stay off the radio entirely.
+    if (link_.suspended()) {
+        return;
+    }
+
+    TelemetrySample sample;
+    while (link_.popTelemetry(sample)) {
+        queueTelemetry(sample);
+    }
+    if (link_.takeUploadRequest()) {
+        lastTelemetryPostMs_ = nowMs - kHubTelemetryIntervalMs;
+    }
+
+    tick(nowMs, link_.wifiConnected());
+    link_.setHubReachable(hubReachable_);
+}
+
+void HubClient::queueTelemetry(const TelemetrySample& sample) {
+    // A sample still waiting for the upload gate is replaced by a newer one;
+    // while a backlog is queued new samples join it, so the hub always
+    // receives them in order.
+    if (!telemetryRing_.empty()) {
+        telemetryRing_.push(sample);
+        return;
+    }
+    pendingTelemetry_    = sample;
+    hasPendingTelemetry_ = true;
+}
+
+void HubClient::tick(uint32_t nowMs, bool wifiConnected) {
+    // An expired deadline only needs to go stale; due() checks for that.
+    TimerExpiry expired;
+    while (timers_.poll(nowMs, expired)) {
+    }
 
-void HubClient::tick(uint32_t nowMs,
-                     const WallClockSnapshot& wallNow,
-                     bool wifiConnected) {
     if (!wifiConnected) {
         hubReachable_ = false;
         return;
     }
 
-    if (nowMs - lastCommandPollMs_ >= kHubCommandPollIntervalMs) {
-        lastCommandPollMs_ = nowMs;
-        pollCommand(wallNow);
+    if (kHubCommandPushEnabled && !pushAvailable_ && due(kPushRetry)) {
+        pushAvailable_ = true;
+    }
+
+    if (kHubCommandPushEnabled && pushAvailable_) {
+        serviceCommandPush(nowMs);
+    } else if (due(kCommandPoll)) {
+        defer(kCommandPoll, nowMs, kHubCommandPollIntervalMs);
+        if (admit(commandBreaker_, nowMs)) {
+            pollCommand(nowMs);
+        }
     }
 
-    if (hasPendingTelemetry_ &&
-        nowMs - lastTelemetryPostMs_ >= kHubTelemetryIntervalMs) {
+    const bool useSync      = kHubSyncEnabled && syncAvailable_;
+    const uint32_t sincePost = nowMs - lastTelemetryPostMs_;
+    const bool telemetryDue = hasPendingTelemetry_ && sincePost >= kHubTelemetryIntervalMs;
+    const bool logsDue      = useSync && logger_.totalLogged() != logCursor_ &&
+                              sincePost >= kHubLogSyncIntervalMs;
+    if (telemetryDue || logsDue) {
         lastTelemetryPostMs_ = nowMs;
-        postTelemetry(wallNow);
+        // An open breaker parks the sample in the ring without touching the
+        // network; it goes up with the backlog once the hub is back.
+        bool delivered = false;
+        if (admit(telemetryBreaker_, nowMs)) {
+            if (useSync) {
+                delivered = syncWithHub(nowMs);
+            } else if (hasPendingTelemetry_) {
+                delivered = postTelemetry(nowMs);
+            }
+        }
+        if (hasPendingTelemetry_ && !delivered) {
+            telemetryRing_.push(pendingTelemetry_);
+        }
         hasPendingTelemetry_ = false;
     }
-}
 
-void HubClient::submitTelemetry(const Telemetry& telemetry) {
-    pendingTelemetry_    = telemetry;
-    hasPendingTelemetry_ = true;
-}
+    if (hubReachable_ && !telemetryRing_.empty() && due(kBacklogDrain) &&
+        admit(telemetryBreaker_, nowMs)) {
+        drainTelemetryBacklog(nowMs);
+    }
 
-bool HubClient::hubReachable() const {
-    return hubReachable_;
+    if (scheduleFetchRequested_) {
+        scheduleFetchRequested_ = false;
+        timers_.cancel(deadlines_[kScheduleFetch]);
+    }
+    if (kHubScheduleSyncEnabled && hubReachable_ && due(kScheduleFetch) &&
+        admit(telemetryBreaker_, nowMs)) {
+        fetchSchedule(nowMs);
+    }
+
+    logStats(nowMs);
 }
 
-void HubClient::pollCommand(const WallClockSnapshot& wallNow) {
+void HubClient::pollCommand(uint32_t nowMs) {
 #if HUBCLIENT_HAS_HTTP
-    HTTPClient http;
-    http.setConnectTimeout(kHubHttpTimeoutMs);
-    http.setTimeout(kHubHttpTimeoutMs);
-
-    char url[128] = {0};
-    snprintf(url, sizeof(url), "http://%s:%d/api/command/pending", kHubHost, kHubPort);
-
-    if (!http.begin(url)) {
+    String raw;
+    const int httpCode = exchange("/api/command/pending", nullptr, 0, envelopeVersion_, raw,
+                                  pollStats_);
+    recordResult(commandBreaker_, httpCode, nowMs);
+    if (httpCode != 200) {
         hubReachable_ = false;
-        diag::log(DiagLevel::WARN, "HUB", "command poll: begin() failed");
+        DIAG_LOGF(WARN, "HUB", "command poll: non-200 response");
         return;
     }
 
-    http.addHeader("X-Device-ID", DEVICE_ID);
-    http.addHeader("X-Encrypted", "1");
-    const int httpCode = http.GET();
-    if (httpCode != 200) {
-        http.end();
+    hubReachable_ = true;
+    handleCommandPayload(raw.c_str(), raw.length());
+#else
+    (void)nowMs;
+#endif
+}
+
+void HubClient::serviceCommandPush(uint32_t nowMs) {
+    switch (longPoll_.poll(nowMs)) {
+    case HubLongPoll::State::IDLE: {
+        if (!admit(commandBreaker_, nowMs)) {
+            break;
+        }
+        char path[48] = {0};
+        snprintf(path, sizeof(path), "/api/command/pending?wait=%lu",
+                 static_cast<unsigned long>(kHubLongPollHoldS));
+        pollStats_.begin(false);
+        longPoll_.setEnvelopeVersion(envelopeVersion_);
+        if (!longPoll_.start(path, nowMs, kHubLongPollHoldS * 1000U)) {
+            // Hub down, not push unsupported: the breaker backs off instead
+            // of switching to polling.
+            pollStats_.fail();
+            hubReachable_ = false;
+            recordResult(commandBreaker_, -1, nowMs);
+        }
+        break;
+    }
+    case HubLongPoll::State::WAITING:
+        break;
+    case HubLongPoll::State::DONE:
+        if (longPoll_.status() == 404 || longPoll_.status() == 405) {
+            // Hub without the endpoint: push unsupported.
+            recordResult(commandBreaker_, longPoll_.status(), nowMs);
+            pollStats_.fail();
+            longPoll_.reset();
+            fallBackToPolling(nowMs, "no long-poll endpoint");
+            break;
+        }
+        if (longPoll_.status() != 200) {
+            // Any other error is the hub in trouble: the breaker backs off and
+            // the next hold goes out after it. Counted as a transport failure
+            // so a 4xx cannot re-poll on every tick.
+            recordResult(commandBreaker_, -1, nowMs);
+            pollStats_.fail();
+            hubReachable_ = false;
+            longPoll_.reset();
+            break;
+        }
+        recordResult(commandBreaker_, 200, nowMs);
+        hubReachable_ = true;
+        if (!longPoll_.serverHeld()) {
+            // Old hub: it answered at once, so holding is not supported.
+            fallBackToPolling(nowMs, "hub does not hold requests");
+        }
+        handleCommandPayload(longPoll_.body(), longPoll_.bodyLength());
+        longPoll_.reset();
+        break;
+    case HubLongPoll::State::FAILED:
+        pollStats_.fail();
         hubReachable_ = false;
-        diag::log(DiagLevel::WARN, "HUB", "command poll: non-200 response");
-        return;
+        longPoll_.reset();
+        recordResult(commandBreaker_, -1, nowMs);
+        break;
     }
+}
 
-    hubReachable_ = true;
-    const String raw = http.getString();
-    http.end();
+void HubClient::fallBackToPolling(uint32_t nowMs, const char* reason) {
+    pushAvailable_       = false;
+    defer(kPushRetry, nowMs, kHubPushRetryMs);
+    longPoll_.close();
+    DIAG_LOGF(WARN, "HUB", "Command push unavailable (%s), polling every %lums",
+              reason, static_cast<unsigned long>(kHubCommandPollIntervalMs));
+}
 
-    // Decrypt hub response; fall back to raw if it looks like plain JSON
-    const String payload = (raw.length() > 0 && raw[0] != '{')
-                           ? crypto_.decryptEnvelope(raw)
-                           : raw;
+void HubClient::handleCommandPayload(const char* raw, size_t rawLen) {
+#if HUBCLIENT_HAS_HTTP
+    size_t payloadLen = 0;
+    const char* payload = openResponse(raw, rawLen, payloadLen);
 
     // Log successful poll
     static bool firstPoll = true;
     if (firstPoll) {
         firstPoll = false;
-        Serial.println("[HUB] Connected to hub successfully!");
+        DIAG_LOGF(INFO, "HUB", "Connected to hub successfully!");
     }
 
-    char cmdStr[32] = {0};
-    if (!extractJsonString(payload, "command", cmdStr, sizeof(cmdStr))) {
+    HubCommandMessage message;
+    if (!parseHubCommand(payload, payloadLen, message)) {
+        DIAG_LOGF(WARN, "HUB", "command poll: malformed response");
         return;
     }
-    if (cmdStr[0] == '\0' || strcmp(cmdStr, "null") == 0) {
+    if (message.syncRequested) {
+        link_.requestKeyframe();
+        scheduleFetchRequested_ = true;  // cheap: unchanged is a bare 304
+    }
+    handleCommand(message);
+#else
+    (void)raw;
+    (void)rawLen;
+#endif
+}
+
+const char* HubClient::openResponse(const char* raw, size_t rawLen, size_t& outLen) {
+    // Decrypt hub response; fall back to raw if it looks like plain JSON
+    outLen = rawLen;
+    if (rawLen == 0 || raw[0] == '{') {
+        return raw;
+    }
+    uint8_t* plain = envelopeBuf_;
+    if (!crypto_.decryptEnvelope(raw, rawLen, plain, sizeof(envelopeBuf_) - 1, outLen)) {
+        outLen = 0;
+    }
+    plain[outLen] = '\0';
+    return reinterpret_cast<const char*>(plain);
+}
+
+void HubClient::handleCommand(const HubCommandMessage& message) {
+#if HUBCLIENT_HAS_HTTP
+    if (!message.hasCommand || message.command[0] == '\0') {
         return;
     }
+    const char* cmdStr = message.command;
 
     // Custom IR: hub resolved a custom button into raw IR data
     if (strcmp(cmdStr, "send_ir") == 0) {
-        int protocol = 0, address = 0, irCommand = 0;
-        if (extractJsonInt(payload, "protocol", protocol) &&
-            extractJsonInt(payload, "address", address) &&
-            extractJsonInt(payload, "ir_command", irCommand)) {
-            pendingCustomIr_.protocol = static_cast<uint8_t>(protocol);
-            pendingCustomIr_.address  = static_cast<uint16_t>(address);
-            pendingCustomIr_.command  = static_cast<uint16_t>(irCommand);
-            pendingCustomIr_.valid    = true;
-            pendingCustomIr_.name[0]  = '\0';
-            extractJsonString(payload, "name",
-                              pendingCustomIr_.name, sizeof(pendingCustomIr_.name));
-            Serial.printf("[HUB] ✓ Custom IR queued: \"%s\" proto=%d addr=0x%04X cmd=0x%04X\n",
-                          pendingCustomIr_.name[0] ? pendingCustomIr_.name : "?",
-                          protocol, address, irCommand);
+        if (message.hasIr) {
+            HubEvent event;
+            event.kind       = HubEvent::Kind::CUSTOM_IR;
+            event.irProtocol = static_cast<uint8_t>(message.protocol);
+            event.irAddress  = static_cast<uint16_t>(message.address);
+            event.irCommand  = static_cast<uint16_t>(message.irCommand);
+            strncpy(event.irName, message.name, sizeof(event.irName) - 1);
+            link_.postEvent(event);
+            DIAG_LOGF(INFO, "HUB", "✓ Custom IR queued: \"%s\" proto=%d addr=0x%04X cmd=0x%04X",
+                      event.irName[0] ? event.irName : "?",
+                      static_cast<int>(message.protocol),
+                      static_cast<unsigned>(message.address),
+                      static_cast<unsigned>(message.irCommand));
         }
         return;
     }
 
     const Command cmd = parseCommandString(cmdStr);
     if (cmd == Command::NONE) {
-        diag::log(DiagLevel::WARN, "HUB", "command poll: unrecognised command");
+        DIAG_LOGF(WARN, "HUB", "command poll: unrecognised command");
         return;
     }
 
-    logger_.log(wallNow, LogEventType::HUB_COMMAND_RX, cmd, true);
+    DIAG_LOGF(INFO, "HUB", "✓ Command received and queued: %s", cmdStr);
+
+    HubEvent event;
+    event.kind    = HubEvent::Kind::COMMAND;
+    event.command = cmd;
+    link_.postEvent(event);
+#else
+    (void)message;
+#endif
+}
 
-    Serial.print("[HUB] ✓ Command received and queued: ");
-    Serial.println(cmdStr);
+int HubClient::formatTelemetry(const TelemetrySample& sample, char* out, size_t size) {
+    return snprintf(out, size,
+        "{\"room_temp\":%.1f,\"target_temp\":%.1f,\"power\":%s,"
+        "\"mode\":\"%s\",\"pid_p\":%.2f,\"pid_i\":%.3f,"
+        "\"pid_d\":%.2f,\"pid_steps\":%d,\"integral\":%.3f}",
+        sample.roomTempC,
+        sample.targetTempC,
+        sample.powerOn ? "true" : "false",
+        sample.ecoMode ? "ECO" : "FAST",
+        sample.pidP,
+        sample.pidI,
+        sample.pidD,
+        static_cast<int>(sample.pidSteps),
+        sample.integral
+    );
+}
 
-    if (!receiver_.push(cmd)) {
-        diag::log(DiagLevel::WARN, "HUB", "command poll: queue full, dropped");
-        logger_.log(wallNow, LogEventType::COMMAND_DROPPED, cmd, false);
+bool HubClient::postTelemetry(uint32_t nowMs) {
+#if HUBCLIENT_HAS_HTTP
+    uint8_t frame[telemetry_codec::kHeaderSize + telemetry_codec::kSampleSize];
+    char body[256] = {0};
+    const uint8_t* plain = frame;
+    size_t plainLen = 0;
+    const char* format = nullptr;
+    if (binaryTelemetry_) {
+        telemetry_codec::FrameWriter writer(frame, sizeof(frame));
+        writer.addSample(pendingTelemetry_, nowMs);
+        plainLen = writer.finish();
+        format   = telemetry_codec::kFormatName;
+    } else {
+        formatTelemetry(pendingTelemetry_, body, sizeof(body));
+        plain    = reinterpret_cast<const uint8_t*>(body);
+        plainLen = strlen(body);
+    }
+
+    String encResponse;
+    const int httpCode = post("/api/telemetry", plain, plainLen, encResponse, telemetryStats_, format);
+    recordResult(telemetryBreaker_, httpCode, nowMs);
+    if (httpCode != 200) {
+        hubReachable_ = false;
+        return false;
+    }
+
+    hubReachable_ = true;
+
+    size_t responseLen = 0;
+    const char* response = openResponse(encResponse.c_str(), encResponse.length(), responseLen);
+    HubResponseMessage message;
+    if (!parseHubResponse(response, responseLen, message)) {
+        DIAG_LOGF(WARN, "HUB", "telemetry: malformed response");
     }
+    applyHubConfig(message);
+    return true;
 #else
-    (void)wallNow;
+    (void)nowMs;
+    return false;
 #endif
 }
 
-void HubClient::postTelemetry(const WallClockSnapshot& wallNow) {
+bool HubClient::syncWithHub(uint32_t nowMs) {
 #if HUBCLIENT_HAS_HTTP
-    HTTPClient http;
-    http.setConnectTimeout(kHubHttpTimeoutMs);
-    http.setTimeout(kHubHttpTimeoutMs);
-
-    char url[128] = {0};
-    snprintf(url, sizeof(url), "http://%s:%d/api/telemetry", kHubHost, kHubPort);
+    static_assert(telemetry_codec::kHeaderSize + telemetry_codec::kSampleSize +
+                      kHubSyncMaxLogEntries * telemetry_codec::kLogSize <= kRequestBufSize &&
+                  kSyncBodySize <= kRequestBufSize,
+                  "a sync request must fit requestBuf_");
+    uint32_t firstSeq = 0;
+    const size_t logCount = logger_.copySince(logCursor_, syncLogs_, kHubSyncMaxLogEntries, firstSeq);
+
+    // {"telemetry":{...},"logs":[[seq,type,cmd,ok,detail,unixMs,bootMs],...]}
+    const uint8_t* plain = reinterpret_cast<const uint8_t*>(requestBuf_);
+    size_t plainLen = 0;
+    const char* format = nullptr;
+    if (binaryTelemetry_) {
+        telemetry_codec::FrameWriter writer(reinterpret_cast<uint8_t*>(requestBuf_),
+                                            sizeof(requestBuf_));
+        if (hasPendingTelemetry_) {
+            writer.addSample(pendingTelemetry_, nowMs);
+        }
+        for (size_t i = 0; i < logCount; ++i) {
+            writer.addLog(firstSeq + static_cast<uint32_t>(i), syncLogs_[i]);
+        }
+        plainLen = writer.finish();
+        format   = telemetry_codec::kFormatName;
+    } else {
+        size_t len = 0;
+        appendf(requestBuf_, sizeof(requestBuf_), len, "{");
+        if (hasPendingTelemetry_) {
+            appendf(requestBuf_, sizeof(requestBuf_), len, "\"telemetry\":");
+            if (len < sizeof(requestBuf_)) {
+                const int n = formatTelemetry(pendingTelemetry_, requestBuf_ + len,
+                                              sizeof(requestBuf_) - len);
+                len += n > 0 ? static_cast<size_t>(n) : 0;
+            }
+            appendf(requestBuf_, sizeof(requestBuf_), len, ",");
+        }
+        appendf(requestBuf_, sizeof(requestBuf_), len, "\"logs\":[");
+        for (size_t i = 0; i < logCount; ++i) {
+            const LogEntry& e = syncLogs_[i];
+            appendf(requestBuf_, sizeof(requestBuf_), len, "%s[%lu,%u,%u,%u,%u,%llu,%lu]",
+                    i ? "," : "",
+                    static_cast<unsigned long>(firstSeq + i),
+                    static_cast<unsigned>(e.type),
+                    static_cast<unsigned>(e.command),
+                    e.success ? 1U : 0U,
+                    static_cast<unsigned>(e.detailCode),
+                    static_cast<unsigned long long>(e.wallTimeValid ? e.unixMs : 0ULL),
+                    static_cast<unsigned long>(e.uptimeMs));
+        }
+        appendf(requestBuf_, sizeof(requestBuf_), len, "]}");
+        if (len >= sizeof(requestBuf_)) {
+            DIAG_LOGF(WARN, "HUB", "sync: body truncated");
+            telemetryBreaker_.cancelProbe();
+            return false;
+        }
+        plainLen = len;
+    }
 
-    if (!http.begin(url)) {
+    String encResponse;
+    const int httpCode = post("/api/sync", plain, plainLen, encResponse, telemetryStats_, format);
+    recordResult(telemetryBreaker_, httpCode, nowMs);
+    if (httpCode == 404) {
+        // Hub predates /api/sync — stay on the separate endpoints.
+        syncAvailable_ = false;
+        DIAG_LOGF(INFO, "HUB", "Hub has no /api/sync, using /api/telemetry");
+        return hasPendingTelemetry_ && postTelemetry(nowMs);
+    }
+    if (httpCode != 200) {
         hubReachable_ = false;
-        return;
+        return false;
     }
 
-    char body[256] = {0};
-    snprintf(body, sizeof(body),
-        "{\"room_temp\":%.1f,\"target_temp\":%.1f,\"power\":%s,"
-        "\"mode\":\"%s\",\"pid_p\":%.2f,\"pid_i\":%.3f,"
-        "\"pid_d\":%.2f,\"pid_steps\":%d,\"integral\":%.3f}",
-        pendingTelemetry_.roomTempC,
-        pendingTelemetry_.targetTempC,
-        pendingTelemetry_.powerOn ? "true" : "false",
-        pendingTelemetry_.mode ? pendingTelemetry_.mode : "FAST",
-        pendingTelemetry_.pidP,
-        pendingTelemetry_.pidI,
-        pendingTelemetry_.pidD,
-        static_cast<int>(pendingTelemetry_.pidSteps),
-        pendingTelemetry_.integral
-    );
+    hubReachable_ = true;
+    logCursor_    = firstSeq + static_cast<uint32_t>(logCount);
 
-    const String envelope = crypto_.encryptEnvelope(String(body));
-    http.addHeader("Content-Type", "application/x-encrypted");
-    http.addHeader("X-Device-ID", DEVICE_ID);
-    http.addHeader("Authorization", DEVICE_PASS);
-    const int httpCode = http.POST(envelope);
+    size_t responseLen = 0;
+    const char* response = openResponse(encResponse.c_str(), encResponse.length(), responseLen);
+    HubResponseMessage message;
+    if (!parseHubResponse(response, responseLen, message)) {
+        DIAG_LOGF(WARN, "HUB", "sync: malformed response");
+    }
+    applyHubConfig(message);
+    for (uint8_t i = 0; i < message.commandCount; ++i) {
+        handleCommand(message.commands[i]);
+    }
+    return true;
+#else
+    (void)nowMs;
+    return false;
+#endif
+}
 
+void HubClient::drainTelemetryBacklog(uint32_t nowMs) {
+#if HUBCLIENT_HAS_HTTP
+    static_assert(telemetry_codec::kHeaderSize +
+                      kHubTelemetryBatchSize * telemetry_codec::kSampleSize <= kRequestBufSize,
+                  "a telemetry batch must fit requestBuf_");
+    const size_t count = telemetryRing_.peek(batchSamples_, kHubTelemetryBatchSize);
+    if (count == 0) {
+        // Unreadable spill blocks were all the ring held.
+        telemetryBreaker_.cancelProbe();
+        return;
+    }
+
+    // {"samples":[{"ts":unixMs,...}|{"age_ms":ms,...},...]}
+    const uint8_t* plain = reinterpret_cast<const uint8_t*>(requestBuf_);
+    size_t plainLen = 0;
+    const char* format = nullptr;
+    if (binaryTelemetry_) {
+        telemetry_codec::FrameWriter writer(reinterpret_cast<uint8_t*>(requestBuf_),
+                                            sizeof(requestBuf_));
+        for (size_t i = 0; i < count; ++i) {
+            writer.addSample(batchSamples_[i], nowMs);
+        }
+        plainLen = writer.finish();
+        format   = telemetry_codec::kFormatName;
+    } else {
+        size_t len = 0;
+        appendf(requestBuf_, sizeof(requestBuf_), len, "{\"samples\":[");
+        for (size_t i = 0; i < count; ++i) {
+            const TelemetrySample& sample = batchSamples_[i];
+            formatTelemetry(sample, sampleFields_, sizeof(sampleFields_));
+            if (sample.unixMs != 0) {
+                appendf(requestBuf_, sizeof(requestBuf_), len, "%s{\"ts\":%llu,%s", i ? "," : "",
+                        static_cast<unsigned long long>(sample.unixMs), sampleFields_ + 1);
+            } else {
+                appendf(requestBuf_, sizeof(requestBuf_), len, "%s{\"age_ms\":%lu,%s", i ? "," : "",
+                        static_cast<unsigned long>(nowMs - sample.bootMs), sampleFields_ + 1);
+            }
+        }
+        appendf(requestBuf_, sizeof(requestBuf_), len, "]}");
+        if (len >= sizeof(requestBuf_)) {
+            DIAG_LOGF(WARN, "HUB", "telemetry batch: body truncated");
+            telemetryBreaker_.cancelProbe();
+            return;
+        }
+        plainLen = len;
+    }
+
+    String encResponse;
+    const int httpCode = post("/api/telemetry/batch", plain, plainLen, encResponse,
+                              telemetryStats_, format);
+    recordResult(telemetryBreaker_, httpCode, nowMs);
     if (httpCode != 200) {
-        http.end();
-        hubReachable_ = false;
+        // Old hub (404) or a hiccup: keep the samples and try again later.
+        defer(kBacklogDrain, nowMs, kHubPushRetryMs);
+        if (httpCode <= 0) {
+            hubReachable_ = false;
+        }
         return;
     }
 
-    hubReachable_ = true;
-    const String encResponse = http.getString();
-    http.end();
+    size_t responseLen = 0;
+    const char* response = openResponse(encResponse.c_str(), encResponse.length(), responseLen);
+    HubResponseMessage message;
+    parseHubResponse(response, responseLen, message);
+    int32_t accepted = message.hasAccepted ? message.accepted : 0;
+    const int32_t retryAfterMs = message.retryAfterMs;
+    if (accepted > static_cast<int32_t>(count)) accepted = static_cast<int32_t>(count);
+    if (accepted > 0) {
+        telemetryRing_.pop(static_cast<size_t>(accepted));
+    }
 
-    // Decrypt hub response; fall back to raw if it looks like plain JSON
-    const String response = (encResponse.length() > 0 && encResponse[0] != '{')
-                            ? crypto_.decryptEnvelope(encResponse)
-                            : encResponse;
+    const uint32_t waitMs = retryAfterMs > static_cast<int32_t>(kHubTelemetryBatchIntervalMs)
+                            ? static_cast<uint32_t>(retryAfterMs)
+                            : kHubTelemetryBatchIntervalMs;
+    defer(kBacklogDrain, nowMs, waitMs);
+    DIAG_LOGF(INFO, "HUB", "Backlog: sent %ld, %lu left (dropped %lu)", static_cast<long>(accepted),
+              static_cast<unsigned long>(telemetryRing_.size()),
+              static_cast<unsigned long>(telemetryRing_.dropped()));
+#else
+    (void)nowMs;
+#endif
+}
+
+bool HubClient::beginScheduleCache(const char* storageNamespace) {
+    return scheduleSync_.begin(storageNamespace);
+}
+
+void HubClient::fetchSchedule(uint32_t nowMs) {
+#if HUBCLIENT_HAS_HTTP
+    defer(kScheduleFetch, nowMs, kHubScheduleRetryMs);
+
+    char path[40] = {0};
+    snprintf(path, sizeof(path), "/api/schedule?format=%s", schedule_codec::kFormatName);
+    String raw;
+    const int httpCode = exchange(path, nullptr, 0, envelopeVersion_, raw, telemetryStats_, nullptr,
+                                  scheduleSync_.etag());
+    recordResult(telemetryBreaker_, httpCode, nowMs);
+
+    size_t bodyLen = 0;
+    const char* body = httpCode == 200 ? openResponse(raw.c_str(), raw.length(), bodyLen) : nullptr;
+    if (scheduleSync_.onResponse(httpCode, reinterpret_cast<const uint8_t*>(body), bodyLen,
+                                 responseEtag_) != ScheduleSync::Outcome::RETRY) {
+        defer(kScheduleFetch, nowMs, kHubScheduleFetchIntervalMs);
+    }
+#else
+    (void)nowMs;
+#endif
+}
 
-    float scheduledTarget = 0.0f;
-    if (extractJsonFloat(response, "scheduled_target", scheduledTarget)) {
-        scheduledTargetTemp_ = scheduledTarget;
-        Serial.printf("[HUB] Schedule temp override: %.1f°C\n", scheduledTarget);
-        logger_.log(wallNow, LogEventType::SCHEDULE_COMMAND, Command::NONE, true);
+void HubClient::applyHubConfig(const HubResponseMessage& message) {
+#if HUBCLIENT_HAS_HTTP
+    if (message.hasScheduledTarget) {
+        HubEvent event;
+        event.kind            = HubEvent::Kind::SCHEDULED_TARGET;
+        event.scheduledTarget = message.scheduledTarget;
+        link_.postEvent(event);
+        DIAG_LOGF(INFO, "HUB", "Schedule temp override: %.1f°C", message.scheduledTarget);
     }
 
-    char modeStr[8] = {0};
-    if (extractJsonString(response, "pid_mode", modeStr, sizeof(modeStr)) && modeStr[0]) {
-        strncpy(pendingMode_, modeStr, sizeof(pendingMode_) - 1);
-        pendingMode_[sizeof(pendingMode_) - 1] = '\0';
-        Serial.printf("[HUB] Mode change: %s\n", pendingMode_);
+    if (message.hasPidMode && message.pidMode[0]) {
+        HubEvent event;
+        event.kind = HubEvent::Kind::PID_MODE;
+        strncpy(event.pidMode, message.pidMode, sizeof(event.pidMode) - 1);
+        link_.postEvent(event);
+        DIAG_LOGF(INFO, "HUB", "Mode change: %s", event.pidMode);
     }
 
-    bool autoCtrl = true;
-    if (extractJsonBool(response, "auto_control", autoCtrl)) {
-        if (autoCtrl != autoControl_) {
-            autoControl_ = autoCtrl;
-            Serial.printf("[HUB] Auto control: %s\n", autoCtrl ? "ON" : "OFF");
+    if (message.hasAutoControl && message.autoControl != autoControl_) {
+        HubEvent event;
+        event.kind        = HubEvent::Kind::AUTO_CONTROL;
+        event.autoControl = message.autoControl;
+        if (link_.postEvent(event)) {
+            autoControl_ = message.autoControl;
         }
+        DIAG_LOGF(INFO, "HUB", "Auto control: %s", message.autoControl ? "ON" : "OFF");
     }
 #else
-    (void)wallNow;
+    (void)message;
 #endif
 }
 
-Command HubClient::parseCommandString(const char* str) {
-    if (!str) return Command::NONE;
-    if (strcmp(str, "on_off")         == 0) return Command::ON_OFF;
-    if (strcmp(str, "on")             == 0) return Command::ON_OFF;   // backward compat
-    if (strcmp(str, "off")            == 0) return Command::ON_OFF;   // backward compat
-    if (strcmp(str, "temp_up")        == 0) return Command::TEMP_UP;
-    if (strcmp(str, "temp_down")      == 0) return Command::TEMP_DOWN;
-    if (strcmp(str, "learn_on_off")   == 0) return Command::LEARN_ON_OFF;
-    if (strcmp(str, "learn_temp_up")  == 0) return Command::LEARN_TEMP_UP;
-    if (strcmp(str, "learn_temp_down")== 0) return Command::LEARN_TEMP_DOWN;
-    if (strcmp(str, "learn_clear")    == 0) return Command::LEARN_CLEAR_ALL;
-    if (strcmp(str, "learn_custom")   == 0) return Command::LEARN_CUSTOM;
-    return Command::NONE;
+void HubClient::defer(Deadline deadline, uint32_t nowMs, uint32_t delayMs) {
+    timers_.cancel(deadlines_[deadline]);
+    deadlines_[deadline] = timers_.start(nowMs + delayMs, deadline);
 }
 
+void HubClient::logStats(uint32_t nowMs) {
+    if (nowMs - lastStatsLogMs_ < kHubStatsLogIntervalMs) {
+        return;
+    }
+    lastStatsLogMs_ = nowMs;
 #if HUBCLIENT_HAS_HTTP
-bool HubClient::extractJsonString(const String& payload, const char* key,
-                                   char* outValue, size_t outValueSize) {
-    if (!key || !outValue || outValueSize == 0) return false;
-    const String pattern = String("\"") + key + "\"";
-    const int keyPos = payload.indexOf(pattern);
-    if (keyPos < 0) return false;
-    const int colonPos = payload.indexOf(':', keyPos + pattern.length());
-    if (colonPos < 0) return false;
-
-    // Handle null
-    int i = colonPos + 1;
-    while (i < (int)payload.length() && payload[i] == ' ') ++i;
-    if (payload.substring(i, i + 4) == "null") {
-        outValue[0] = '\0';
+    DIAG_LOGF(INFO, "HUB", "poll: n=%lu fail=%lu conn=%lu avg=%lums max=%lums | "
+              "telemetry: n=%lu fail=%lu conn=%lu avg=%lums max=%lums | "
+              "link: queued=%lu stalls=%lu lost=%lu | "
+              "breaker: cmd=%s trips=%lu retries=%lu tel=%s trips=%lu retries=%lu",
+              static_cast<unsigned long>(pollStats_.requests),
+              static_cast<unsigned long>(pollStats_.failures),
+              static_cast<unsigned long>(pollStats_.connects),
+              static_cast<unsigned long>(pollStats_.averageLatencyMs()),
+              static_cast<unsigned long>(pollStats_.maxLatencyMs),
+              static_cast<unsigned long>(telemetryStats_.requests),
+              static_cast<unsigned long>(telemetryStats_.failures),
+              static_cast<unsigned long>(telemetryStats_.connects),
+              static_cast<unsigned long>(telemetryStats_.averageLatencyMs()),
+              static_cast<unsigned long>(telemetryStats_.maxLatencyMs),
+              static_cast<unsigned long>(link_.stats().telemetryQueued),
+              static_cast<unsigned long>(link_.stats().workerStalls),
+              static_cast<unsigned long>(link_.stats().eventsDropped),
+              CircuitBreaker::stateName(commandBreaker_.state()),
+              static_cast<unsigned long>(commandBreaker_.trips()),
+              static_cast<unsigned long>(commandBreaker_.retries()),
+              CircuitBreaker::stateName(telemetryBreaker_.state()),
+              static_cast<unsigned long>(telemetryBreaker_.trips()),
+              static_cast<unsigned long>(telemetryBreaker_.retries()));
+#endif
+}
+
+bool HubClient::admit(CircuitBreaker& breaker, uint32_t nowMs) {
+    if (!breaker.allowRequest(nowMs)) {
         return false;
     }
+    if (breaker.state() != CircuitBreaker::State::HALF_OPEN) {
+        return true;
+    }
+    // A bare TCP connect tells a dead hub apart within kHubProbeTimeoutMs,
+    // instead of sending an encrypted request into a full HTTP timeout.
+    if (probeHub()) {
+        return true;
+    }
+    recordResult(breaker, -1, nowMs);
+    return false;
+}
 
-    const int startQuote = payload.indexOf('"', colonPos + 1);
-    if (startQuote < 0) return false;
-    const int endQuote = payload.indexOf('"', startQuote + 1);
-    if (endQuote < 0) return false;
-    const String value = payload.substring(startQuote + 1, endQuote);
-    strncpy(outValue, value.c_str(), outValueSize - 1);
-    outValue[outValueSize - 1] = '\0';
+void HubClient::recordResult(CircuitBreaker& breaker, int httpCode, uint32_t nowMs) {
+    const CircuitBreaker::State before = breaker.state();
+    const uint32_t probes = breaker.outageRetries();
+    if (hubFailed(httpCode)) {
+        breaker.recordFailure(nowMs);
+    } else {
+        breaker.recordSuccess();
+    }
+    const CircuitBreaker::State after = breaker.state();
+    const bool wentDown = before == CircuitBreaker::State::CLOSED && after == CircuitBreaker::State::OPEN;
+    const bool cameUp   = before != CircuitBreaker::State::CLOSED && after == CircuitBreaker::State::CLOSED;
+    const char* name = &breaker == &telemetryBreaker_ ? "telemetry" : "command";
+
+    if (after == CircuitBreaker::State::OPEN) {
+        DIAG_LOGF(INFO, "HUB", "%s link %s, retry in %lums", name,
+                  wentDown ? "down" : "still down",
+                  static_cast<unsigned long>(breaker.retryInMs(nowMs)));
+    } else if (cameUp) {
+        DIAG_LOGF(INFO, "HUB", "%s link back after %lu probe(s)", name,
+                  static_cast<unsigned long>(probes));
+    }
+    if (wentDown || cameUp) {
+        HubEvent event;
+        event.kind          = HubEvent::Kind::LINK_STATE;
+        event.linkUp        = cameUp;
+        event.linkTelemetry = &breaker == &telemetryBreaker_;
+        event.linkRetries   = probes;
+        link_.postEvent(event);
+    }
+}
+
+bool HubClient::probeHub() {
+#if HUBCLIENT_HAS_HTTP
+    WiFiClient probe;
+    const bool reachable = probe.connect(kHubHost, kHubPort, kHubProbeTimeoutMs);
+    probe.stop();
+    return reachable;
+#else
     return true;
+#endif
 }
 
-bool HubClient::extractJsonBool(const String& payload, const char* key,
-                                 bool& outValue) {
-    if (!key) return false;
-    const String pattern = String("\"") + key + "\"";
-    const int keyPos = payload.indexOf(pattern);
-    if (keyPos < 0) return false;
-    const int colonPos = payload.indexOf(':', keyPos + pattern.length());
-    if (colonPos < 0) return false;
-    int i = colonPos + 1;
-    while (i < (int)payload.length() && payload[i] == ' ') ++i;
-    if (payload.substring(i, i + 4) == "true")  { outValue = true;  return true; }
-    if (payload.substring(i, i + 5) == "false") { outValue = false; return true; }
-    return false;
+void HubClient::formatLinkHealth(char* out, size_t size) const {
+    snprintf(out, size, "cmd=%s,%lu,%lu;tel=%s,%lu,%lu",
+             CircuitBreaker::stateName(commandBreaker_.state()),
+             static_cast<unsigned long>(commandBreaker_.trips()),
+             static_cast<unsigned long>(commandBreaker_.retries()),
+             CircuitBreaker::stateName(telemetryBreaker_.state()),
+             static_cast<unsigned long>(telemetryBreaker_.trips()),
+             static_cast<unsigned long>(telemetryBreaker_.retries()));
 }
 
-bool HubClient::extractJsonFloat(const String& payload, const char* key,
-                                  float& outValue) {
-    if (!key) return false;
-    const String pattern = String("\"") + key + "\"";
-    const int keyPos = payload.indexOf(pattern);
-    if (keyPos < 0) return false;
-    const int colonPos = payload.indexOf(':', keyPos + pattern.length());
-    if (colonPos < 0) return false;
-    int numStart = colonPos + 1;
-    while (numStart < (int)payload.length() && payload[numStart] == ' ') ++numStart;
-    if (numStart >= (int)payload.length()) return false;
-    const String numStr = payload.substring(numStart);
-    outValue = numStr.toFloat();
-    return (outValue != 0.0f || numStr[0] == '0');
+#if HUBCLIENT_HAS_HTTP
+int HubClient::post(const char* path, const uint8_t* plain, size_t len, String& outResponse,
+                    RequestStats& stats, const char* telemetryFormat) {
+    if (envelopeVersion_ >= MessageCrypto::kV2Version) {
+        const size_t sealed = envelopeVersion_ == MessageCrypto::kV3Version
+            ? crypto_.sealV3(plain, len, envelopeBuf_, sizeof(envelopeBuf_))
+            : crypto_.sealV2(plain, len, envelopeBuf_, sizeof(envelopeBuf_));
+        if (sealed > 0) {
+            return exchange(path, envelopeBuf_, sealed, envelopeVersion_, outResponse,
+                            stats, telemetryFormat);
+        }
+    }
+    const size_t written = crypto_.encryptEnvelope(plain, len,
+                                                   reinterpret_cast<char*>(envelopeBuf_),
+                                                   sizeof(envelopeBuf_));
+    if (written > 0) {
+        return exchange(path, envelopeBuf_, written, 1, outResponse, stats, telemetryFormat);
+    }
+    // Only a JSON batch to a hub without v2 outgrows the buffer.
+    const String envelope = crypto_.encryptEnvelope(plain, len);
+    return exchange(path, reinterpret_cast<const uint8_t*>(envelope.c_str()), envelope.length(),
+                    1, outResponse, stats, telemetryFormat);
 }
 
-bool HubClient::extractJsonInt(const String& payload, const char* key,
-                                int& outValue) {
-    if (!key) return false;
-    const String pattern = String("\"") + key + "\"";
-    const int keyPos = payload.indexOf(pattern);
-    if (keyPos < 0) return false;
-    const int colonPos = payload.indexOf(':', keyPos + pattern.length());
-    if (colonPos < 0) return false;
-    int numStart = colonPos + 1;
-    while (numStart < (int)payload.length() && payload[numStart] == ' ') ++numStart;
-    if (numStart >= (int)payload.length()) return false;
-    const String numStr = payload.substring(numStart);
-    outValue = numStr.toInt();
-    return (outValue != 0 || numStr[0] == '0');
+int HubClient::exchange(const char* path, const uint8_t* body, size_t bodyLen, uint8_t envelope,
+                        String& outResponse, RequestStats& stats, const char* telemetryFormat,
+                        const char* ifNoneMatch) {
+    char url[128] = {0};
+    snprintf(url, sizeof(url), "http://%s:%d%s", kHubHost, kHubPort, path);
+
+    const uint32_t startMs = millis();
+
+    // Keep-alive: the member client holds the socket open between calls and
+    // HTTPClient reuses it as long as the hub does not close it.
+    HTTPClient  oneShot;
+    HTTPClient& http = kHubKeepAliveEnabled ? http_ : oneShot;
+    stats.begin(!kHubKeepAliveEnabled || !client_.connected());
+
+    http.setReuse(kHubKeepAliveEnabled);
+    http.setConnectTimeout(kHubHttpTimeoutMs);
+    http.setTimeout(kHubHttpTimeoutMs);
+    const bool begun = kHubKeepAliveEnabled ? http.begin(client_, url) : http.begin(url);
+    if (!begun) {
+        stats.fail();
+        DIAG_LOGF(WARN, "HUB", "begin() failed");
+        dropConnection();
+        return -1;
+    }
+
+    http.addHeader("X-Device-ID", DEVICE_ID);
+    http.addHeader("X-Encrypted", String(envelope));
+    if (body) {
+        http.addHeader("Content-Type", envelope >= MessageCrypto::kV2Version
+                                       ? "application/octet-stream"
+                                       : "application/x-encrypted");
+        http.addHeader("Authorization", DEVICE_PASS);
+    }
+    if (telemetryFormat) {
+        http.addHeader("X-Telemetry-Format", telemetryFormat);
+    }
+    if (body) {
+        char linkHealth[64] = {0};
+        formatLinkHealth(linkHealth, sizeof(linkHealth));
+        http.addHeader("X-Hub-Link", linkHealth);
+        if (scheduleSync_.local()) {
+            http.addHeader("X-Local-Schedule", schedule_codec::kFormatName);
+        }
+    }
+    if (ifNoneMatch) {
+        http.addHeader("If-None-Match", ifNoneMatch);
+    }
+    static const char* kResponseHeaders[] = {"X-Telemetry-Formats", "X-Envelope-Versions", "ETag"};
+    http.collectHeaders(kResponseHeaders, 3);
+    responseEtag_[0] = '\0';
+
+    const int httpCode = body ? http.POST(const_cast<uint8_t*>(body), bodyLen) : http.GET();
+    if (httpCode > 0) {
+        // The hub lists the telemetry encodings it accepts on every telemetry
+        // response; switch to binary as soon as it offers it.
+        if (kTelemetryBinaryEnabled && http.hasHeader("X-Telemetry-Formats")) {
+            binaryTelemetry_ = http.header("X-Telemetry-Formats").indexOf(telemetry_codec::kFormatName) >= 0;
+        }
+        if (telemetryFormat && httpCode == 400) {
+            binaryTelemetry_ = false;  // hub could not read the frame — back to JSON
+        }
+        // Same for the binary envelopes (X-Envelope-Versions: "1,2,3").
+        if (kHubEnvelopeV2Enabled && http.hasHeader("X-Envelope-Versions")) {
+            const String versions = http.header("X-Envelope-Versions");
+            uint8_t offered = 1;
+            if (kHubEnvelopeAeadEnabled && versions.indexOf('3') >= 0) {
+                offered = MessageCrypto::kV3Version;
+            } else if (versions.indexOf('2') >= 0) {
+                offered = MessageCrypto::kV2Version;
+            }
+            if (offered != envelopeVersion_) {
+                DIAG_LOGF(INFO, "HUB", "Envelope v%u", static_cast<unsigned>(offered));
+            }
+            envelopeVersion_ = offered;
+        }
+        if (envelope >= MessageCrypto::kV2Version && httpCode == 400) {
+            envelopeVersion_ = 1;  // hub could not open it — back to hex
+        }
+        if (http.hasHeader("ETag")) {
+            strncpy(responseEtag_, http.header("ETag").c_str(), sizeof(responseEtag_) - 1);
+        }
+        // Always drain the body so the connection is clean for the next request.
+        outResponse = http.getString();
+        http.end();
+    } else {
+        dropConnection();
+    }
+
+    stats.end(httpCode, millis() - startMs);
+    return httpCode;
+}
+
+void HubClient::dropConnection() {
+    http_.end();
+    client_.stop();
+}
+#endif
+
+Command HubClient::parseCommandString(const char* str) {
+    if (!str) return Command::NONE;
+    if (strcmp(str, "on_off")         == 0) return Command::ON_OFF;
+    if (strcmp(str, "on")             == 0) return Command::ON_OFF;   // backward compat
+    if (strcmp(str, "off")            == 0) return Command::ON_OFF;   // backward compat
+    if (strcmp(str, "temp_up")        == 0) return Command::TEMP_UP;
+    if (strcmp(str, "temp_down")      == 0) return Command::TEMP_DOWN;
+    if (strcmp(str, "learn_on_off")   == 0) return Command::LEARN_ON_OFF;
+    if (strcmp(str, "learn_temp_up")  == 0) return Command::LEARN_TEMP_UP;
+    if (strcmp(str, "learn_temp_down")== 0) return Command::LEARN_TEMP_DOWN;
+    if (strcmp(str, "learn_clear")    == 0) return Command::LEARN_CLEAR_ALL;
+    if (strcmp(str, "learn_custom")   == 0) return Command::LEARN_CUSTOM;
+    return Command::NONE;
 }
-#endif
\ No newline at end of file
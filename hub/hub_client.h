@@ -6,89 +6,151 @@
 #include <Arduino.h>
 #endif
 
+#if __has_include(<HTTPClient.h>) && __has_include(<WiFi.h>)
+#include <WiFi.h>
+#include <HTTPClient.h>
+#endif
+
 #include "../commands.h"
+#include "../core/timer_wheel.h"
 #include "../logger.h"
-#include "../time/wall_clock.h"
-#include "hub_receiver.h"
+#include "../prefferences.h"
+#include "circuit_breaker.h"
+#include "hub_endpoint.h"
+#include "hub_link.h"
+#include "hub_long_poll.h"
+#include "hub_messages.h"
+#include "request_stats.h"
+#include "schedule_sync.h"
+#include "telemetry_ring.h"
 #include "../crypto/message_crypto.h"
 
-class HubClient {
+// Talks HTTP to the hub on the HubWorker task. Everything loop() needs
+// (commands, config, telemetry) goes through the HubLink.
+class HubClient : public HubEndpoint {
 public:
-    struct Telemetry {
-        float  roomTempC    = 0.0f;
-        float  targetTempC  = 0.0f;
-        bool   powerOn      = false;
-        float  pidP         = 0.0f;
-        float  pidI         = 0.0f;
-        float  pidD         = 0.0f;
-        int8_t pidSteps     = 0;
-        float  integral     = 0.0f;
-        const char* mode    = "FAST";
-    };
-
-    // Custom IR command data (for custom button sending)
-    struct PendingCustomIr {
-        uint8_t  protocol = 0;
-        uint16_t address  = 0;
-        uint16_t command  = 0;
-        char     name[32] = {};
-        bool     valid    = false;
-    };
-
-    explicit HubClient(HubReceiver& receiver, Logger& logger);
-
-    void tick(uint32_t nowMs, const WallClockSnapshot& wallNow, bool wifiConnected);
-    void submitTelemetry(const Telemetry& telemetry);
-    bool hubReachable() const;
-
-    // Returns the latest scheduled target temp from the hub (0 if none received)
-    float scheduledTargetTemp() const { return scheduledTargetTemp_; }
-    void  clearScheduledTargetTemp()  { scheduledTargetTemp_ = 0.0f; }
-
-    // Returns pending mode change from hub ("FAST", "ECO", or "" if none)
-    const char* pendingMode() const   { return pendingMode_[0] ? pendingMode_ : nullptr; }
-    void        clearPendingMode()    { pendingMode_[0] = '\0'; }
-
-    // Whether the hub wants the PID auto-control loop to run
-    bool autoControl() const          { return autoControl_; }
-
-    // Custom IR: hub resolved a custom button to raw IR data
-    bool hasPendingCustomIr() const          { return pendingCustomIr_.valid; }
-    PendingCustomIr consumePendingCustomIr() {
-        PendingCustomIr ir = pendingCustomIr_;
-        pendingCustomIr_.valid = false;
-        return ir;
+    // logger is only read (copySince) to upload new entries.
+    HubClient(HubLink& link, Logger& logger);
+
+    // Worker side: takes queued telemetry from the link, talks to the hub and
+    // posts what it gets back. Blocks for as long as the network does.
+    void service(uint32_t nowMs) override;
+
+    // Call before the worker starts.
+    bool beginTelemetrySpill(const char* storageNamespace) {
+        return telemetryRing_.beginSpill(storageNamespace);
     }
 
-    void forceTelemetry() { lastTelemetryPostMs_ = 0; }
+    // Call before the worker starts. Hands the schedule saved by the last
+    // download to loop() through the link, so it runs before the hub is
+    // reachable, and makes the next download conditional on its ETag.
+    bool beginScheduleCache(const char* storageNamespace);
+
+    const RequestStats& commandPollStats() const { return pollStats_; }
+    const RequestStats& telemetryStats() const   { return telemetryStats_; }
+    const CircuitBreaker& commandBreaker() const   { return commandBreaker_; }
+    const CircuitBreaker& telemetryBreaker() const { return telemetryBreaker_; }
 private:
-    void pollCommand(const WallClockSnapshot& wallNow);
-    void postTelemetry(const WallClockSnapshot& wallNow);
+    void tick(uint32_t nowMs, bool wifiConnected);
+    void queueTelemetry(const TelemetrySample& sample);
+    void pollCommand(uint32_t nowMs);
+    void serviceCommandPush(uint32_t nowMs);
+    void fallBackToPolling(uint32_t nowMs, const char* reason);
+    void handleCommandPayload(const char* raw, size_t rawLen);
+    void handleCommand(const HubCommandMessage& message);
+    // Plaintext of a hub response: raw itself if it is already JSON,
+    // otherwise decrypted into envelopeBuf_ (empty on failure).
+    const char* openResponse(const char* raw, size_t rawLen, size_t& outLen);
+    // Both return true once the hub has the pending sample.
+    bool postTelemetry(uint32_t nowMs);
+    bool syncWithHub(uint32_t nowMs);
+    void applyHubConfig(const HubResponseMessage& message);
+    void drainTelemetryBacklog(uint32_t nowMs);
+    void fetchSchedule(uint32_t nowMs);
+    static int formatTelemetry(const TelemetrySample& sample, char* out, size_t size);
+    void logStats(uint32_t nowMs);
+    // Retry and cadence deadlines, one timer each on timers_. A deadline is
+    // due once its timer has expired, or before it was ever deferred.
+    enum Deadline : uint8_t { kPushRetry, kCommandPoll, kBacklogDrain, kScheduleFetch, kDeadlineCount };
+    bool due(Deadline deadline) const { return !timers_.pending(deadlines_[deadline]); }
+    void defer(Deadline deadline, uint32_t nowMs, uint32_t delayMs);
+    // Asks the breaker; a half-open breaker first gets a TCP connect probe.
+    bool admit(CircuitBreaker& breaker, uint32_t nowMs);
+    // Feeds an HTTP status (<= 0: transport error) into the breaker and tells
+    // loop() when the endpoint goes down or comes back.
+    void recordResult(CircuitBreaker& breaker, int httpCode, uint32_t nowMs);
+    bool probeHub();
+    // X-Hub-Link: "cmd=<state>,<trips>,<retries>;tel=<state>,<trips>,<retries>"
+    void formatLinkHealth(char* out, size_t size) const;
     static Command parseCommandString(const char* str);
 
 #if __has_include(<HTTPClient.h>) && __has_include(<WiFi.h>)
-    static bool extractJsonString(const String& payload, const char* key,
-                                  char* outValue, size_t outValueSize);
-    static bool extractJsonFloat(const String& payload, const char* key,
-                                  float& outValue);
-    static bool extractJsonBool(const String& payload, const char* key,
-                                 bool& outValue);
-    static bool extractJsonInt(const String& payload, const char* key,
-                                int& outValue);
+    // Sends one request to the hub and returns the HTTP status (<= 0 on
+    // transport errors). With keep-alive the socket survives between calls and
+    // is only torn down after a transport failure.
+    // body == nullptr sends a GET. envelope is the body's envelope version
+    // (2 and 3: raw binary). telemetryFormat, when set, marks a binary payload
+    // (X-Telemetry-Format). ifNoneMatch makes a GET conditional; the hub's
+    // ETag lands in responseEtag_.
+    int exchange(const char* path, const uint8_t* body, size_t bodyLen, uint8_t envelope,
+                 String& outResponse, RequestStats& stats, const char* telemetryFormat = nullptr,
+                 const char* ifNoneMatch = nullptr);
+    // Encrypts plain in the negotiated envelope version and POSTs it.
+    int post(const char* path, const uint8_t* plain, size_t len, String& outResponse,
+             RequestStats& stats, const char* telemetryFormat = nullptr);
+    void dropConnection();
 #endif
 
-    HubReceiver&  receiver_;
+    HubLink&      link_;
     Logger&       logger_;
     MessageCrypto crypto_;
 
-    Telemetry    pendingTelemetry_{};
+#if __has_include(<HTTPClient.h>) && __has_include(<WiFi.h>)
+    WiFiClient client_;
+    HTTPClient http_;
+#endif
+    HubLongPoll  longPoll_{};
+    bool         pushAvailable_       = true;
+    bool         syncAvailable_       = true;
+    bool         binaryTelemetry_     = false;  // hub accepts telemetry_codec frames
+    uint8_t      envelopeVersion_     = 1;  // highest version both sides list in X-Envelope-Versions
+    // Request envelopes are built here and response plaintext decrypted
+    // here, so neither touches the heap. Fits a JSON telemetry batch sealed
+    // as v2/v3; a bigger v1 envelope falls back to the String API.
+    static constexpr size_t kEnvelopeBufSize = 2304;
+    uint8_t      envelopeBuf_[kEnvelopeBufSize] = {};
+    static_assert(HubLink::kScheduleFrameSize < kEnvelopeBufSize,
+                  "a full weekly plan must decrypt into envelopeBuf_");
+    // Plaintext of a sync or telemetry batch request, a telemetry_codec
+    // frame or JSON, and the entries it is built from. Members rather than
+    // locals so they stay off the 8 KB HubWorker stack.
+    static constexpr size_t kSyncBodySize   = 256 + kHubSyncMaxLogEntries * 64;
+    static constexpr size_t kBatchBodySize  = 64 + kHubTelemetryBatchSize * 256;
+    static constexpr size_t kRequestBufSize =
+        kSyncBodySize > kBatchBodySize ? kSyncBodySize : kBatchBodySize;
+    char            requestBuf_[kRequestBufSize]          = {};
+    char            sampleFields_[256]                    = {};
+    LogEntry        syncLogs_[kHubSyncMaxLogEntries]      = {};
+    TelemetrySample batchSamples_[kHubTelemetryBatchSize] = {};
+    uint32_t     logCursor_           = 0;  // next Logger sequence to upload
+
+    CircuitBreaker commandBreaker_;    // command poll / long-poll
+    CircuitBreaker telemetryBreaker_;  // sync, telemetry and batch uploads
+
+    RequestStats pollStats_{};
+    RequestStats telemetryStats_{};
+    uint32_t     lastStatsLogMs_ = 0;
+
+    TelemetrySample pendingTelemetry_{};
     bool         hasPendingTelemetry_ = false;
+    TelemetryRing telemetryRing_{};
+    bool         scheduleFetchRequested_ = false;  // hub flagged a change ("sync")
+    ScheduleSync scheduleSync_{link_};
+    char         responseEtag_[ScheduleStore::kEtagSize]  = {};
     bool         hubReachable_        = false;
 
-    uint32_t lastCommandPollMs_   = 0;
+    TimerWheel<kDeadlineCount> timers_{};
+    TimerId  deadlines_[kDeadlineCount] = {};
     uint32_t lastTelemetryPostMs_ = 0;
-    float    scheduledTargetTemp_ = 0.0f;
-    char     pendingMode_[8]      = {};
-    bool     autoControl_         = false;
-    PendingCustomIr pendingCustomIr_{};
+    bool     autoControl_         = false;  // last value posted to the link
 };
\ No newline at end of file
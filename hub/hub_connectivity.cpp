@@ -2,8 +2,8 @@
 
 #include "../diagnostics/diag.h"
 #include "../prefferences.h"
+#include "json_reader.h"
 
-#include <cctype>
 #include <cstdio>
 #include <cstring>
 
@@ -35,44 +35,6 @@ void copyStr(char* dst, size_t dstSize, const char* src) {
 }
 
 #if HUB_HAS_HTTP && HUB_HAS_WIFI
-bool extractJsonString(const String& payload, const char* key,
-                       char* outValue, size_t outValueSize) {
-    if (!key || !outValue || outValueSize == 0) return false;
-    const String pattern = String("\"") + key + "\"";
-    const int keyPos = payload.indexOf(pattern);
-    if (keyPos < 0) return false;
-    const int colonPos = payload.indexOf(':', keyPos + pattern.length());
-    if (colonPos < 0) return false;
-    const int startQuote = payload.indexOf('"', colonPos + 1);
-    if (startQuote < 0) return false;
-    const int endQuote = payload.indexOf('"', startQuote + 1);
-    if (endQuote < 0) return false;
-    const String value = payload.substring(startQuote + 1, endQuote);
-    copyStr(outValue, outValueSize, value.c_str());
-    return true;
-}
-
-bool extractJsonInt(const String& payload, const char* key, int32_t& outValue) {
-    if (!key) return false;
-    const String pattern = String("\"") + key + "\"";
-    const int keyPos = payload.indexOf(pattern);
-    if (keyPos < 0) return false;
-    const int colonPos = payload.indexOf(':', keyPos + pattern.length());
-    if (colonPos < 0) return false;
-
-    int start = colonPos + 1;
-    while (start < payload.length() && payload[start] == ' ') ++start;
-    if (start >= payload.length()) return false;
-
-    int end = start;
-    if (payload[end] == '-') ++end;
-    while (end < payload.length() && isdigit(static_cast<unsigned char>(payload[end]))) ++end;
-    if (end == start || (payload[start] == '-' && end == start + 1)) return false;
-
-    outValue = payload.substring(start, end).toInt();
-    return true;
-}
-
 bool buildPosixTzFromOffsetSeconds(int32_t offsetSeconds,
                                    char* outRule,
                                    size_t outRuleSize) {
@@ -145,7 +107,7 @@ void HubConnectivity::tick(uint32_t nowMs,
             static uint32_t lastWarnMs = 0;
             if (nowMs - lastWarnMs >= 30000U) {
                 lastWarnMs = nowMs;
-                Serial.println("[WIFI] Reconnecting...");
+                DIAG_LOGF(INFO, "WIFI", "Reconnecting...");
             }
         }
         return;
@@ -154,8 +116,7 @@ void HubConnectivity::tick(uint32_t nowMs,
     // Log when we first confirm connected in tick()
     if (wifiStarted_ && WiFi.status() == WL_CONNECTED && !wifiLoggedConnected_) {
         wifiLoggedConnected_ = true;
-        Serial.print("[WIFI] Online — IP: ");
-        Serial.println(WiFi.localIP());
+        DIAG_LOGF(INFO, "WIFI", "Online — IP: %s", WiFi.localIP().toString().c_str());
     }
 
     if (!timeConfigured_) {
@@ -163,9 +124,9 @@ void HubConnectivity::tick(uint32_t nowMs,
             char tzRule[96] = {0};
             copyStr(tzRule, sizeof(tzRule), kNtpTimezone);
             wallClock.beginNtp(tzRule, kNtpServerPrimary, kNtpServerSecondary, kNtpServerTertiary);
-            Serial.println("[TIME] NTP configured");
+            DIAG_LOGF(INFO, "TIME", "NTP configured");
         } else {
-            Serial.println("[TIME] Wall clock already set — skipping NTP reconfigure");
+            DIAG_LOGF(INFO, "TIME", "Wall clock already set — skipping NTP reconfigure");
         }
         timeConfigured_ = true;
 }
@@ -193,13 +154,13 @@ bool HubConnectivity::lookupTimezoneRuleFromIp(char* outRule, size_t outRuleSize
     http.setTimeout(kHubHttpTimeoutMs);
 
     if (!http.begin(kIpTimezoneUrl)) {
-        Serial.println("[TIME] IP timezone lookup begin() failed");
+        DIAG_LOGF(WARN, "TIME", "IP timezone lookup begin() failed");
         return false;
     }
 
     const int httpCode = http.GET();
     if (httpCode != 200) {
-        Serial.printf("[TIME] IP timezone lookup failed, HTTP %d\n", httpCode);
+        DIAG_LOGF(WARN, "TIME", "IP timezone lookup failed, HTTP %d", httpCode);
         http.end();
         return false;
     }
@@ -207,36 +168,55 @@ bool HubConnectivity::lookupTimezoneRuleFromIp(char* outRule, size_t outRuleSize
     const String payload = http.getString();
     http.end();
 
-    char status[16] = {0};
-    if (!extractJsonString(payload, "status", status, sizeof(status)) ||
-        strcmp(status, "success") != 0) {
-        Serial.println("[TIME] IP timezone lookup returned non-success status");
+    char    status[16]    = {0};
+    char    timezone[64]  = {0};
+    int32_t offsetSeconds = 0;
+    bool    hasTimezone   = false;
+    bool    hasOffset     = false;
+
+    JsonReader reader(payload.c_str(), payload.length());
+    const char* key = nullptr;
+    size_t keyLen = 0;
+    if (reader.enterObject()) {
+        while (reader.nextKey(key, keyLen)) {
+            const JsonReader::Type type = reader.peekType();
+            if (JsonReader::keyIs(key, keyLen, "status") && type == JsonReader::Type::STRING) {
+                reader.readString(status, sizeof(status));
+            } else if (JsonReader::keyIs(key, keyLen, "timezone") && type == JsonReader::Type::STRING) {
+                hasTimezone = reader.readString(timezone, sizeof(timezone));
+            } else if (JsonReader::keyIs(key, keyLen, "offset") && type == JsonReader::Type::NUMBER) {
+                hasOffset = reader.readInt(offsetSeconds);
+            } else {
+                reader.skipValue();
+            }
+        }
+    }
+
+    if (!reader.ok() || strcmp(status, "success") != 0) {
+        DIAG_LOGF(WARN, "TIME", "IP timezone lookup returned non-success status");
         return false;
     }
 
-    char timezone[64] = {0};
-    const bool hasTimezone = extractJsonString(payload, "timezone", timezone, sizeof(timezone));
     if (hasTimezone) {
         if (const char* mappedRule = mapIanaToPosix(timezone)) {
             copyStr(outRule, outRuleSize, mappedRule);
-            Serial.printf("[TIME] IP timezone %s mapped to %s\n", timezone, outRule);
+            DIAG_LOGF(INFO, "TIME", "IP timezone %s mapped to %s", timezone, outRule);
             return true;
         }
     }
 
-    int32_t offsetSeconds = 0;
-    if (extractJsonInt(payload, "offset", offsetSeconds) &&
+    if (hasOffset &&
         buildPosixTzFromOffsetSeconds(offsetSeconds, outRule, outRuleSize)) {
         if (hasTimezone) {
-            Serial.printf("[TIME] IP timezone %s using fixed offset rule %s\n", timezone, outRule);
+            DIAG_LOGF(INFO, "TIME", "IP timezone %s using fixed offset rule %s", timezone, outRule);
         } else {
-            Serial.printf("[TIME] IP timezone offset %ld using fixed rule %s\n",
-                          static_cast<long>(offsetSeconds), outRule);
+            DIAG_LOGF(INFO, "TIME", "IP timezone offset %ld using fixed rule %s",
+                      static_cast<long>(offsetSeconds), outRule);
         }
         return true;
     }
 
-    Serial.println("[TIME] IP timezone lookup could not resolve a TZ rule");
+    DIAG_LOGF(WARN, "TIME", "IP timezone lookup could not resolve a TZ rule");
     return false;
 #else
     (void)outRule;
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Hub side of a HubLink: HubClient on hardware, a loopback mock on the host.
+// service() is called repeatedly by the HubWorker and may block for as long
+// as the network does; it talks to loop() only through its HubLink.
+class HubEndpoint {
+public:
+    virtual ~HubEndpoint() = default;
+    virtual void service(uint32_t nowMs) = 0;
+};
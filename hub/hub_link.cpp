@@ -0,0 +1,149 @@
+#include "hub_link.h"
+
+#include <cstring>
+
+#include "../diagnostics/diag.h"
+#include "../prefferences.h"
+
+namespace {
+TelemetryPolicy::Config telemetryPolicyConfig() {
+    TelemetryPolicy::Config config;
+    config.roomTempDeadbandC   = kTelemetryRoomDeadbandC;
+    config.targetTempDeadbandC = kTelemetryTargetDeadbandC;
+    config.pidDeadband         = kTelemetryPidDeadband;
+    config.keyframeIntervalMs  = kTelemetryKeyframeIntervalMs;
+    return config;
+}
+}  // namespace
+
+HubLink::HubLink(HubReceiver& receiver, Logger& logger)
+    : HubLink(receiver, logger, telemetryPolicyConfig()) {}
+
+HubLink::HubLink(HubReceiver& receiver, Logger& logger, const TelemetryPolicy::Config& policy)
+    : receiver_(receiver), logger_(logger), telemetryPolicy_(policy) {}
+
+void HubLink::tick(const WallClockSnapshot& wallNow, bool wifiConnected) {
+    wifiConnected_.store(wifiConnected);
+
+    HubEvent event;
+    while (fromHub_.pop(event)) {
+        applyEvent(event, wallNow);
+    }
+}
+
+void HubLink::submitTelemetry(const Telemetry& telemetry, const WallClockSnapshot& wallNow) {
+    TelemetrySample s{};
+    s.unixMs      = wallNow.valid ? wallNow.unixMs : 0;
+    s.bootMs      = wallNow.bootMs;
+    s.roomTempC   = telemetry.roomTempC;
+    s.targetTempC = telemetry.targetTempC;
+    s.pidP        = telemetry.pidP;
+    s.pidI        = telemetry.pidI;
+    s.pidD        = telemetry.pidD;
+    s.integral    = telemetry.integral;
+    s.pidSteps    = telemetry.pidSteps;
+    s.powerOn     = telemetry.powerOn;
+    s.ecoMode     = telemetry.mode && strcmp(telemetry.mode, "ECO") == 0;
+
+    if (keyframeRequested_.exchange(false)) {
+        forceTelemetry();
+    }
+    // The worker is stuck on the network. Samples are not offered to the
+    // policy meanwhile, and a keyframe goes out once it catches up.
+    if (toHub_.size() >= toHub_.capacity()) {
+        if (!workerBehind_) {
+            workerBehind_ = true;
+            workerStalls_.fetch_add(1);
+        }
+        return;
+    }
+    if (workerBehind_) {
+        workerBehind_ = false;
+        telemetryPolicy_.requestKeyframe();
+    }
+
+    if (kTelemetryPolicyEnabled && !telemetryPolicy_.offer(s, wallNow.bootMs)) {
+        return;
+    }
+    toHub_.push(s);
+    telemetryQueued_.fetch_add(1);
+}
+
+void HubLink::forceTelemetry() {
+    telemetryPolicy_.requestKeyframe();
+    uploadRequested_.store(true);
+}
+
+HubLink::Stats HubLink::stats() const {
+    Stats stats;
+    stats.telemetryQueued  = telemetryQueued_.load();
+    stats.workerStalls     = workerStalls_.load();
+    stats.eventsDropped    = eventsDropped_.load();
+    return stats;
+}
+
+bool HubLink::postEvent(const HubEvent& event) {
+    if (fromHub_.push(event)) {
+        return true;
+    }
+    eventsDropped_.fetch_add(1);
+    DIAG_LOGF(WARN, "HUB", "event queue full, dropped");
+    return false;
+}
+
+bool HubLink::postSchedule(const uint8_t* frame, size_t length) {
+    if (length > sizeof(schedule_) || scheduleReady_.load()) {
+        return false;
+    }
+    memcpy(schedule_, frame, length);
+    scheduleLength_ = length;
+    scheduleReady_.store(true);
+    return true;
+}
+
+const uint8_t* HubLink::pendingSchedule(size_t& outLength) const {
+    if (!scheduleReady_.load()) {
+        return nullptr;
+    }
+    outLength = scheduleLength_;
+    return schedule_;
+}
+
+void HubLink::applyEvent(const HubEvent& event, const WallClockSnapshot& wallNow) {
+    switch (event.kind) {
+    case HubEvent::Kind::COMMAND:
+        logger_.log(wallNow, LogEventType::HUB_COMMAND_RX, event.command, true);
+        if (!receiver_.push(event.command)) {
+            DIAG_LOGF(WARN, "HUB", "command poll: queue full, dropped");
+            logger_.log(wallNow, LogEventType::COMMAND_DROPPED, event.command, false);
+        }
+        break;
+    case HubEvent::Kind::CUSTOM_IR:
+        pendingCustomIr_.protocol = event.irProtocol;
+        pendingCustomIr_.address  = event.irAddress;
+        pendingCustomIr_.command  = event.irCommand;
+        memcpy(pendingCustomIr_.name, event.irName, sizeof(pendingCustomIr_.name));
+        pendingCustomIr_.name[sizeof(pendingCustomIr_.name) - 1] = '\0';
+        pendingCustomIr_.valid = true;
+        break;
+    case HubEvent::Kind::SCHEDULED_TARGET:
+        scheduledTargetTemp_ = event.scheduledTarget;
+        logger_.log(wallNow, LogEventType::SCHEDULE_COMMAND, Command::NONE, true);
+        break;
+    case HubEvent::Kind::PID_MODE:
+        memcpy(pendingMode_, event.pidMode, sizeof(pendingMode_));
+        pendingMode_[sizeof(pendingMode_) - 1] = '\0';
+        break;
+    case HubEvent::Kind::AUTO_CONTROL:
+        autoControl_ = event.autoControl;
+        break;
+    case HubEvent::Kind::LINK_STATE: {
+        // detail: probes sent during the outage (capped), top bit = telemetry.
+        const uint32_t retries = event.linkRetries < 0x7F ? event.linkRetries : 0x7F;
+        const uint8_t detail = static_cast<uint8_t>(retries | (event.linkTelemetry ? 0x80 : 0x00));
+        logger_.log(wallNow, event.linkUp ? LogEventType::HUB_LINK_UP : LogEventType::HUB_LINK_DOWN,
+                    Command::NONE, event.linkUp, detail);
+        break;
+    }
+    }
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "../commands.h"
+#include "../core/spsc_queue.h"
+#include "../logger.h"
+#include "../time/wall_clock.h"
+#include "hub_receiver.h"
+#include "schedule_codec.h"
+#include "telemetry_policy.h"
+#include "telemetry_ring.h"
+
+// Something the hub asked for, handed from the hub worker to loop().
+struct HubEvent {
+    enum class Kind : uint8_t {
+        COMMAND = 0,
+        CUSTOM_IR,         // hub resolved a custom button to raw IR data
+        SCHEDULED_TARGET,
+        PID_MODE,
+        AUTO_CONTROL,
+        LINK_STATE,        // a circuit breaker opened or closed
+    };
+
+    Kind     kind            = Kind::COMMAND;
+    Command  command         = Command::NONE;
+    float    scheduledTarget = 0.0f;
+    bool     autoControl     = false;
+    char     pidMode[8]      = {};
+    uint8_t  irProtocol      = 0;
+    uint16_t irAddress       = 0;
+    uint16_t irCommand       = 0;
+    char     irName[32]      = {};
+    // LINK_STATE
+    bool     linkUp          = false;
+    bool     linkTelemetry   = false;  // telemetry endpoint, else commands
+    uint32_t linkRetries     = 0;
+};
+
+// The only state shared between loop() and the hub worker.
+//
+// loop() offers telemetry and reads hub commands/config through the loop-side
+// calls; the worker (HubEndpoint::service) uses the worker-side calls. Data
+// crosses in two bounded SPSC queues, so neither side ever waits on the
+// other: a full queue defers telemetry and drops (and counts) events.
+// Everything the worker produces is applied to loop-owned state in tick(), on
+// loop()'s thread, including logging and pushing into the HubReceiver.
+// With the ControlTask running, "loop()" here means the control task.
+class HubLink {
+public:
+    struct Telemetry {
+        float  roomTempC    = 0.0f;
+        float  targetTempC  = 0.0f;
+        bool   powerOn      = false;
+        float  pidP         = 0.0f;
+        float  pidI         = 0.0f;
+        float  pidD         = 0.0f;
+        int8_t pidSteps     = 0;
+        float  integral     = 0.0f;
+        const char* mode    = "FAST";
+    };
+
+    // Custom IR command data (for custom button sending)
+    struct PendingCustomIr {
+        uint8_t  protocol = 0;
+        uint16_t address  = 0;
+        uint16_t command  = 0;
+        char     name[32] = {};
+        bool     valid    = false;
+    };
+
+    struct Stats {
+        uint32_t telemetryQueued  = 0;
+        uint32_t workerStalls     = 0;  // times the loop -> worker queue filled up
+        uint32_t eventsDropped    = 0;  // worker -> loop queue full
+    };
+
+    static constexpr size_t kTelemetryQueueSize = 8;
+    static constexpr size_t kEventQueueSize     = 16;
+    // Largest schedule_codec frame the SchedulePlan could load.
+    static constexpr size_t kScheduleFrameSize  =
+        schedule_codec::kHeaderSize + SchedulePlan::kCapacity * schedule_codec::kEntrySize;
+
+    HubLink(HubReceiver& receiver, Logger& logger);
+    HubLink(HubReceiver& receiver, Logger& logger, const TelemetryPolicy::Config& policy);
+
+    // ── loop() side ──────────────────────────────────────────
+    // Applies everything the worker posted since the last call.
+    void tick(const WallClockSnapshot& wallNow, bool wifiConnected);
+    // Call every loop: TelemetryPolicy picks the samples worth uploading.
+    // Samples are stamped with wallNow so buffered ones keep their time.
+    void submitTelemetry(const Telemetry& telemetry, const WallClockSnapshot& wallNow);
+    // Sends the next submitted sample as a keyframe, without waiting for the
+    // upload gate.
+    void forceTelemetry();
+    // While suspended the worker makes no network calls (IR learn listening).
+    void setSuspended(bool suspended) { suspended_.store(suspended); }
+
+    bool hubReachable() const { return hubReachable_.load(); }
+
+    // Returns the latest scheduled target temp from the hub (0 if none received)
+    float scheduledTargetTemp() const { return scheduledTargetTemp_; }
+    void  clearScheduledTargetTemp()  { scheduledTargetTemp_ = 0.0f; }
+
+    // Returns pending mode change from hub ("FAST", "ECO", or "" if none)
+    const char* pendingMode() const   { return pendingMode_[0] ? pendingMode_ : nullptr; }
+    void        clearPendingMode()    { pendingMode_[0] = '\0'; }
+
+    // Whether the hub wants the PID auto-control loop to run
+    bool autoControl() const          { return autoControl_; }
+
+    // Weekly schedule downloaded from the hub (a schedule_codec frame), or
+    // nullptr. Stays valid until clearPendingSchedule().
+    const uint8_t* pendingSchedule(size_t& outLength) const;
+    void           clearPendingSchedule() { scheduleReady_.store(false); }
+
+    bool hasPendingCustomIr() const          { return pendingCustomIr_.valid; }
+    PendingCustomIr consumePendingCustomIr() {
+        PendingCustomIr ir = pendingCustomIr_;
+        pendingCustomIr_.valid = false;
+        return ir;
+    }
+
+    // Safe to read from either side.
+    Stats stats() const;
+
+    // ── worker side ──────────────────────────────────────────
+    bool wifiConnected() const { return wifiConnected_.load(); }
+    bool suspended() const     { return suspended_.load(); }
+    bool popTelemetry(TelemetrySample& out) { return toHub_.pop(out); }
+    // True once after forceTelemetry(): skip the upload gate.
+    bool takeUploadRequest() { return uploadRequested_.exchange(false); }
+    // Asks loop() for a keyframe, e.g. when the hub flags a config change.
+    void requestKeyframe() { keyframeRequested_.store(true); }
+    bool postEvent(const HubEvent& event);
+    // False while loop() still holds the previous schedule, or when the
+    // frame is bigger than kScheduleFrameSize.
+    bool postSchedule(const uint8_t* frame, size_t length);
+    void setHubReachable(bool reachable) { hubReachable_.store(reachable); }
+
+private:
+    void applyEvent(const HubEvent& event, const WallClockSnapshot& wallNow);
+
+    HubReceiver& receiver_;
+    Logger&      logger_;
+
+    SpscQueue<TelemetrySample, kTelemetryQueueSize> toHub_{};
+    SpscQueue<HubEvent, kEventQueueSize>            fromHub_{};
+
+    std::atomic<bool>     wifiConnected_{false};
+    std::atomic<bool>     suspended_{false};
+    std::atomic<bool>     hubReachable_{false};
+    std::atomic<bool>     uploadRequested_{false};
+    std::atomic<bool>     keyframeRequested_{false};
+    std::atomic<uint32_t> telemetryQueued_{0};
+    std::atomic<uint32_t> workerStalls_{0};
+    std::atomic<uint32_t> eventsDropped_{0};
+
+    // One-slot mailbox: the worker writes only while scheduleReady_ is false.
+    std::atomic<bool> scheduleReady_{false};
+    uint8_t           schedule_[kScheduleFrameSize] = {};
+    size_t            scheduleLength_ = 0;
+
+    // loop()-owned
+    TelemetryPolicy telemetryPolicy_;
+    bool     workerBehind_        = false;
+    float    scheduledTargetTemp_ = 0.0f;
+    char     pendingMode_[8]      = {};
+    bool     autoControl_         = false;
+    PendingCustomIr pendingCustomIr_{};
+};
@@ -0,0 +1,171 @@
+#include "hub_long_poll.h"
+
+#include "../prefferences.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+// Returns the value of header `name` inside the header block, or nullptr.
+// The block starts right after the status line; names are case-insensitive.
+const char* findHeader(const char* headers, size_t length, const char* name) {
+    const size_t nameLen = strlen(name);
+    const char* line = headers;
+    const char* end  = headers + length;
+    while (line < end) {
+        const char* eol = static_cast<const char*>(memchr(line, '\r', end - line));
+        if (!eol) eol = end;
+        if (static_cast<size_t>(eol - line) > nameLen &&
+            strncasecmp(line, name, nameLen) == 0 && line[nameLen] == ':') {
+            const char* value = line + nameLen + 1;
+            while (value < eol && *value == ' ') ++value;
+            return value;
+        }
+        line = eol + 2;
+    }
+    return nullptr;
+}
+}  // namespace
+
+#if __has_include(<WiFi.h>)
+HubLongPoll::HubLongPoll() : socket_(&wifi_) {}
+#else
+HubLongPoll::HubLongPoll() = default;
+#endif
+
+bool HubLongPoll::start(const char* path, uint32_t nowMs, uint32_t holdMs) {
+    if (socket_ == nullptr) {
+        state_ = State::FAILED;
+        return false;
+    }
+    if (!socket_->connected()) {
+        socket_->stop();
+        if (!socket_->connect(kHubHost, kHubPort, kHubHttpTimeoutMs)) {
+            fail();
+            return false;
+        }
+    }
+
+    char request[256] = {0};
+    const int written = snprintf(request, sizeof(request),
+        "GET %s HTTP/1.1\r\n"
+        "Host: %s:%d\r\n"
+        "X-Device-ID: %s\r\n"
+        "X-Encrypted: %u\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n",
+        path, kHubHost, kHubPort, DEVICE_ID, static_cast<unsigned>(envelopeVersion_));
+    if (written <= 0 || static_cast<size_t>(written) >= sizeof(request) ||
+        socket_->write(reinterpret_cast<const uint8_t*>(request), written) != static_cast<size_t>(written)) {
+        fail();
+        return false;
+    }
+
+    length_        = 0;
+    headerEnd_     = 0;
+    contentLength_ = 0;
+    body_          = nullptr;
+    bodyLength_    = 0;
+    status_        = 0;
+    serverHeld_    = false;
+    startedMs_     = nowMs;
+    timeoutMs_     = holdMs + kGraceMs;
+    state_         = State::WAITING;
+    return true;
+}
+
+HubLongPoll::State HubLongPoll::poll(uint32_t nowMs) {
+    if (state_ != State::WAITING) {
+        return state_;
+    }
+
+    // Drain whatever has arrived without waiting for more.
+    int avail = socket_->available();
+    while (avail > 0 && length_ < kBufferSize - 1) {
+        const size_t room  = kBufferSize - 1 - length_;
+        const size_t chunk = static_cast<size_t>(avail) < room ? static_cast<size_t>(avail) : room;
+        const int got = socket_->read(reinterpret_cast<uint8_t*>(buffer_ + length_), chunk);
+        if (got <= 0) break;
+        length_ += static_cast<size_t>(got);
+        avail = socket_->available();
+    }
+    buffer_[length_] = '\0';
+
+    if (headerEnd_ == 0) {
+        const char* sep = strstr(buffer_, "\r\n\r\n");
+        if (sep) {
+            headerEnd_ = static_cast<size_t>(sep - buffer_) + 4;
+            if (!parseHeaders(headerEnd_)) {
+                fail();
+                return state_;
+            }
+        }
+    }
+
+    if (headerEnd_ != 0 && length_ - headerEnd_ >= contentLength_) {
+        body_       = buffer_ + headerEnd_;
+        bodyLength_ = contentLength_;
+        buffer_[headerEnd_ + contentLength_] = '\0';
+        state_ = State::DONE;
+        return state_;
+    }
+
+    if (length_ >= kBufferSize - 1 || !socket_->connected() ||
+        nowMs - startedMs_ >= timeoutMs_) {
+        fail();
+    }
+    return state_;
+}
+
+bool HubLongPoll::parseHeaders(size_t headerEnd) {
+    // "HTTP/1.1 200 OK"
+    if (strncmp(buffer_, "HTTP/1.", 7) != 0) {
+        return false;
+    }
+    const char* space = strchr(buffer_, ' ');
+    if (!space) {
+        return false;
+    }
+    status_ = atoi(space + 1);
+
+    const char* headers = strstr(buffer_, "\r\n");
+    if (!headers) {
+        return false;
+    }
+    headers += 2;
+    const size_t headersLen = (buffer_ + headerEnd) - headers;
+
+    const char* contentLength = findHeader(headers, headersLen, "Content-Length");
+    if (!contentLength) {
+        return false;  // the hub always sends a length; chunked replies are not supported
+    }
+    contentLength_ = static_cast<size_t>(strtoul(contentLength, nullptr, 10));
+    if (headerEnd + contentLength_ >= kBufferSize) {
+        return false;
+    }
+    serverHeld_ = findHeader(headers, headersLen, "X-Long-Poll") != nullptr;
+    return true;
+}
+
+void HubLongPoll::reset() {
+    if (state_ == State::FAILED) {
+        close();
+    }
+    state_ = State::IDLE;
+}
+
+void HubLongPoll::close() {
+    if (socket_ != nullptr) {
+        socket_->stop();
+    }
+    state_ = State::IDLE;
+}
+
+void HubLongPoll::fail() {
+    if (socket_ != nullptr) {
+        socket_->stop();
+    }
+    state_ = State::FAILED;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if __has_include(<WiFi.h>)
+#include <WiFi.h>
+#endif
+
+// Socket a HubLongPoll runs on: a WiFiClient on hardware, a scripted one in
+// host tests.
+class HubSocket {
+public:
+    virtual ~HubSocket() = default;
+    virtual bool   connected() = 0;
+    virtual bool   connect(const char* host, uint16_t port, uint32_t timeoutMs) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+    virtual int    available() = 0;
+    virtual int    read(uint8_t* out, size_t length) = 0;
+    virtual void   stop() = 0;
+};
+
+#if __has_include(<WiFi.h>)
+class WiFiHubSocket : public HubSocket {
+public:
+    bool connected() override { return client_.connected(); }
+    bool connect(const char* host, uint16_t port, uint32_t timeoutMs) override {
+        if (!client_.connect(host, port, static_cast<int32_t>(timeoutMs))) {
+            return false;
+        }
+        client_.setNoDelay(true);
+        return true;
+    }
+    size_t write(const uint8_t* data, size_t length) override { return client_.write(data, length); }
+    int    available() override { return client_.available(); }
+    int    read(uint8_t* out, size_t length) override { return client_.read(out, length); }
+    void   stop() override { client_.stop(); }
+
+private:
+    WiFiClient client_;
+};
+#endif
+
+// HubLongPoll: one outstanding HTTP/1.1 GET that the hub holds open until it
+// has something to say (see GET /api/command/pending?wait=N).
+//
+// The request is written once and the response is collected with
+// non-blocking reads from tick(), so a held request never stalls loop().
+// Only connect() blocks, bounded by kHubHttpTimeoutMs, and the socket is kept
+// alive between polls so reconnects are rare.
+class HubLongPoll {
+public:
+    enum class State : uint8_t {
+        IDLE    = 0,  // nothing outstanding
+        WAITING = 1,  // request sent, hub is holding it
+        DONE    = 2,  // full response received — read status()/body()
+        FAILED  = 3,  // connect/write error, malformed response or timeout
+    };
+
+    // Runs on its own WiFiClient (always FAILED without WiFi); tests pass a
+    // scripted socket.
+    HubLongPoll();
+    explicit HubLongPoll(HubSocket& socket) : socket_(&socket) {}
+    HubLongPoll(const HubLongPoll&)            = delete;
+    HubLongPoll& operator=(const HubLongPoll&) = delete;
+
+    // Connects if needed and sends GET <path>. holdMs is how long the hub may
+    // keep the request open; the poll fails if nothing arrives well after it.
+    bool start(const char* path, uint32_t nowMs, uint32_t holdMs);
+    State poll(uint32_t nowMs);
+    // Returns to IDLE after DONE/FAILED, keeping the socket for the next start().
+    void reset();
+    void close();
+    // Envelope version sent as X-Encrypted; the hub answers in the same one.
+    void setEnvelopeVersion(uint8_t version) { envelopeVersion_ = version; }
+
+    State state() const { return state_; }
+    int status() const { return status_; }
+    const char* body() const { return body_; }
+    size_t bodyLength() const { return bodyLength_; }
+    // True when the hub acknowledged the long-poll (X-Long-Poll header).
+    // Older hubs answer immediately without it.
+    bool serverHeld() const { return serverHeld_; }
+
+private:
+    static constexpr size_t kBufferSize = 1024;
+    static constexpr uint32_t kGraceMs  = 5000U;
+
+    bool parseHeaders(size_t headerEnd);
+    void fail();
+
+#if __has_include(<WiFi.h>)
+    WiFiHubSocket wifi_;
+#endif
+    HubSocket* socket_      = nullptr;
+    char     buffer_[kBufferSize] = {};
+    size_t   length_        = 0;
+    size_t   headerEnd_     = 0;
+    size_t   contentLength_ = 0;
+    const char* body_       = nullptr;
+    size_t   bodyLength_    = 0;
+    int      status_        = 0;
+    bool     serverHeld_    = false;
+    uint8_t  envelopeVersion_ = 1;
+    State    state_         = State::IDLE;
+    uint32_t startedMs_     = 0;
+    uint32_t timeoutMs_     = 0;
+};
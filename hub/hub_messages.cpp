@@ -0,0 +1,85 @@
+#include "hub_messages.h"
+
+#include "json_reader.h"
+
+namespace {
+// Reads the command object the reader is positioned on.
+bool readCommand(JsonReader& reader, HubCommandMessage& out) {
+    out = HubCommandMessage{};
+    bool hasProtocol = false, hasAddress = false, hasIrCommand = false;
+
+    const char* key = nullptr;
+    size_t keyLen = 0;
+    if (!reader.enterObject()) return false;
+    while (reader.nextKey(key, keyLen)) {
+        if (JsonReader::keyIs(key, keyLen, "command")) {
+            if (reader.peekType() == JsonReader::Type::NUL) {
+                reader.readNull();
+            } else {
+                out.hasCommand = reader.readString(out.command, sizeof(out.command));
+            }
+        } else if (JsonReader::keyIs(key, keyLen, "protocol")) {
+            hasProtocol = reader.readInt(out.protocol);
+        } else if (JsonReader::keyIs(key, keyLen, "address")) {
+            hasAddress = reader.readInt(out.address);
+        } else if (JsonReader::keyIs(key, keyLen, "ir_command")) {
+            hasIrCommand = reader.readInt(out.irCommand);
+        } else if (JsonReader::keyIs(key, keyLen, "name") &&
+                   reader.peekType() == JsonReader::Type::STRING) {
+            reader.readString(out.name, sizeof(out.name));
+        } else if (JsonReader::keyIs(key, keyLen, "sync") &&
+                   reader.peekType() == JsonReader::Type::BOOL) {
+            reader.readBool(out.syncRequested);
+        } else {
+            reader.skipValue();
+        }
+    }
+    out.hasIr = hasProtocol && hasAddress && hasIrCommand;
+    return reader.ok();
+}
+}  // namespace
+
+bool parseHubCommand(const char* json, size_t length, HubCommandMessage& out) {
+    JsonReader reader(json, length);
+    return readCommand(reader, out);
+}
+
+bool parseHubResponse(const char* json, size_t length, HubResponseMessage& out) {
+    out = HubResponseMessage{};
+    JsonReader reader(json, length);
+
+    const char* key = nullptr;
+    size_t keyLen = 0;
+    if (!reader.enterObject()) return false;
+    while (reader.nextKey(key, keyLen)) {
+        const JsonReader::Type type = reader.peekType();
+        if (JsonReader::keyIs(key, keyLen, "auto_control") && type == JsonReader::Type::BOOL) {
+            out.hasAutoControl = reader.readBool(out.autoControl);
+        } else if (JsonReader::keyIs(key, keyLen, "scheduled_target") &&
+                   type == JsonReader::Type::NUMBER) {
+            out.hasScheduledTarget = reader.readFloat(out.scheduledTarget);
+        } else if (JsonReader::keyIs(key, keyLen, "pid_mode") && type == JsonReader::Type::STRING) {
+            out.hasPidMode = reader.readString(out.pidMode, sizeof(out.pidMode));
+        } else if (JsonReader::keyIs(key, keyLen, "accepted") && type == JsonReader::Type::NUMBER) {
+            out.hasAccepted = reader.readInt(out.accepted);
+        } else if (JsonReader::keyIs(key, keyLen, "retry_after_ms") &&
+                   type == JsonReader::Type::NUMBER) {
+            reader.readInt(out.retryAfterMs);
+        } else if (JsonReader::keyIs(key, keyLen, "commands") && type == JsonReader::Type::ARRAY) {
+            reader.enterArray();
+            while (reader.nextElement()) {
+                if (out.commandCount < HubResponseMessage::kMaxCommands &&
+                    reader.peekType() == JsonReader::Type::OBJECT) {
+                    if (readCommand(reader, out.commands[out.commandCount])) {
+                        ++out.commandCount;
+                    }
+                } else {
+                    reader.skipValue();  // hub sends at most SYNC_MAX_COMMANDS (= kMaxCommands)
+                }
+            }
+        } else {
+            reader.skipValue();
+        }
+    }
+    return reader.ok();
+}
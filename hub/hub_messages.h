@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Typed views of the JSON the hub sends back, filled in one JsonReader pass.
+// Every optional field has a has* flag, so 0 / false / "" are real values
+// and never mean "missing".
+
+// GET /api/command/pending, and each element of "commands" in /api/sync.
+struct HubCommandMessage {
+    char    command[32] = {};  // "" when the hub sent null
+    bool    hasCommand  = false;
+    // "send_ir": a custom button resolved to raw IR data
+    int32_t protocol    = 0;
+    int32_t address     = 0;
+    int32_t irCommand   = 0;
+    bool    hasIr       = false;  // protocol, address and ir_command all present
+    char    name[32]    = {};
+    // Hub config changed; send telemetry now to pick it up from the response.
+    bool    syncRequested = false;
+};
+
+// Responses of /api/telemetry, /api/telemetry/batch and /api/sync.
+struct HubResponseMessage {
+    static constexpr size_t kMaxCommands = 8;
+
+    bool    autoControl        = false;
+    bool    hasAutoControl     = false;
+    float   scheduledTarget    = 0.0f;
+    bool    hasScheduledTarget = false;
+    char    pidMode[8]         = {};
+    bool    hasPidMode         = false;
+    int32_t accepted           = 0;
+    bool    hasAccepted        = false;
+    int32_t retryAfterMs       = 0;
+    HubCommandMessage commands[kMaxCommands];
+    uint8_t commandCount       = 0;
+};
+
+// Both return false on malformed JSON; fields read before the error stay set.
+bool parseHubCommand(const char* json, size_t length, HubCommandMessage& out);
+bool parseHubResponse(const char* json, size_t length, HubResponseMessage& out);
@@ -0,0 +1,78 @@
+#include "hub_worker.h"
+
+#include "../prefferences.h"
+
+#if __has_include(<Arduino.h>)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+HubWorker::HubWorker(HubEndpoint& endpoint, uint32_t periodMs)
+    : endpoint_(endpoint), periodMs_(periodMs) {}
+
+HubWorker::~HubWorker() {
+    stop();
+}
+
+uint32_t HubWorker::nowMs() {
+#if __has_include(<Arduino.h>)
+    return millis();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+bool HubWorker::begin() {
+    if (running_.load()) {
+        return true;
+    }
+    stopRequested_.store(false);
+    running_.store(true);
+#if HUBWORKER_HAS_FREERTOS
+    const BaseType_t created = xTaskCreatePinnedToCore(
+        [](void* self) { static_cast<HubWorker*>(self)->run(); },
+        "hub", kHubWorkerStackBytes, this, kHubWorkerPriority, &task_, kHubWorkerCore);
+    if (created != pdPASS) {
+        task_ = nullptr;
+        running_.store(false);
+        return false;
+    }
+#else
+    thread_ = std::thread([this] { run(); });
+#endif
+    return true;
+}
+
+void HubWorker::stop() {
+#if !HUBWORKER_HAS_FREERTOS
+    stopRequested_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+#endif
+}
+
+void HubWorker::run() {
+    while (!stopRequested_.load()) {
+        const uint32_t startMs = nowMs();
+        endpoint_.service(startMs);
+        const uint32_t elapsedMs = nowMs() - startMs;
+        if (elapsedMs > maxServiceMs_.load()) {
+            maxServiceMs_.store(elapsedMs);
+        }
+#if HUBWORKER_HAS_FREERTOS
+        vTaskDelay(pdMS_TO_TICKS(periodMs_));
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(periodMs_));
+#endif
+    }
+#if HUBWORKER_HAS_FREERTOS
+    // FreeRTOS tasks must not return.
+    running_.store(false);
+    vTaskDelete(nullptr);
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if __has_include(<freertos/FreeRTOS.h>)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define HUBWORKER_HAS_FREERTOS 1
+#else
+#include <thread>
+#define HUBWORKER_HAS_FREERTOS 0
+#endif
+
+#include "hub_endpoint.h"
+
+// Runs a HubEndpoint on its own task so network stalls never reach loop():
+// a FreeRTOS task pinned to kHubWorkerCore on the ESP32, a std::thread on the
+// host. The endpoint is serviced, then the task sleeps periodMs.
+class HubWorker {
+public:
+    explicit HubWorker(HubEndpoint& endpoint, uint32_t periodMs = 10U);
+    ~HubWorker();
+
+    HubWorker(const HubWorker&) = delete;
+    HubWorker& operator=(const HubWorker&) = delete;
+
+    // False if the task could not be created; the caller can then keep
+    // calling endpoint.service() from loop() as before.
+    bool begin();
+    // Host only: asks the thread to exit and joins it. On the ESP32 the task
+    // runs for the life of the firmware.
+    void stop();
+    bool running() const { return running_.load(); }
+
+    // Longest single service() call, for the [HUB] stats line and benches.
+    uint32_t maxServiceMs() const { return maxServiceMs_.load(); }
+
+private:
+    void run();
+    static uint32_t nowMs();
+
+    HubEndpoint& endpoint_;
+    uint32_t     periodMs_;
+    std::atomic<bool>     running_{false};
+    std::atomic<bool>     stopRequested_{false};
+    std::atomic<uint32_t> maxServiceMs_{0};
+#if HUBWORKER_HAS_FREERTOS
+    TaskHandle_t task_ = nullptr;
+#else
+    std::thread  thread_;
+#endif
+};
@@ -0,0 +1,300 @@
+#include "json_reader.h"
+
+#include <cstring>
+
+namespace {
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Appends one byte if there is room, keeping space for the terminator.
+void put(char* out, size_t outSize, size_t& len, char c) {
+    if (len + 1 < outSize) {
+        out[len] = c;
+    }
+    ++len;
+}
+}  // namespace
+
+JsonReader::JsonReader(const char* json, size_t length)
+    : begin_(json), p_(json), end_(json ? json + length : json) {
+    if (json == nullptr) {
+        failed_ = true;
+    }
+}
+
+JsonReader::JsonReader(const char* json)
+    : JsonReader(json, json ? strlen(json) : 0) {}
+
+void JsonReader::skipWhitespace() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+        ++p_;
+    }
+}
+
+bool JsonReader::fail() {
+    failed_ = true;
+    return false;
+}
+
+JsonReader::Type JsonReader::peekType() {
+    if (failed_) return Type::INVALID;
+    skipWhitespace();
+    if (p_ >= end_) return Type::INVALID;
+    switch (*p_) {
+        case '{': return Type::OBJECT;
+        case '[': return Type::ARRAY;
+        case '"': return Type::STRING;
+        case 't':
+        case 'f': return Type::BOOL;
+        case 'n': return Type::NUL;
+        default:
+            return (*p_ == '-' || isDigit(*p_)) ? Type::NUMBER : Type::INVALID;
+    }
+}
+
+bool JsonReader::enterObject() {
+    if (peekType() != Type::OBJECT) return fail();
+    ++p_;
+    return true;
+}
+
+bool JsonReader::enterArray() {
+    if (peekType() != Type::ARRAY) return fail();
+    ++p_;
+    return true;
+}
+
+bool JsonReader::nextKey(const char*& key, size_t& keyLength) {
+    if (failed_) return false;
+    skipWhitespace();
+    if (p_ < end_ && *p_ == '}') {
+        ++p_;
+        return false;
+    }
+    if (p_ < end_ && *p_ == ',') {
+        ++p_;
+        skipWhitespace();
+    }
+    if (p_ >= end_ || *p_ != '"') return fail();
+
+    key = p_ + 1;
+    if (!skipString()) return false;
+    keyLength = static_cast<size_t>(p_ - key - 1);
+
+    skipWhitespace();
+    if (p_ >= end_ || *p_ != ':') return fail();
+    ++p_;
+    return true;
+}
+
+bool JsonReader::nextElement() {
+    if (failed_) return false;
+    skipWhitespace();
+    if (p_ < end_ && *p_ == ']') {
+        ++p_;
+        return false;
+    }
+    if (p_ < end_ && *p_ == ',') {
+        ++p_;
+    }
+    return peekType() != Type::INVALID || fail();
+}
+
+bool JsonReader::skipString() {
+    // p_ is on the opening quote.
+    ++p_;
+    while (p_ < end_) {
+        if (*p_ == '\\') {
+            p_ += 2;
+            continue;
+        }
+        if (*p_++ == '"') return true;
+    }
+    return fail();
+}
+
+bool JsonReader::readString(char* out, size_t outSize) {
+    if (peekType() != Type::STRING || out == nullptr || outSize == 0) return fail();
+    ++p_;
+
+    size_t len = 0;
+    while (p_ < end_ && *p_ != '"') {
+        char c = *p_++;
+        if (c != '\\') {
+            put(out, outSize, len, c);
+            continue;
+        }
+        if (p_ >= end_) break;
+        c = *p_++;
+        switch (c) {
+            case 'n': put(out, outSize, len, '\n'); break;
+            case 't': put(out, outSize, len, '\t'); break;
+            case 'r': put(out, outSize, len, '\r'); break;
+            case 'b': put(out, outSize, len, '\b'); break;
+            case 'f': put(out, outSize, len, '\f'); break;
+            case 'u': {
+                if (end_ - p_ < 4) return fail();
+                uint32_t cp = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int h = hexValue(*p_++);
+                    if (h < 0) return fail();
+                    cp = (cp << 4) | static_cast<uint32_t>(h);
+                }
+                // Encode as UTF-8 (surrogate pairs are passed through as-is).
+                if (cp < 0x80) {
+                    put(out, outSize, len, static_cast<char>(cp));
+                } else if (cp < 0x800) {
+                    put(out, outSize, len, static_cast<char>(0xC0 | (cp >> 6)));
+                    put(out, outSize, len, static_cast<char>(0x80 | (cp & 0x3F)));
+                } else {
+                    put(out, outSize, len, static_cast<char>(0xE0 | (cp >> 12)));
+                    put(out, outSize, len, static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                    put(out, outSize, len, static_cast<char>(0x80 | (cp & 0x3F)));
+                }
+                break;
+            }
+            default:  // \" \\ \/
+                put(out, outSize, len, c);
+                break;
+        }
+    }
+    if (p_ >= end_) return fail();
+    ++p_;  // closing quote
+    out[len < outSize ? len : outSize - 1] = '\0';
+    return true;
+}
+
+bool JsonReader::readNumber(double& out) {
+    if (peekType() != Type::NUMBER) return fail();
+
+    bool negative = false;
+    if (*p_ == '-') {
+        negative = true;
+        ++p_;
+    }
+    if (p_ >= end_ || !isDigit(*p_)) return fail();
+
+    double value = 0.0;
+    while (p_ < end_ && isDigit(*p_)) {
+        value = value * 10.0 + (*p_++ - '0');
+    }
+    if (p_ < end_ && *p_ == '.') {
+        ++p_;
+        double scale = 0.1;
+        if (p_ >= end_ || !isDigit(*p_)) return fail();
+        while (p_ < end_ && isDigit(*p_)) {
+            value += (*p_++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+        ++p_;
+        bool negExp = false;
+        if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+            negExp = (*p_ == '-');
+            ++p_;
+        }
+        if (p_ >= end_ || !isDigit(*p_)) return fail();
+        int exp = 0;
+        while (p_ < end_ && isDigit(*p_)) {
+            if (exp < 400) exp = exp * 10 + (*p_ - '0');
+            ++p_;
+        }
+        for (int i = 0; i < exp; ++i) {
+            value = negExp ? value / 10.0 : value * 10.0;
+        }
+    }
+    out = negative ? -value : value;
+    return true;
+}
+
+bool JsonReader::readInt(int32_t& out) {
+    double value = 0.0;
+    if (!readNumber(value)) return false;
+    if (value > 2147483647.0 || value < -2147483648.0) return fail();
+    out = static_cast<int32_t>(value);
+    return true;
+}
+
+bool JsonReader::readFloat(float& out) {
+    double value = 0.0;
+    if (!readNumber(value)) return false;
+    out = static_cast<float>(value);
+    return true;
+}
+
+bool JsonReader::readBool(bool& out) {
+    if (peekType() != Type::BOOL) return fail();
+    if (end_ - p_ >= 4 && strncmp(p_, "true", 4) == 0) {
+        p_ += 4;
+        out = true;
+        return true;
+    }
+    if (end_ - p_ >= 5 && strncmp(p_, "false", 5) == 0) {
+        p_ += 5;
+        out = false;
+        return true;
+    }
+    return fail();
+}
+
+bool JsonReader::readNull() {
+    if (peekType() != Type::NUL || end_ - p_ < 4 || strncmp(p_, "null", 4) != 0) {
+        return fail();
+    }
+    p_ += 4;
+    return true;
+}
+
+bool JsonReader::skipValue() {
+    switch (peekType()) {
+        case Type::STRING:
+            return skipString();
+        case Type::NUMBER: {
+            double ignored = 0.0;
+            return readNumber(ignored);
+        }
+        case Type::BOOL: {
+            bool ignored = false;
+            return readBool(ignored);
+        }
+        case Type::NUL:
+            return readNull();
+        case Type::OBJECT:
+        case Type::ARRAY: {
+            // Containers are skipped by bracket depth; strings are stepped over
+            // so brackets inside them do not count.
+            int depth = 0;
+            while (p_ < end_) {
+                const char c = *p_;
+                if (c == '"') {
+                    if (!skipString()) return false;
+                    continue;
+                }
+                ++p_;
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if (c == '}' || c == ']') {
+                    if (--depth == 0) return true;
+                }
+            }
+            return fail();
+        }
+        case Type::INVALID:
+        default:
+            return fail();
+    }
+}
+
+bool JsonReader::keyIs(const char* key, size_t keyLength, const char* name) {
+    return key != nullptr && name != nullptr &&
+           strncmp(key, name, keyLength) == 0 && name[keyLength] == '\0';
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// JsonReader: forward-only, allocation-free JSON cursor over a caller-owned
+// buffer. Values are read in document order, so a response is walked exactly
+// once; unknown members are skipped with skipValue(). Strings are unescaped
+// straight into caller buffers and numbers are parsed without strtod, so the
+// same code runs (and is benchmarked) on native builds.
+//
+//   JsonReader r(body, len);
+//   const char* key; size_t keyLen;
+//   if (r.enterObject()) {
+//       while (r.nextKey(key, keyLen)) {
+//           if (JsonReader::keyIs(key, keyLen, "power")) r.readBool(power);
+//           else r.skipValue();
+//       }
+//   }
+//   if (!r.ok()) { ... malformed ... }
+//
+// Any syntax error latches ok() to false and makes every later call fail.
+class JsonReader {
+public:
+    enum class Type : uint8_t {
+        INVALID = 0,  // end of input or not a JSON value
+        OBJECT,
+        ARRAY,
+        STRING,
+        NUMBER,
+        BOOL,
+        NUL,
+    };
+
+    JsonReader(const char* json, size_t length);
+    explicit JsonReader(const char* json);
+
+    // Type of the next value, without consuming it.
+    Type peekType();
+
+    bool enterObject();
+    bool enterArray();
+    // Inside an object: moves to the next member and its value. Returns false
+    // (consuming the '}') when the object ends. key is not NUL-terminated.
+    bool nextKey(const char*& key, size_t& keyLength);
+    // Inside an array: moves to the next element. Returns false (consuming the
+    // ']') when the array ends.
+    bool nextElement();
+
+    // Value readers return false on a type mismatch (which also latches the
+    // error). readString truncates to outSize - 1 and always terminates.
+    bool readString(char* out, size_t outSize);
+    bool readInt(int32_t& out);
+    bool readFloat(float& out);
+    bool readBool(bool& out);
+    bool readNull();
+    bool skipValue();
+
+    bool ok() const { return !failed_; }
+    // Bytes consumed so far (for element spans and tests).
+    size_t offset() const { return static_cast<size_t>(p_ - begin_); }
+
+    static bool keyIs(const char* key, size_t keyLength, const char* name);
+
+private:
+    void skipWhitespace();
+    bool fail();
+    bool readNumber(double& out);
+    bool skipString();
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    bool        failed_ = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-path request counters, used to compare keep-alive against
+// connect-per-request on real hardware.
+//
+// A request is counted by begin(); it then either gets an answer or a
+// transport error (end(), which times it) or never goes out (fail()).
+// Long-poll requests are counted but not timed, as the hub holds them on
+// purpose, so the average is over the timed ones only.
+struct RequestStats {
+    uint32_t requests       = 0;
+    uint32_t failures       = 0;
+    uint32_t connects       = 0;  // requests that had to open a new TCP connection
+    uint32_t timed          = 0;  // requests with a latency below
+    uint32_t lastLatencyMs  = 0;
+    uint32_t maxLatencyMs   = 0;
+    uint64_t totalLatencyMs = 0;
+
+    void begin(bool newConnection) {
+        ++requests;
+        if (newConnection) {
+            ++connects;
+        }
+    }
+
+    // httpCode as HTTPClient returns it: 200 and 304 count as success.
+    void end(int httpCode, uint32_t latencyMs) {
+        ++timed;
+        lastLatencyMs   = latencyMs;
+        totalLatencyMs += latencyMs;
+        if (latencyMs > maxLatencyMs) {
+            maxLatencyMs = latencyMs;
+        }
+        if (httpCode != 200 && httpCode != 304) {
+            ++failures;
+        }
+    }
+
+    void fail() { ++failures; }
+
+    uint32_t averageLatencyMs() const {
+        return timed ? static_cast<uint32_t>(totalLatencyMs / timed) : 0;
+    }
+};
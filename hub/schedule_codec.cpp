@@ -0,0 +1,73 @@
+#include "schedule_codec.h"
+
+#include "../commands.h"
+
+namespace schedule_codec {
+namespace {
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+bool validEntry(const WeeklyEntry& entry) {
+    if (entry.minuteOfWeek >= kMinutesPerWeek) {
+        return false;
+    }
+    if (entry.isSetpoint()) {
+        return (entry.payload & ~WeeklyEntry::kSetpointFlag) != 0U;
+    }
+    const Command command = entry.command();
+    return entry.payload <= 0xFFU &&
+           (command == Command::ON_OFF || command == Command::TEMP_UP ||
+            command == Command::TEMP_DOWN);
+}
+}  // namespace
+
+size_t encode(const WeeklyEntry* entries, size_t count, uint8_t* out, size_t capacity) {
+    const size_t length = kHeaderSize + count * kEntrySize;
+    if (count > kMaxEntries || length > capacity) {
+        return 0;
+    }
+    out[0] = kVersion;
+    putU16(out + 1, static_cast<uint16_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* p = out + kHeaderSize + i * kEntrySize;
+        putU16(p, entries[i].minuteOfWeek);
+        putU16(p + 2, entries[i].payload);
+    }
+    return length;
+}
+
+bool validate(const uint8_t* frame, size_t length, size_t& outCount) {
+    if (length < kHeaderSize || frame[0] != kVersion) {
+        return false;
+    }
+    const size_t count = getU16(frame + 1);
+    if (length < kHeaderSize + count * kEntrySize) {
+        return false;
+    }
+    uint16_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const WeeklyEntry entry = entryAt(frame, i);
+        if (!validEntry(entry) || entry.minuteOfWeek < previous) {
+            return false;
+        }
+        previous = entry.minuteOfWeek;
+    }
+    outCount = count;
+    return true;
+}
+
+WeeklyEntry entryAt(const uint8_t* frame, size_t index) {
+    const uint8_t* p = frame + kHeaderSize + index * kEntrySize;
+    WeeklyEntry entry;
+    entry.minuteOfWeek = getU16(p);
+    entry.payload      = getU16(p + 2);
+    return entry;
+}
+
+}  // namespace schedule_codec
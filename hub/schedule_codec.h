@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../scheduler/weekly_plan.h"
+
+// Packed weekly schedule ("sch2") served by GET /api/schedule?format=sch2.
+// Mirrored by compile_schedule() in thermohub.py. All integers are
+// little-endian.
+//
+//   header  u8 version | u16 entryCount
+//   entry   u16 minuteOfWeek | u16 payload                        = 4 bytes
+//
+// Entries are WeeklyEntry as-is and come sorted by minuteOfWeek (0 = Sunday
+// 00:00). A payload with bit 15 set is a setpoint in 0.01 °C, otherwise its
+// low byte is a Command code.
+namespace schedule_codec {
+
+constexpr uint8_t     kVersion    = 2;
+constexpr const char* kFormatName = "sch2";
+
+constexpr size_t kHeaderSize = 3;
+constexpr size_t kEntrySize  = sizeof(WeeklyEntry);
+constexpr size_t kMaxEntries = 0xFFFF;
+
+// Returns the frame length, or 0 when it does not fit in capacity.
+size_t encode(const WeeklyEntry* entries, size_t count, uint8_t* out, size_t capacity);
+
+// Checks the header, the length, the order and every entry; outCount is the
+// entry count.
+bool validate(const uint8_t* frame, size_t length, size_t& outCount);
+
+// Entry `index` of a validated frame.
+WeeklyEntry entryAt(const uint8_t* frame, size_t index);
+
+// Replaces plan with the frame's entries. A malformed frame, or one with more
+// entries than plan has room for, leaves it untouched.
+template <size_t N>
+bool load(const uint8_t* frame, size_t length, WeeklyPlan<N>& plan) {
+    size_t count = 0;
+    if (!validate(frame, length, count) || count > N) {
+        return false;
+    }
+    plan.clear();
+    for (size_t i = 0; i < count; ++i) {
+        plan.append(entryAt(frame, i));
+    }
+    return true;
+}
+
+}  // namespace schedule_codec
@@ -0,0 +1,68 @@
+#include "schedule_store.h"
+
+#include "schedule_codec.h"
+
+namespace {
+constexpr const char* kFrameKey = "frame";
+constexpr const char* kEtagKey  = "etag";
+}  // namespace
+
+bool ScheduleStore::begin(const char* storageNamespace) {
+#if SCHEDULE_STORE_HAS_PREFERENCES
+    ready_ = storageNamespace != nullptr && prefs_.begin(storageNamespace, false);
+    return ready_;
+#else
+    (void)storageNamespace;
+    return false;
+#endif
+}
+
+bool ScheduleStore::load(uint8_t* frame, size_t capacity, size_t& outLength,
+                         char (&etag)[kEtagSize]) {
+#if SCHEDULE_STORE_HAS_PREFERENCES
+    if (!ready_) {
+        return false;
+    }
+    const size_t length = prefs_.getBytesLength(kFrameKey);
+    size_t count = 0;
+    if (length == 0 || length > capacity || prefs_.getBytes(kFrameKey, frame, length) != length ||
+        !schedule_codec::validate(frame, length, count)) {
+        return false;
+    }
+    etag[0] = '\0';
+    if (prefs_.isKey(kEtagKey)) {
+        prefs_.getString(kEtagKey, etag, kEtagSize);
+    }
+    outLength = length;
+    return true;
+#else
+    (void)frame;
+    (void)capacity;
+    (void)outLength;
+    (void)etag;
+    return false;
+#endif
+}
+
+bool ScheduleStore::save(const uint8_t* frame, size_t length, const char* etag) {
+#if SCHEDULE_STORE_HAS_PREFERENCES
+    if (!ready_) {
+        return false;
+    }
+    if (prefs_.isKey(kEtagKey)) {
+        prefs_.remove(kEtagKey);
+    }
+    if (prefs_.putBytes(kFrameKey, frame, length) != length) {
+        return false;
+    }
+    if (etag && etag[0]) {
+        prefs_.putString(kEtagKey, etag);
+    }
+    return true;
+#else
+    (void)frame;
+    (void)length;
+    (void)etag;
+    return false;
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if __has_include(<Preferences.h>)
+#include <Preferences.h>
+#define SCHEDULE_STORE_HAS_PREFERENCES 1
+#else
+#define SCHEDULE_STORE_HAS_PREFERENCES 0
+#endif
+
+// Keeps the last good schedule_codec frame and its ETag in NVS, so the weekly
+// plan runs from boot, before WiFi or NTP, and the first download after a
+// reboot can be conditional (If-None-Match). The frame and the ETag are
+// separate keys; save() drops the ETag first, so an interrupted save costs an
+// unconditional download, never a stale 304.
+class ScheduleStore {
+public:
+    static constexpr size_t kEtagSize = 32;  // including the terminator
+
+    bool begin(const char* storageNamespace);
+
+    // False when nothing valid is stored. etag gets "" for a frame the hub
+    // sent without one.
+    bool load(uint8_t* frame, size_t capacity, size_t& outLength, char (&etag)[kEtagSize]);
+    bool save(const uint8_t* frame, size_t length, const char* etag);
+
+private:
+#if SCHEDULE_STORE_HAS_PREFERENCES
+    Preferences prefs_;
+#endif
+    bool ready_ = false;
+};
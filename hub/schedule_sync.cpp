@@ -0,0 +1,59 @@
+#include "schedule_sync.h"
+
+#include <cstring>
+
+#include "../diagnostics/diag.h"
+#include "schedule_codec.h"
+
+bool ScheduleSync::begin(const char* storageNamespace) {
+    if (!store_.begin(storageNamespace)) {
+        return false;
+    }
+    uint8_t frame[HubLink::kScheduleFrameSize];
+    size_t length = 0;
+    char etag[ScheduleStore::kEtagSize] = {};
+    if (!store_.load(frame, sizeof(frame), length, etag) || !link_.postSchedule(frame, length)) {
+        return true;
+    }
+    memcpy(etag_, etag, sizeof(etag_));
+    local_ = true;
+    DIAG_LOGF(INFO, "HUB", "Schedule restored from NVS (%s)", etag[0] ? etag : "no ETag");
+    return true;
+}
+
+ScheduleSync::Outcome ScheduleSync::onResponse(int httpCode, const uint8_t* body, size_t length,
+                                               const char* etag) {
+    if (httpCode == 304) {
+        return Outcome::NOT_MODIFIED;
+    }
+    if (httpCode != 200) {
+        return Outcome::RETRY;
+    }
+    if (length > 0 && body[0] == '{') {
+        // Older hub: plain JSON list, so it keeps evaluating the schedule itself.
+        return Outcome::HUB_RUNS_IT;
+    }
+
+    size_t count = 0;
+    if (body == nullptr || !schedule_codec::validate(body, length, count)) {
+        DIAG_LOGF(WARN, "HUB", "schedule: malformed frame");
+        return Outcome::RETRY;
+    }
+    if (length > HubLink::kScheduleFrameSize) {
+        DIAG_LOGF(WARN, "HUB", "schedule: %u entries, room for %u; hub keeps running it",
+                  static_cast<unsigned>(count), static_cast<unsigned>(SchedulePlan::kCapacity));
+        local_   = false;
+        etag_[0] = '\0';
+        return Outcome::HUB_RUNS_IT;
+    }
+    if (!link_.postSchedule(body, length)) {
+        return Outcome::RETRY;  // loop() has not taken the previous one yet
+    }
+    local_ = true;
+    strncpy(etag_, etag ? etag : "", sizeof(etag_) - 1);
+    etag_[sizeof(etag_) - 1] = '\0';
+    const bool saved = store_.save(body, length, etag_);
+    DIAG_LOGF(INFO, "HUB", "Schedule downloaded: %u entries, %s", static_cast<unsigned>(count),
+              saved ? "saved to NVS" : "not saved");
+    return Outcome::APPLIED;
+}
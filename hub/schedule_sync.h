@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hub_link.h"
+#include "schedule_store.h"
+
+// Worker side of the weekly plan download (GET /api/schedule). HubClient does
+// the HTTP and the decryption; this keeps the ETag of the plan loop() runs,
+// decides what a response means, hands new frames to loop() through the
+// HubLink and keeps the last good one in a ScheduleStore.
+class ScheduleSync {
+public:
+    enum class Outcome : uint8_t {
+        NOT_MODIFIED = 0,  // 304: loop() keeps the plan it has
+        APPLIED,           // a new plan went to loop() and, if open, the store
+        HUB_RUNS_IT,       // an older hub's JSON, or more entries than fit
+        RETRY,             // HTTP error, malformed frame or loop() still busy
+    };
+
+    explicit ScheduleSync(HubLink& link) : link_(link) {}
+
+    // Opens the store and hands the plan saved by the last download to loop(),
+    // so it runs before the hub is reachable. False when the store cannot be
+    // opened.
+    bool begin(const char* storageNamespace);
+
+    // If-None-Match for the next download; nullptr without a plan from the hub.
+    const char* etag() const { return etag_[0] ? etag_ : nullptr; }
+    // loop() runs the hub's plan (X-Local-Schedule).
+    bool local() const { return local_; }
+
+    // httpCode as HubClient::exchange() returns it; body is the response
+    // plaintext and etag its ETag header ("" without one).
+    Outcome onResponse(int httpCode, const uint8_t* body, size_t length, const char* etag);
+
+private:
+    HubLink&      link_;
+    ScheduleStore store_{};
+    char          etag_[ScheduleStore::kEtagSize] = {};  // of the plan loop() holds
+    bool          local_ = false;
+};
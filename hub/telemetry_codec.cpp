@@ -0,0 +1,133 @@
+#include "telemetry_codec.h"
+
+#include <cmath>
+
+namespace telemetry_codec {
+namespace {
+constexpr float kNoSensorC = -999.0f;
+
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void putU48(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 6; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint64_t getU48(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 5; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+// Rounds value*scale to the nearest int16, saturating at the ends.
+int16_t toFixed(float value, float scale) {
+    const float scaled = std::round(value * scale);
+    if (scaled >  32767.0f) return  32767;
+    if (scaled < -32768.0f) return -32768;
+    return static_cast<int16_t>(scaled);
+}
+
+float fromFixed(const uint8_t* p, float scale) {
+    return static_cast<int16_t>(getU16(p)) / scale;
+}
+}  // namespace
+
+FrameWriter::FrameWriter(uint8_t* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity) {}
+
+bool FrameWriter::addSample(const TelemetrySample& sample, uint32_t nowMs) {
+    if (logs_ != 0 || samples_ == UINT8_MAX || length_ + kSampleSize > capacity_) {
+        return false;
+    }
+    uint8_t* p = buffer_ + length_;
+
+    const bool noRoom   = sample.roomTempC   <= kNoSensorC;
+    const bool noTarget = sample.targetTempC <= kNoSensorC;
+    uint8_t flags = 0;
+    if (sample.powerOn)      flags |= kSamplePower;
+    if (sample.ecoMode)      flags |= kSampleEco;
+    if (sample.unixMs != 0)  flags |= kSampleWallTime;
+    if (noRoom)              flags |= kSampleNoRoom;
+    if (noTarget)            flags |= kSampleNoTarget;
+
+    p[0] = flags;
+    putU48(p + 1, sample.unixMs != 0 ? sample.unixMs : nowMs - sample.bootMs);
+    putU16(p + 7,  static_cast<uint16_t>(noRoom   ? 0 : toFixed(sample.roomTempC,   100.0f)));
+    putU16(p + 9,  static_cast<uint16_t>(noTarget ? 0 : toFixed(sample.targetTempC, 100.0f)));
+    putU16(p + 11, static_cast<uint16_t>(toFixed(sample.pidP,     100.0f)));
+    putU16(p + 13, static_cast<uint16_t>(toFixed(sample.pidI,     1000.0f)));
+    putU16(p + 15, static_cast<uint16_t>(toFixed(sample.pidD,     100.0f)));
+    putU16(p + 17, static_cast<uint16_t>(toFixed(sample.integral, 1000.0f)));
+    p[19] = static_cast<uint8_t>(sample.pidSteps);
+
+    length_ += kSampleSize;
+    ++samples_;
+    return true;
+}
+
+bool FrameWriter::addLog(uint32_t sequence, const LogEntry& entry) {
+    if (logs_ == UINT8_MAX || length_ + kLogSize > capacity_) {
+        return false;
+    }
+    uint8_t* p = buffer_ + length_;
+
+    uint8_t flags = 0;
+    if (entry.success)       flags |= kLogSuccess;
+    if (entry.wallTimeValid) flags |= kLogWallTime;
+
+    putU32(p, sequence);
+    p[4] = static_cast<uint8_t>(entry.type);
+    p[5] = static_cast<uint8_t>(entry.command);
+    p[6] = flags;
+    p[7] = entry.detailCode;
+    putU48(p + 8, entry.wallTimeValid ? entry.unixMs : 0);
+    putU32(p + 14, entry.uptimeMs);
+
+    length_ += kLogSize;
+    ++logs_;
+    return true;
+}
+
+size_t FrameWriter::finish() {
+    buffer_[0] = kVersion;
+    buffer_[1] = samples_;
+    buffer_[2] = logs_;
+    return length_;
+}
+
+bool decodeSample(const uint8_t* frame, size_t length, size_t index,
+                  uint32_t nowMs, TelemetrySample& out) {
+    if (frame == nullptr || length < kHeaderSize || frame[0] != kVersion ||
+        index >= frame[1] || length < kHeaderSize + (index + 1) * kSampleSize) {
+        return false;
+    }
+    const uint8_t* p = frame + kHeaderSize + index * kSampleSize;
+    const uint8_t flags = p[0];
+    const uint64_t time = getU48(p + 1);
+
+    out = TelemetrySample{};
+    out.unixMs      = (flags & kSampleWallTime) ? time : 0;
+    out.bootMs      = (flags & kSampleWallTime) ? 0 : nowMs - static_cast<uint32_t>(time);
+    out.roomTempC   = (flags & kSampleNoRoom)   ? kNoSensorC : fromFixed(p + 7, 100.0f);
+    out.targetTempC = (flags & kSampleNoTarget) ? kNoSensorC : fromFixed(p + 9, 100.0f);
+    out.pidP        = fromFixed(p + 11, 100.0f);
+    out.pidI        = fromFixed(p + 13, 1000.0f);
+    out.pidD        = fromFixed(p + 15, 100.0f);
+    out.integral    = fromFixed(p + 17, 1000.0f);
+    out.pidSteps    = static_cast<int8_t>(p[19]);
+    out.powerOn     = (flags & kSamplePower) != 0;
+    out.ecoMode     = (flags & kSampleEco) != 0;
+    return true;
+}
+
+}  // namespace telemetry_codec
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../logger.h"
+#include "telemetry_ring.h"
+
+// Packed binary telemetry ("bin1"), the alternative to snprintf JSON once the
+// hub advertises it in X-Telemetry-Formats. Mirrored by decode_telemetry_frame()
+// in thermohub.py. All integers are little-endian.
+//
+//   header  u8 version | u8 sampleCount | u8 logCount
+//   sample  u8 flags | u48 time | i16 room | i16 target      (temps in 0.01 °C)
+//           i16 pidP*100 | i16 pidI*1000 | i16 pidD*100 | i16 integral*1000
+//           i8 pidSteps                                      = 20 bytes
+//   log     u32 seq | u8 type | u8 command | u8 flags | u8 detail
+//           u48 unixMs | u32 bootMs                          = 18 bytes
+//
+// Sample time is unix ms when kSampleWallTime is set, otherwise the age of
+// the sample in ms at encode time. Samples always precede log records.
+namespace telemetry_codec {
+
+constexpr uint8_t     kVersion    = 1;
+constexpr const char* kFormatName = "bin1";
+
+constexpr size_t kHeaderSize = 3;
+constexpr size_t kSampleSize = 20;
+constexpr size_t kLogSize    = 18;
+
+// Sample flags
+constexpr uint8_t kSamplePower    = 0x01;
+constexpr uint8_t kSampleEco      = 0x02;
+constexpr uint8_t kSampleWallTime = 0x04;
+constexpr uint8_t kSampleNoRoom   = 0x08;  // room_temp was the -999 sentinel
+constexpr uint8_t kSampleNoTarget = 0x10;
+
+// Log flags
+constexpr uint8_t kLogSuccess  = 0x01;
+constexpr uint8_t kLogWallTime = 0x02;
+
+class FrameWriter {
+public:
+    FrameWriter(uint8_t* buffer, size_t capacity);
+
+    // Both return false when the frame is full (or a sample follows a log).
+    bool addSample(const TelemetrySample& sample, uint32_t nowMs);
+    bool addLog(uint32_t sequence, const LogEntry& entry);
+
+    // Writes the header and returns the frame length.
+    size_t finish();
+
+private:
+    uint8_t* buffer_;
+    size_t   capacity_;
+    size_t   length_  = kHeaderSize;
+    uint8_t  samples_ = 0;
+    uint8_t  logs_    = 0;
+};
+
+// Reads sample `index` back out of a finished frame (tests and tooling).
+// Age-stamped samples come back with bootMs = nowMs - age.
+bool decodeSample(const uint8_t* frame, size_t length, size_t index,
+                  uint32_t nowMs, TelemetrySample& out);
+
+}  // namespace telemetry_codec
@@ -0,0 +1,56 @@
+#include "telemetry_policy.h"
+
+#include <cmath>
+
+TelemetryPolicy::TelemetryPolicy() = default;
+
+TelemetryPolicy::TelemetryPolicy(const Config& config) : config_(config) {}
+
+bool TelemetryPolicy::moved(float value, float reference, float deadband) {
+    return std::fabs(value - reference) >= deadband;
+}
+
+TelemetryPolicy::Decision TelemetryPolicy::evaluate(const TelemetrySample& sample,
+                                                    uint32_t nowMs) const {
+    if (!hasReference_ || keyframeRequested_ ||
+        nowMs - lastKeyframeMs_ >= config_.keyframeIntervalMs) {
+        return Decision::KEYFRAME;
+    }
+
+    const TelemetrySample& ref = reference_;
+    if (sample.powerOn != ref.powerOn || sample.ecoMode != ref.ecoMode ||
+        sample.pidSteps != ref.pidSteps) {
+        return Decision::CHANGE;
+    }
+    if (moved(sample.roomTempC, ref.roomTempC, config_.roomTempDeadbandC) ||
+        moved(sample.targetTempC, ref.targetTempC, config_.targetTempDeadbandC) ||
+        moved(sample.pidP, ref.pidP, config_.pidDeadband) ||
+        moved(sample.pidI, ref.pidI, config_.pidDeadband) ||
+        moved(sample.pidD, ref.pidD, config_.pidDeadband) ||
+        moved(sample.integral, ref.integral, config_.pidDeadband)) {
+        return Decision::CHANGE;
+    }
+    return Decision::SKIP;
+}
+
+void TelemetryPolicy::accept(const TelemetrySample& sample, uint32_t nowMs, Decision decision) {
+    reference_    = sample;
+    hasReference_ = true;
+    if (decision == Decision::KEYFRAME) {
+        keyframeRequested_ = false;
+        lastKeyframeMs_    = nowMs;
+        ++stats_.keyframes;
+    } else if (decision == Decision::CHANGE) {
+        ++stats_.changes;
+    }
+}
+
+bool TelemetryPolicy::offer(const TelemetrySample& sample, uint32_t nowMs) {
+    ++stats_.evaluated;
+    const Decision decision = evaluate(sample, nowMs);
+    if (decision == Decision::SKIP) {
+        return false;
+    }
+    accept(sample, nowMs, decision);
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include "telemetry_ring.h"
+
+// Decides which telemetry samples are worth sending to the hub.
+//
+// Every sample is compared against the last one accepted for upload. It is
+// sent when any field moved past its deadband (power, mode and PID steps on
+// any change), and a keyframe is sent anyway once keyframeIntervalMs passes
+// without one, so the hub can tell a quiet device from a dead one. Deadbands
+// are measured from the last accepted value, not the previous sample, so a
+// slow drift is still reported once it adds up.
+class TelemetryPolicy {
+public:
+    struct Config {
+        float    roomTempDeadbandC   = 0.2F;
+        float    targetTempDeadbandC = 0.1F;
+        // Applied to the P, I and D terms and the integral.
+        float    pidDeadband         = 0.5F;
+        uint32_t keyframeIntervalMs  = 120000U;
+    };
+
+    enum class Decision : uint8_t {
+        SKIP = 0,
+        CHANGE,    // a field moved past its deadband
+        KEYFRAME,  // nothing changed, but the keyframe interval ran out
+    };
+
+    struct Stats {
+        uint32_t evaluated = 0;
+        uint32_t changes   = 0;
+        uint32_t keyframes = 0;
+    };
+
+    TelemetryPolicy();
+    explicit TelemetryPolicy(const Config& config);
+
+    // Does not change state; call accept() for samples that will be sent.
+    Decision evaluate(const TelemetrySample& sample, uint32_t nowMs) const;
+    // Makes the sample the new reference. Counts toward stats.
+    void accept(const TelemetrySample& sample, uint32_t nowMs, Decision decision);
+    // The next evaluate() returns KEYFRAME.
+    void requestKeyframe() { keyframeRequested_ = true; }
+
+    // Evaluates and accepts in one call; true when the sample should be sent.
+    bool offer(const TelemetrySample& sample, uint32_t nowMs);
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    static bool moved(float value, float reference, float deadband);
+
+    Config          config_{};
+    TelemetrySample reference_{};
+    bool            hasReference_      = false;
+    bool            keyframeRequested_ = false;
+    uint32_t        lastKeyframeMs_    = 0;
+    Stats           stats_{};
+};
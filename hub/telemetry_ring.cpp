@@ -0,0 +1,188 @@
+#include "telemetry_ring.h"
+
+#include <cstdio>
+
+namespace {
+constexpr uint8_t kSpillVersion = 1;
+
+struct SpillMeta {
+    uint8_t version = kSpillVersion;
+    uint8_t head    = 0;
+    uint8_t blocks  = 0;
+    uint8_t offset  = 0;
+};
+
+#if TELEMETRY_RING_HAS_PREFERENCES
+void blockKey(uint8_t index, char (&key)[5]) {
+    snprintf(key, sizeof(key), "b%u", static_cast<unsigned>(index));
+}
+#endif
+}  // namespace
+
+bool TelemetryRing::beginSpill(const char* storageNamespace) {
+#if TELEMETRY_RING_HAS_PREFERENCES
+    if (storageNamespace == nullptr || !prefs_.begin(storageNamespace, false)) {
+        return false;
+    }
+
+    SpillMeta meta{};
+    if (prefs_.getBytes("meta", &meta, sizeof(meta)) == sizeof(meta) &&
+        meta.version == kSpillVersion && meta.head < kMaxBlocks &&
+        meta.blocks <= kMaxBlocks && meta.offset < kBlockSize) {
+        spillHead_   = meta.head;
+        spillBlocks_ = meta.blocks;
+        spillOffset_ = meta.offset;
+        earlierBootBlocks_ = meta.blocks;
+    }
+
+    spillReady_ = true;
+    return true;
+#else
+    (void)storageNamespace;
+    return false;
+#endif
+}
+
+void TelemetryRing::push(const TelemetrySample& sample) {
+    if (count_ == kCapacity) {
+        if (spillReady_) {
+            spillOldest();
+        } else {
+            dropOldest();
+        }
+    }
+    ram_[(head_ + count_) % kCapacity] = sample;
+    ++count_;
+}
+
+size_t TelemetryRing::peek(TelemetrySample* out, size_t maxCount) {
+    if (out == nullptr || maxCount == 0) {
+        return 0;
+    }
+#if TELEMETRY_RING_HAS_PREFERENCES
+    // Only the head block is read; the caller comes back for the rest.
+    while (spillBlocks_ > 0) {
+        std::array<TelemetrySample, kBlockSize> block{};
+        char key[5];
+        blockKey(spillHead_, key);
+        if (prefs_.getBytes(key, block.data(), sizeof(block)) == sizeof(block)) {
+            // From an earlier boot: leading samples without wall time go.
+            size_t undated = 0;
+            while (earlierBootBlocks_ > 0 && spillOffset_ + undated < kBlockSize &&
+                   block[spillOffset_ + undated].unixMs == 0) {
+                ++undated;
+            }
+            if (undated > 0) {
+                pop(undated);
+                dropped_ += static_cast<uint32_t>(undated);
+                continue;
+            }
+            size_t n = 0;
+            while (n < maxCount && spillOffset_ + n < kBlockSize) {
+                if (earlierBootBlocks_ > 0 && block[spillOffset_ + n].unixMs == 0) {
+                    break;  // dropped by the next peek()
+                }
+                out[n] = block[spillOffset_ + n];
+                ++n;
+            }
+            return n;
+        }
+        // Unreadable block: skip it rather than stall the drain.
+        const size_t lost = kBlockSize - spillOffset_;
+        pop(lost);
+        dropped_ += static_cast<uint32_t>(lost);
+    }
+#endif
+    size_t n = 0;
+    while (n < maxCount && n < count_) {
+        out[n] = ram_[(head_ + n) % kCapacity];
+        ++n;
+    }
+    return n;
+}
+
+void TelemetryRing::pop(size_t count) {
+    bool spillChanged = false;
+    while (count > 0 && spillBlocks_ > 0) {
+        const size_t left = kBlockSize - spillOffset_;
+        if (count < left) {
+            spillOffset_ = static_cast<uint8_t>(spillOffset_ + count);
+            count = 0;
+        } else {
+            count -= left;
+            advanceSpillHead();
+        }
+        spillChanged = true;
+    }
+    if (spillChanged) {
+        persistMeta();
+    }
+
+    const size_t n = count < count_ ? count : count_;
+    head_   = (head_ + n) % kCapacity;
+    count_ -= n;
+}
+
+size_t TelemetryRing::size() const {
+    return count_ + spilled();
+}
+
+size_t TelemetryRing::spilled() const {
+    return spillBlocks_ == 0 ? 0 : spillBlocks_ * kBlockSize - spillOffset_;
+}
+
+void TelemetryRing::spillOldest() {
+#if TELEMETRY_RING_HAS_PREFERENCES
+    if (spillBlocks_ == kMaxBlocks) {
+        // Flash is full too: the oldest block makes room.
+        dropped_ += static_cast<uint32_t>(kBlockSize - spillOffset_);
+        advanceSpillHead();
+    }
+
+    std::array<TelemetrySample, kBlockSize> block{};
+    for (size_t i = 0; i < kBlockSize; ++i) {
+        block[i] = ram_[(head_ + i) % kCapacity];
+    }
+
+    char key[5];
+    blockKey(static_cast<uint8_t>((spillHead_ + spillBlocks_) % kMaxBlocks), key);
+    if (prefs_.putBytes(key, block.data(), sizeof(block)) != sizeof(block)) {
+        dropOldest();
+        return;
+    }
+    ++spillBlocks_;
+    head_   = (head_ + kBlockSize) % kCapacity;
+    count_ -= kBlockSize;
+    persistMeta();
+#else
+    dropOldest();
+#endif
+}
+
+void TelemetryRing::advanceSpillHead() {
+    spillHead_   = static_cast<uint8_t>((spillHead_ + 1U) % kMaxBlocks);
+    spillOffset_ = 0;
+    --spillBlocks_;
+    if (earlierBootBlocks_ > 0) {
+        --earlierBootBlocks_;
+    }
+}
+
+void TelemetryRing::dropOldest() {
+    head_ = (head_ + 1U) % kCapacity;
+    --count_;
+    ++dropped_;
+}
+
+void TelemetryRing::persistMeta() {
+#if TELEMETRY_RING_HAS_PREFERENCES
+    if (!spillReady_) {
+        return;
+    }
+    SpillMeta meta{};
+    meta.head   = spillHead_;
+    meta.blocks = spillBlocks_;
+    meta.offset = spillOffset_;
+    prefs_.putBytes("meta", &meta, sizeof(meta));
+#endif
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if __has_include(<Preferences.h>)
+#include <Preferences.h>
+#define TELEMETRY_RING_HAS_PREFERENCES 1
+#else
+#define TELEMETRY_RING_HAS_PREFERENCES 0
+#endif
+
+// One telemetry reading as it was taken, kept until the hub has it.
+struct TelemetrySample {
+    uint64_t unixMs;      // 0 when wall time was not valid yet
+    uint32_t bootMs;
+    float    roomTempC;
+    float    targetTempC;
+    float    pidP;
+    float    pidI;
+    float    pidD;
+    float    integral;
+    int8_t   pidSteps;
+    bool     powerOn;
+    bool     ecoMode;
+};
+
+// Store-and-forward buffer for telemetry the hub has not accepted yet.
+//
+// Samples queue in RAM, oldest first. With spill enabled, a full ring moves
+// its oldest kBlockSize samples into an NVS block instead of dropping them, so
+// an outage can hold up to kCapacity + kMaxBlocks * kBlockSize samples and
+// spilled blocks survive a reboot. Spilled samples are always older than RAM
+// samples, so peek()/pop() read blocks first.
+//
+// bootMs means nothing after a reboot, so a sample restored from an earlier
+// boot without wall time (unixMs == 0) cannot be dated: peek() drops it and
+// counts it in dropped().
+class TelemetryRing {
+public:
+    static constexpr size_t  kCapacity  = 64;
+    static constexpr size_t  kBlockSize = 16;  // samples per NVS block
+    static constexpr uint8_t kMaxBlocks = 8;
+
+    bool beginSpill(const char* storageNamespace);
+
+    // Never fails: when RAM and spill are both full the oldest sample goes.
+    void push(const TelemetrySample& sample);
+    // Copies up to maxCount of the oldest samples without removing them.
+    // Spilled samples come back one NVS block at a time.
+    size_t peek(TelemetrySample* out, size_t maxCount);
+    void pop(size_t count);
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t spilled() const;
+    uint32_t dropped() const { return dropped_; }
+
+private:
+    void spillOldest();
+    void dropOldest();
+    void advanceSpillHead();
+    void persistMeta();
+
+#if TELEMETRY_RING_HAS_PREFERENCES
+    Preferences prefs_;
+#endif
+    std::array<TelemetrySample, kCapacity> ram_{};
+    size_t head_  = 0;
+    size_t count_ = 0;
+
+    // Spilled blocks are [spillHead_, spillHead_ + spillBlocks_) modulo
+    // kMaxBlocks; the first spillOffset_ samples of the head block are gone.
+    uint8_t  spillHead_   = 0;
+    uint8_t  spillBlocks_ = 0;
+    uint8_t  spillOffset_ = 0;
+    uint8_t  earlierBootBlocks_ = 0;  // head blocks restored by beginSpill()
+    bool     spillReady_  = false;
+    uint32_t dropped_     = 0;
+};
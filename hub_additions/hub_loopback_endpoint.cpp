@@ -0,0 +1,52 @@
+#include "hub_loopback_endpoint.h"
+
+#include <chrono>
+#include <thread>
+
+HubLoopbackEndpoint::HubLoopbackEndpoint(HubLink& link) : link_(link) {}
+
+bool HubLoopbackEndpoint::queueCommand(Command command) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queuedCount_ >= kMaxQueued) {
+        return false;
+    }
+    queued_[queuedCount_++] = command;
+    return true;
+}
+
+void HubLoopbackEndpoint::service(uint32_t nowMs) {
+    (void)nowMs;
+    if (link_.suspended() || !link_.wifiConnected()) {
+        return;
+    }
+
+    TelemetrySample sample;
+    while (link_.popTelemetry(sample)) {
+        samplesReceived_.fetch_add(1);
+    }
+    link_.takeUploadRequest();
+
+    const uint32_t latencyMs = latencyMs_.load();
+    if (latencyMs > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs));
+    }
+    exchanges_.fetch_add(1);
+
+    Command commands[kMaxQueued];
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = queuedCount_;
+        for (size_t i = 0; i < count; ++i) {
+            commands[i] = queued_[i];
+        }
+        queuedCount_ = 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        HubEvent event;
+        event.kind    = HubEvent::Kind::COMMAND;
+        event.command = commands[i];
+        link_.postEvent(event);
+    }
+    link_.setHubReachable(true);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "../commands.h"
+#include "hub/hub_endpoint.h"
+#include "hub/hub_link.h"
+
+// Host stand-in for HubClient: a hub "reached" over loopback. Each service()
+// call swallows the queued telemetry, blocks for latencyMs like a slow or
+// dead hub would, and then delivers any commands queued with queueCommand().
+// Used to measure how loop() behaves while the worker is stuck.
+class HubLoopbackEndpoint : public HubEndpoint {
+public:
+    explicit HubLoopbackEndpoint(HubLink& link);
+
+    void service(uint32_t nowMs) override;
+
+    // Simulated time per exchange, e.g. kHubHttpTimeoutMs for a hub that is down.
+    void setLatencyMs(uint32_t latencyMs) { latencyMs_.store(latencyMs); }
+    // Any thread: delivered on the next service().
+    bool queueCommand(Command command);
+
+    uint32_t samplesReceived() const { return samplesReceived_.load(); }
+    uint32_t exchanges() const       { return exchanges_.load(); }
+
+private:
+    static constexpr size_t kMaxQueued = 8;
+
+    HubLink& link_;
+    std::atomic<uint32_t> latencyMs_{0};
+    std::atomic<uint32_t> samplesReceived_{0};
+    std::atomic<uint32_t> exchanges_{0};
+
+    std::mutex mutex_;
+    Command    queued_[kMaxQueued] = {};
+    size_t     queuedCount_        = 0;
+};
@@ -0,0 +1,118 @@
+#include "log_drain.h"
+
+#include <cstdio>
+
+#if __has_include(<Arduino.h>)
+#include <Arduino.h>
+#define LOGDRAIN_HAS_SERIAL 1
+#else
+#include <chrono>
+#define LOGDRAIN_HAS_SERIAL 0
+#endif
+
+LogDrain::~LogDrain() {
+    stop();
+}
+
+bool LogDrain::begin() {
+    if (running_.load()) {
+        return true;
+    }
+    stopRequested_.store(false);
+    running_.store(true);
+#if LOGDRAIN_HAS_FREERTOS
+    const BaseType_t created = xTaskCreatePinnedToCore(
+        [](void* self) { static_cast<LogDrain*>(self)->run(); },
+        "logdrain", kLogDrainStackBytes, this, kLogDrainPriority, &task_, kLogDrainCore);
+    if (created != pdPASS) {
+        task_ = nullptr;
+        running_.store(false);
+        return false;
+    }
+#else
+    thread_ = std::thread([this] { run(); });
+#endif
+    return true;
+}
+
+void LogDrain::stop() {
+#if !LOGDRAIN_HAS_FREERTOS
+    stopRequested_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+#endif
+}
+
+void LogDrain::run() {
+    while (!stopRequested_.load()) {
+        drain();
+#if LOGDRAIN_HAS_FREERTOS
+        vTaskDelay(pdMS_TO_TICKS(kLogDrainPeriodMs));
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(kLogDrainPeriodMs));
+#endif
+    }
+    drain();
+#if LOGDRAIN_HAS_FREERTOS
+    running_.store(false);
+    vTaskDelete(nullptr);
+#endif
+}
+
+size_t LogDrain::drain(size_t maxEntries) {
+    char line[kLogLineMax];
+    size_t count = 0;
+    PackedLogEntry entry{};
+    while (count < maxEntries && queue_.pop(entry)) {
+        write(line, formatLogEntry(entry, line, sizeof(line)));
+        printed_.fetch_add(1, std::memory_order_relaxed);
+        ++count;
+    }
+
+    // Drops happen while the ring is full, so they follow what was just printed.
+    const uint32_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped_) {
+        const int length = std::snprintf(line, sizeof(line), "[LOG] %lu entries dropped\n",
+                                         static_cast<unsigned long>(dropped - reportedDropped_));
+        reportedDropped_ = dropped;
+        if (length > 0) {
+            write(line, static_cast<size_t>(length));
+        }
+    }
+    return count;
+}
+
+// Writes only what the UART can take without blocking and yields while it
+// drains, so a burst of lines never holds the CPU at 115200 baud.
+void LogDrain::write(const char* text, size_t length) {
+#if LOGDRAIN_HAS_SERIAL
+    while (length > 0) {
+        const int room = Serial.availableForWrite();
+        if (room <= 0) {
+#if LOGDRAIN_HAS_FREERTOS
+            vTaskDelay(1);
+#endif
+            continue;
+        }
+        const size_t chunk = static_cast<size_t>(room) < length ? static_cast<size_t>(room) : length;
+        Serial.write(reinterpret_cast<const uint8_t*>(text), chunk);
+        text += chunk;
+        length -= chunk;
+    }
+#else
+    std::fwrite(text, 1, length, stdout);
+    std::fflush(stdout);
+#endif
+}
+
+LogDrain::Stats LogDrain::stats() const {
+    Stats stats;
+    stats.posted    = posted_.load(std::memory_order_relaxed);
+    stats.printed   = printed_.load(std::memory_order_relaxed);
+    stats.dropped   = dropped_.load(std::memory_order_relaxed);
+    stats.overflows = overflows_.load(std::memory_order_relaxed);
+    stats.maxDepth  = maxDepth_.load(std::memory_order_relaxed);
+    return stats;
+}
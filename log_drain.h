@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if __has_include(<freertos/FreeRTOS.h>)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define LOGDRAIN_HAS_FREERTOS 1
+#else
+#include <thread>
+#define LOGDRAIN_HAS_FREERTOS 0
+#endif
+
+#include "core/spsc_queue.h"
+#include "log_entry.h"
+#include "prefferences.h"
+
+// Takes "[LOG]" printing off the task that logs. post() only pushes the
+// 12-byte entry into a lock-free ring; a low-priority task formats queued
+// entries and writes each line in chunks the UART has room for, so it never
+// blocks in the serial driver either. Entries that find the ring full are
+// dropped and counted, and the next line printed says how many were lost.
+//
+// One task may post() (the Logger's producer); drain() runs on the drain
+// task, or from loop() when the task could not be started.
+class LogDrain {
+public:
+    struct Stats {
+        uint32_t posted    = 0;
+        uint32_t printed   = 0;
+        uint32_t dropped   = 0;  // entries lost to a full ring
+        uint32_t overflows = 0;  // times the ring filled up
+        uint32_t maxDepth  = 0;  // most entries queued at once
+    };
+
+    LogDrain() = default;
+    ~LogDrain();
+
+    LogDrain(const LogDrain&) = delete;
+    LogDrain& operator=(const LogDrain&) = delete;
+
+    // Producer side; never blocks.
+    bool post(const PackedLogEntry& entry) {
+        if (kDiagnosticsLogLevel < 2U) {
+            return true;
+        }
+        posted_.fetch_add(1, std::memory_order_relaxed);
+        if (!queue_.push(entry)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            if (!overflowing_) {
+                overflowing_ = true;
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return false;
+        }
+        overflowing_ = false;
+        const uint32_t depth = static_cast<uint32_t>(queue_.size());
+        if (depth > maxDepth_.load(std::memory_order_relaxed)) {
+            maxDepth_.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // False if the task could not be created; loop() then calls drain().
+    bool begin();
+    // Host only: asks the thread to exit and joins it.
+    void stop();
+    bool running() const { return running_.load(); }
+
+    // Prints up to maxEntries queued entries; returns how many it printed.
+    size_t drain(size_t maxEntries = kLogDrainQueueDepth);
+    Stats stats() const;
+
+private:
+    void run();
+    static void write(const char* text, size_t length);
+
+    SpscQueue<PackedLogEntry, kLogDrainQueueDepth + 1> queue_;
+    bool overflowing_ = false;  // producer only
+    uint32_t reportedDropped_ = 0;  // consumer only
+    std::atomic<uint32_t> posted_{0};
+    std::atomic<uint32_t> printed_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> overflows_{0};
+    std::atomic<uint32_t> maxDepth_{0};
+    std::atomic<bool>     running_{false};
+    std::atomic<bool>     stopRequested_{false};
+#if LOGDRAIN_HAS_FREERTOS
+    TaskHandle_t task_ = nullptr;
+#else
+    std::thread  thread_;
+#endif
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "commands.h"
+#include "time/wall_clock.h"
+
+enum class LogEventType : uint8_t {
+    COMMAND_SENT = 0,
+    COMMAND_DROPPED = 1,
+    HUB_COMMAND_RX = 2, // command rescieved from hub
+    SCHEDULE_COMMAND = 3,
+    STATE_CHANGE = 4,
+    THERMOSTAT_CONTROL = 5,
+    TRANSMIT_FAILED = 6,
+    IR_FRAME_RX = 7, // raw IR frame received from hardware
+    HUB_LINK_DOWN = 8, // a hub endpoint's circuit breaker opened
+    HUB_LINK_UP = 9, // ... and closed again; detail = probes it took
+};
+
+struct LogEntry {
+    uint32_t uptimeMs; // milliseconds since device boot
+    uint32_t uptimeUs;
+    uint64_t unixMs; // Unix epoch timestamp in milliseconds 
+    uint32_t dateKey; //  calendar date as YYYYMMDD
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;
+    bool wallTimeValid;
+    LogEventType type;
+    Command command;
+    bool success;
+    uint8_t detailCode; //  extra status/error code
+};
+
+// LogEntry as the Logger stores it, bit-packed into three words:
+//   words[0]  uptime ms
+//   words[1]  wall ms since kEpochUnixMs, low 32 bits
+//   words[2]  bits 0-6 wall ms high bits (39 bits total, 0 = no wall time),
+//             7-13 UTC offset in quarter hours + 64, 14-17 type,
+//             18-22 command, 23 success, 24-31 detail code
+// The calendar fields (and uptimeUs, which becomes uptimeMs * 1000) are
+// expanded on read.
+struct PackedLogEntry {
+    static constexpr uint64_t kEpochUnixMs = 1704067200000ULL;  // 2024-01-01 UTC
+    uint32_t words[3];
+
+    static PackedLogEntry pack(const WallClockSnapshot& timestamp, LogEventType type,
+                               Command command, bool success, uint8_t detailCode);
+    LogEntry unpack() const;
+};
+static_assert(sizeof(PackedLogEntry) == 12, "PackedLogEntry must stay 12 bytes");
+
+// Longest "[LOG] ..." line formatLogEntry() writes, with the NUL.
+constexpr size_t kLogLineMax = 96;
+
+// Writes entry's "[LOG] ...\n" line into out (NUL-terminated, truncated to
+// size) and returns its length.
+size_t formatLogEntry(const PackedLogEntry& entry, char* out, size_t size);
+// Formats and prints one line synchronously when kDiagnosticsLogLevel >= 2.
+void printLogEntry(const PackedLogEntry& entry);
@@ -0,0 +1,451 @@
+#include "log_storage.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#if LOG_STORAGE_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if LOG_STORAGE_HAS_NVS
+namespace {
+constexpr uint16_t kLegacyVersion      = 2;  // header + the whole ring in one blob
+constexpr size_t   kLegacyCapacity     = 128;
+constexpr uint16_t kPersistenceVersion = 3;  // packed entries in segment keys
+
+// v2 metadata header and entry, only read to migrate an old namespace.
+struct LoggerPersistentHeader {
+    uint16_t version = kLegacyVersion;
+    uint16_t nextIndex = 0;
+    uint16_t size = 0;
+};
+
+struct LegacyLogEntry {
+    uint32_t uptimeMs;
+    uint32_t uptimeUs;
+    uint64_t unixMs;
+    uint32_t dateKey;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;
+    bool wallTimeValid;
+    LogEventType type;
+    Command command;
+    bool success;
+    uint8_t detailCode;
+};
+
+// One persisted segment: the first `count` entries of ring slots
+// [segment * kSegmentSize, ...), starting at sequence `base`.
+struct LoggerSegment {
+    uint32_t base;
+    uint32_t count;
+    PackedLogEntry entries[NvsLogStorage::kSegmentSize];
+};
+
+uint32_t layoutFor(size_t capacity) {
+    return (static_cast<uint32_t>(kPersistenceVersion) << 16) | static_cast<uint32_t>(capacity);
+}
+
+void segmentKey(uint16_t segment, char (&key)[8]) {
+    snprintf(key, sizeof(key), "s%u", static_cast<unsigned>(segment));
+}
+}  // namespace
+
+// ── NVS ───────────────────────────────────────────────────────
+bool NvsLogStorage::begin(const char* storageNamespace, size_t capacity) {
+    // Segment keys are "s0".."s65535".
+    ready_ = capacity / kSegmentSize <= UINT16_MAX && prefs_.begin(storageNamespace, false);
+    return ready_;
+}
+
+size_t NvsLogStorage::restore(PackedLogEntry* ring, size_t capacity, uint32_t& next) {
+    if (!ready_) {
+        return 0;
+    }
+    if (prefs_.getUInt("layout", 0) == layoutFor(capacity)) {
+        return restoreSegments(ring, capacity, next);
+    }
+
+    // First boot on this layout: keep what a v2 namespace held, written once
+    // in the new format.
+    const size_t migrated = restoreLegacy(ring, capacity);
+    prefs_.clear();
+    prefs_.putUInt("layout", layoutFor(capacity));
+    next = static_cast<uint32_t>(migrated);
+    if (migrated > 0) {
+        append(ring, capacity, 0, next);
+    }
+    return migrated;
+}
+
+// Rebuilds the newest contiguous run of persisted entries, one segment
+// buffer at a time: a pass over every key finds the newest sequence, then
+// the walk back stops at the first sequence no segment holds (a missing
+// segment, or one left over from the previous lap).
+size_t NvsLogStorage::restoreSegments(PackedLogEntry* ring, size_t capacity, uint32_t& next) {
+    const size_t segments = capacity / kSegmentSize;
+    LoggerSegment segment{};
+    char key[8];
+    auto load = [&](size_t s) {
+        segmentKey(static_cast<uint16_t>(s), key);
+        return prefs_.getBytes(key, &segment, sizeof(segment)) == sizeof(segment) &&
+               segment.count != 0 && segment.count <= kSegmentSize &&
+               segment.base % capacity == s * kSegmentSize;
+    };
+
+    uint32_t newest = 0;
+    for (size_t s = 0; s < segments; ++s) {
+        if (load(s) && segment.base + segment.count > newest) {
+            newest = segment.base + segment.count;
+        }
+    }
+
+    uint32_t oldest = newest;
+    while (oldest > 0 && newest - oldest < capacity) {
+        const uint32_t sequence = oldest - 1U;
+        const size_t s = (sequence % capacity) / kSegmentSize;
+        if (!load(s) || sequence < segment.base || sequence >= segment.base + segment.count) {
+            break;
+        }
+        uint32_t from = segment.base;
+        if (newest - from > capacity) {
+            from = newest - static_cast<uint32_t>(capacity);
+        }
+        for (uint32_t seq = from; seq <= sequence; ++seq) {
+            ring[seq % capacity] = segment.entries[seq - segment.base];
+        }
+        oldest = from;
+    }
+    next = newest;
+    return newest - oldest;
+}
+
+size_t NvsLogStorage::restoreLegacy(PackedLogEntry* ring, size_t capacity) {
+    LoggerPersistentHeader header{};
+    if (prefs_.getBytes("header", &header, sizeof(header)) != sizeof(header) ||
+        header.version != kLegacyVersion || header.nextIndex >= kLegacyCapacity ||
+        header.size > kLegacyCapacity || header.size == 0) {
+        return 0;
+    }
+    // One-off at the first boot after the upgrade, so the 4 KB comes from
+    // the heap rather than sitting in RAM for good.
+    std::unique_ptr<LegacyLogEntry[]> legacy(new (std::nothrow) LegacyLogEntry[kLegacyCapacity]);
+    const size_t legacyBytes = sizeof(LegacyLogEntry) * kLegacyCapacity;
+    if (!legacy || prefs_.getBytes("entries", legacy.get(), legacyBytes) != legacyBytes) {
+        return 0;
+    }
+
+    // The newest entries when the ring is smaller than the old one.
+    const size_t count = header.size < capacity ? header.size : capacity;
+    for (size_t i = 0; i < count; ++i) {
+        const LegacyLogEntry& old = legacy[(header.nextIndex + kLegacyCapacity - count + i) % kLegacyCapacity];
+        WallClockSnapshot timestamp{};
+        timestamp.bootMs  = old.uptimeMs;
+        timestamp.valid   = old.wallTimeValid;
+        timestamp.unixMs  = old.unixMs;
+        timestamp.dateKey = old.dateKey;
+        timestamp.hour    = old.hour;
+        timestamp.minute  = old.minute;
+        timestamp.second  = old.second;
+        ring[i] = PackedLogEntry::pack(timestamp, old.type, old.command, old.success, old.detailCode);
+    }
+    return count;
+}
+
+void NvsLogStorage::append(const PackedLogEntry* ring, size_t capacity, uint32_t first, uint32_t end) {
+    if (!ready_) {
+        return;
+    }
+    // One write per segment the range touches, at its last sequence there.
+    for (uint32_t sequence = first; sequence < end; ++sequence) {
+        if (sequence % kSegmentSize == kSegmentSize - 1U || sequence + 1U == end) {
+            writeSegment(ring, capacity, sequence);
+        }
+    }
+}
+
+// Rewrites the segment holding `sequence`'s slot, up to and including it.
+// The earlier slots of that segment were filled in the same lap, so the blob
+// is always a prefix of the segment.
+void NvsLogStorage::writeSegment(const PackedLogEntry* ring, size_t capacity, uint32_t sequence) {
+    const size_t slot = sequence % capacity;
+    const size_t segmentIndex = slot / kSegmentSize;
+    LoggerSegment segment{};
+    segment.count = static_cast<uint32_t>(slot % kSegmentSize + 1U);
+    segment.base  = sequence - (segment.count - 1U);
+    for (size_t i = 0; i < segment.count; ++i) {
+        segment.entries[i] = ring[segmentIndex * kSegmentSize + i];
+    }
+
+    char key[8];
+    segmentKey(static_cast<uint16_t>(segmentIndex), key);
+    prefs_.putBytes(key, &segment, sizeof(segment));
+}
+#endif
+
+#if LOG_STORAGE_HAS_PARTITION
+// ── Flash partition ───────────────────────────────────────────
+bool PartitionLogStorage::begin(const char* label, size_t capacity) {
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition_ == nullptr) {
+        return false;
+    }
+    // Sector 0 holds the format marker, the records follow it.
+    const uint32_t sectors = static_cast<uint32_t>(partition_->size / kSectorSize);
+    records_ = sectors > 1U ? (sectors - 1U) * kRecordsPerSector : 0U;
+    if (records_ < capacity + kRecordsPerSector) {
+        partition_ = nullptr;
+        return false;
+    }
+
+    // Whatever the partition held before is not ours: wipe it once.
+    uint32_t format = 0;
+    if (esp_partition_read(partition_, 0, &format, sizeof(format)) != ESP_OK) {
+        partition_ = nullptr;
+        return false;
+    }
+    if (format != kFormat) {
+        if (esp_partition_erase_range(partition_, 0, partition_->size) != ESP_OK ||
+            esp_partition_write(partition_, 0, &kFormat, sizeof(kFormat)) != ESP_OK) {
+            partition_ = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PartitionLogStorage::recordOffset(uint32_t index) {
+    return kSectorSize + static_cast<size_t>(index) * sizeof(Record);
+}
+
+bool PartitionLogStorage::readRecord(uint32_t index, Record& record) const {
+    return esp_partition_read(partition_, recordOffset(index), &record, sizeof(record)) == ESP_OK;
+}
+
+bool PartitionLogStorage::recordErased(uint32_t index) const {
+    Record record{};
+    if (!readRecord(index, record)) {
+        return false;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    for (size_t i = 0; i < sizeof(record); ++i) {
+        if (bytes[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PartitionLogStorage::restore(PackedLogEntry* ring, size_t capacity, uint32_t& next) {
+    if (partition_ == nullptr) {
+        return 0;
+    }
+
+    // Newest complete record. Sequences only grow, so it is also the last
+    // one written.
+    bool found = false;
+    uint32_t newest = 0;
+    uint32_t newestIndex = 0;
+    Record record{};
+    for (uint32_t i = 0; i < records_; ++i) {
+        if (!readRecord(i, record) || record.sequence == kEmpty) {
+            continue;
+        }
+        if (!found || record.sequence > newest) {
+            found = true;
+            newest = record.sequence;
+            newestIndex = i;
+        }
+    }
+
+    // Continue after it in a clean slot; a torn record (entry written,
+    // sequence not) costs the rest of its sector.
+    writeIndex_ = found ? (newestIndex + 1U) % records_ : 0U;
+    if (writeIndex_ % kRecordsPerSector == 0U || !recordErased(writeIndex_)) {
+        writeIndex_ = ((writeIndex_ + kRecordsPerSector - 1U) / kRecordsPerSector) * kRecordsPerSector % records_;
+        esp_partition_erase_range(partition_, recordOffset(writeIndex_), kSectorSize);
+    }
+    if (!found) {
+        return 0;
+    }
+
+    // Walk back while the sequences stay contiguous, stepping over the empty
+    // slots a torn record left behind.
+    size_t count = 0;
+    uint32_t index = newestIndex;
+    for (uint32_t step = 0; step < records_ && count < capacity && count <= newest; ++step) {
+        const uint32_t expected = newest - static_cast<uint32_t>(count);
+        if (!readRecord(index, record)) {
+            break;
+        }
+        index = (index + records_ - 1U) % records_;
+        if (record.sequence == kEmpty) {
+            continue;
+        }
+        if (record.sequence != expected) {
+            break;
+        }
+        ring[expected % capacity] = record.entry;
+        ++count;
+    }
+    next = newest + 1U;
+    return count;
+}
+
+void PartitionLogStorage::append(const PackedLogEntry* ring, size_t capacity, uint32_t first, uint32_t end) {
+    if (partition_ == nullptr) {
+        return;
+    }
+    for (uint32_t sequence = first; sequence < end; ++sequence) {
+        const size_t offset = recordOffset(writeIndex_);
+        // Entry first: until its sequence lands the record still reads as empty.
+        esp_partition_write(partition_, offset + sizeof(uint32_t), &ring[sequence % capacity],
+                            sizeof(PackedLogEntry));
+        esp_partition_write(partition_, offset, &sequence, sizeof(sequence));
+
+        writeIndex_ = (writeIndex_ + 1U) % records_;
+        if (writeIndex_ % kRecordsPerSector == 0U) {
+            esp_partition_erase_range(partition_, recordOffset(writeIndex_), kSectorSize);
+        }
+    }
+}
+#endif
+
+#if LOG_STORAGE_HAS_MMAP
+// ── Mapped file ───────────────────────────────────────────────
+namespace {
+constexpr uint32_t kFileMagic   = 0x474C5452U;  // "RTLG"
+constexpr uint16_t kFileVersion = 1;
+constexpr size_t   kMinRecords  = 4096;
+}  // namespace
+
+MappedFileLogStorage::~MappedFileLogStorage() {
+    close();
+}
+
+bool MappedFileLogStorage::map(size_t bytes) {
+    if (header_ != nullptr) {
+        munmap(header_, mappedBytes_);
+        header_ = nullptr;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+        return false;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    header_ = static_cast<Header*>(mapped);
+    mappedBytes_ = bytes;
+    return true;
+}
+
+PackedLogEntry* MappedFileLogStorage::recordsBegin() const {
+    return reinterpret_cast<PackedLogEntry*>(reinterpret_cast<uint8_t*>(header_) + sizeof(Header));
+}
+
+bool MappedFileLogStorage::begin(const char* path, size_t capacity) {
+    (void)capacity;
+    close();
+    fd_ = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd_, &info) != 0) {
+        close();
+        return false;
+    }
+
+    Header existing{};
+    const bool valid = static_cast<size_t>(info.st_size) >= sizeof(Header) &&
+                       pread(fd_, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+                       existing.magic == kFileMagic && existing.version == kFileVersion &&
+                       existing.count <= (static_cast<uint64_t>(info.st_size) - sizeof(Header)) /
+                                             sizeof(PackedLogEntry);
+    const uint64_t count = valid ? existing.count : 0U;
+    size_t reserved = kMinRecords;
+    while (reserved < count) {
+        reserved *= 2U;
+    }
+    if (!map(sizeof(Header) + reserved * sizeof(PackedLogEntry))) {
+        close();
+        return false;
+    }
+    if (!valid) {
+        *header_ = Header{kFileMagic, kFileVersion, 0, 0, 0, 0};
+    }
+    return true;
+}
+
+void MappedFileLogStorage::close() {
+    if (header_ != nullptr) {
+        const size_t used = sizeof(Header) + static_cast<size_t>(header_->count) * sizeof(PackedLogEntry);
+        munmap(header_, mappedBytes_);
+        header_ = nullptr;
+        mappedBytes_ = 0;
+        // On failure the file keeps its spare tail; begin() only trusts count.
+        const int trimmed = ftruncate(fd_, static_cast<off_t>(used));
+        (void)trimmed;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+size_t MappedFileLogStorage::restore(PackedLogEntry* ring, size_t capacity, uint32_t& next) {
+    if (header_ == nullptr || header_->count == 0) {
+        return 0;
+    }
+    const uint64_t count = header_->count;
+    const size_t n = count < capacity ? static_cast<size_t>(count) : capacity;
+    const PackedLogEntry* records = recordsBegin();
+    next = header_->firstSequence + static_cast<uint32_t>(count);
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t sequence = next - static_cast<uint32_t>(n - i);
+        ring[sequence % capacity] = records[count - n + i];
+    }
+    return n;
+}
+
+void MappedFileLogStorage::append(const PackedLogEntry* ring, size_t capacity, uint32_t first, uint32_t end) {
+    if (header_ == nullptr) {
+        return;
+    }
+    if (header_->count == 0) {
+        header_->firstSequence = first;
+    }
+    for (uint32_t sequence = first; sequence < end; ++sequence) {
+        const uint64_t count = header_->count;
+        if (sequence != header_->firstSequence + static_cast<uint32_t>(count)) {
+            continue;  // already stored
+        }
+        const size_t needed = sizeof(Header) + (static_cast<size_t>(count) + 1U) * sizeof(PackedLogEntry);
+        if (needed > mappedBytes_ && !map(sizeof(Header) + (mappedBytes_ - sizeof(Header)) * 2U)) {
+            return;
+        }
+        recordsBegin()[count] = ring[sequence % capacity];
+        header_->count = count + 1U;
+    }
+}
+
+uint64_t MappedFileLogStorage::recordCount() const {
+    return header_ != nullptr ? header_->count : 0U;
+}
+
+uint32_t MappedFileLogStorage::firstSequence() const {
+    return header_ != nullptr ? header_->firstSequence : 0U;
+}
+
+const PackedLogEntry* MappedFileLogStorage::records() const {
+    return header_ != nullptr ? recordsBegin() : nullptr;
+}
+#endif
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "log_entry.h"
+
+#if __has_include(<Preferences.h>)
+#include <Preferences.h>
+#define LOG_STORAGE_HAS_NVS 1
+#else
+#define LOG_STORAGE_HAS_NVS 0
+#endif
+
+#if __has_include(<esp_partition.h>)
+#include <esp_partition.h>
+#define LOG_STORAGE_HAS_PARTITION 1
+#else
+#define LOG_STORAGE_HAS_PARTITION 0
+#endif
+
+// Host builds only; the device has no use for a mapped file.
+#if !LOG_STORAGE_HAS_PARTITION && __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define LOG_STORAGE_HAS_MMAP 1
+#else
+#define LOG_STORAGE_HAS_MMAP 0
+#endif
+
+// Storage policies for EventLogger<N, Storage>. Each one provides:
+//
+//   kCapacityMultiple           N must be a multiple of it
+//   begin(name, capacity)       opens the backing store; false = no persistence
+//   restore(ring, capacity, next)
+//                               writes the newest persisted run into its ring
+//                               slots (sequence % capacity), sets next to the
+//                               sequence after it and returns its length.
+//                               0 = nothing stored, ring left untouched.
+//   append(ring, capacity, first, end)
+//                               persists sequences [first, end), which sit in
+//                               ring[sequence % capacity]
+//
+// Sequences count every entry the logger has persisted, across reboots.
+
+// ── RAM only ──────────────────────────────────────────────────
+class RamLogStorage {
+public:
+    static constexpr size_t kCapacityMultiple = 1;
+
+    bool begin(const char*, size_t) { return false; }
+    size_t restore(PackedLogEntry*, size_t, uint32_t&) { return 0; }
+    void append(const PackedLogEntry*, size_t, uint32_t, uint32_t) {}
+};
+
+#if LOG_STORAGE_HAS_NVS
+// ── NVS (Preferences) ─────────────────────────────────────────
+// The ring is sharded into kSegmentSize-entry keys and each append rewrites
+// only the segment holding the new entry (NVS replaces a key atomically).
+// restore() returns the newest contiguous run of segments, at least
+// capacity - kSegmentSize + 1 entries once the ring has wrapped. A namespace
+// written with another layout or capacity is cleared; the old single-blob
+// format is migrated.
+class NvsLogStorage {
+public:
+    static constexpr size_t kSegmentSize      = 8;
+    static constexpr size_t kCapacityMultiple = kSegmentSize;
+
+    bool begin(const char* storageNamespace, size_t capacity);
+    size_t restore(PackedLogEntry* ring, size_t capacity, uint32_t& next);
+    void append(const PackedLogEntry* ring, size_t capacity, uint32_t first, uint32_t end);
+
+private:
+    size_t restoreSegments(PackedLogEntry* ring, size_t capacity, uint32_t& next);
+    size_t restoreLegacy(PackedLogEntry* ring, size_t capacity);
+    void writeSegment(const PackedLogEntry* ring, size_t capacity, uint32_t sequence);
+
+    Preferences prefs_;
+    bool ready_ = false;
+};
+#endif
+
+#if LOG_STORAGE_HAS_PARTITION
+// ── Raw flash partition ───────────────────────────────────────
+// Appends 16-byte records {sequence, entry} to a data partition used as a
+// circular log, so an event costs 16 bytes of flash instead of a rewritten
+// NVS segment. The entry is written before its sequence, so a record torn by
+// a reset reads as empty. Sectors are erased just before the log reaches
+// them; the partition needs a marker sector plus room for capacity + one
+// sector of records. Needs a partition table with a data partition of that
+// label.
+class PartitionLogStorage {
+public:
+    static constexpr size_t kCapacityMultiple = 1;
+
+    bool begin(const char* label, size_t capacity);
+    size_t restore(PackedLogEntry* ring, size_t capacity, uint32_t& next);
+    void append(const PackedLogEntry* ring, size_t capacity, uint32_t first, uint32_t end);
+
+private:
+    struct Record {
+        uint32_t sequence;
+        PackedLogEntry entry;
+    };
+    static_assert(sizeof(Record) == 16, "records must tile flash sectors");
+    static constexpr uint32_t kSectorSize       = 4096;
+    static constexpr uint32_t kRecordsPerSector = kSectorSize / sizeof(Record);
+    static constexpr uint32_t kEmpty            = 0xFFFFFFFFU;
+    static constexpr uint32_t kFormat           = 0x4C544552U;  // "RETL", v1 records
+
+    static size_t recordOffset(uint32_t index);
+    bool readRecord(uint32_t index, Record& record) const;
+    bool recordErased(uint32_t index) const;
+
+    const esp_partition_t* partition_ = nullptr;
+    uint32_t records_    = 0;
+    uint32_t writeIndex_ = 0;  // next record slot; its sector is erased
+};
+#endif
+
+#if LOG_STORAGE_HAS_MMAP
+// ── Memory-mapped host file ───────────────────────────────────
+// Keeps every appended entry: a small header, then packed entries in
+// sequence order. The mapping grows by doubling, so long simulations can log
+// millions of events at 12 bytes each and read them back via records().
+class MappedFileLogStorage {
+public:
+    static constexpr size_t kCapacityMultiple = 1;
+
+    MappedFileLogStorage() = default;
+    ~MappedFileLogStorage();
+    MappedFileLogStorage(const MappedFileLogStorage&) = delete;
+    MappedFileLogStorage& operator=(const MappedFileLogStorage&) = delete;
+
+    bool begin(const char* path, size_t capacity);
+    size_t restore(PackedLogEntry* ring, size_t capacity, uint32_t& next);
+    void append(const PackedLogEntry* ring, size_t capacity, uint32_t first, uint32_t end);
+    // Trims the file to its records and unmaps it.
+    void close();
+
+    uint64_t recordCount() const;
+    uint32_t firstSequence() const;
+    // All persisted entries, oldest first; valid until the next append.
+    const PackedLogEntry* records() const;
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t firstSequence;
+        uint32_t reserved2;
+        uint64_t count;
+    };
+
+    bool map(size_t bytes);
+    PackedLogEntry* recordsBegin() const;
+
+    int     fd_          = -1;
+    Header* header_      = nullptr;
+    size_t  mappedBytes_ = 0;
+};
+#endif
@@ -1,40 +1,59 @@
 #include "logger.h"
 
+#include <cstdio>
+
 #if __has_include(<Arduino.h>)
 #include <Arduino.h>
 #define LOGGER_HAS_ARDUINO 1
 #else
-#include <cstdio>
 #define LOGGER_HAS_ARDUINO 0
 #endif
 
 #include "prefferences.h"
 
-#if __has_include(<Preferences.h>)
-#include <Preferences.h>                // lets you store data in flash memory
-#define LOGGER_HAS_PREFERENCES 1         // is a wrapper over flash storage
-                                        // key-value database
-#else
-#define LOGGER_HAS_PREFERENCES 0
-#endif
-
 namespace {
-constexpr uint16_t kPersistenceVersion = 2;
-
-// metadata header 
-// makes sure that after reboot well know the version the next index and size 
-struct LoggerPersistentHeader {
-    uint16_t version = kPersistenceVersion;
-    uint16_t nextIndex = 0;
-    uint16_t size = 0;
-};
-
-#if LOGGER_HAS_PREFERENCES
-Preferences& prefs() {
-    static Preferences instance;
-    return instance;
+// ── Packing ───────────────────────────────────────────────────
+constexpr uint32_t kWallBits   = 39;
+constexpr uint64_t kWallMask   = (1ULL << kWallBits) - 1U;
+constexpr int      kOffsetBias = 64;  // quarter hours
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Hinnant's algorithm).
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2 ? 1 : 0;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2 ? 1 : 0);
+}
+
+// Local-minus-UTC offset of a snapshot in quarter hours, from its calendar
+// fields and unixMs.
+int utcOffsetQuarters(const WallClockSnapshot& t) {
+    if (t.dateKey == 0U) {
+        return 0;
+    }
+    const int64_t localSec =
+        daysFromCivil(t.dateKey / 10000U, (t.dateKey / 100U) % 100U, t.dateKey % 100U) * 86400 +
+        t.hour * 3600 + t.minute * 60 + t.second;
+    const int64_t offsetSec = localSec - static_cast<int64_t>(t.unixMs / 1000U);
+    int64_t quarters = (offsetSec + (offsetSec >= 0 ? 450 : -450)) / 900;
+    if (quarters < -kOffsetBias) quarters = -kOffsetBias;
+    if (quarters > kOffsetBias - 1) quarters = kOffsetBias - 1;
+    return static_cast<int>(quarters);
 }
-#endif
 
 const char* eventToString(LogEventType type) {
     switch (type) {
@@ -54,157 +73,112 @@ const char* eventToString(LogEventType type) {
             return "TRANSMIT_FAILED";
         case LogEventType::IR_FRAME_RX:
             return "IR_FRAME_RX";
+        case LogEventType::HUB_LINK_DOWN:
+            return "HUB_LINK_DOWN";
+        case LogEventType::HUB_LINK_UP:
+            return "HUB_LINK_UP";
         default:
             return "UNKNOWN";
     }
 }
 
-void printLogEntry(const LogEntry& entry) {
-    if (kDiagnosticsLogLevel < 2U) {
-        return;
-    }
+}  // namespace
 
-#if LOGGER_HAS_ARDUINO
-    Serial.print("[LOG] ");
-    if (entry.wallTimeValid) {
-        Serial.print(entry.dateKey);
-        Serial.print(' ');
-        if (entry.hour < 10U) {
-            Serial.print('0');
-        }
-        Serial.print(entry.hour);
-        Serial.print(':');
-        if (entry.minute < 10U) {
-            Serial.print('0');
-        }
-        Serial.print(entry.minute);
-        Serial.print(':');
-        if (entry.second < 10U) {
-            Serial.print('0');
-        }
-        Serial.print(entry.second);
-    } else {
-        Serial.print("bootMs=");
-        Serial.print(entry.uptimeMs);
+size_t formatLogEntry(const PackedLogEntry& packed, char* out, size_t size) {
+    if (out == nullptr || size == 0) {
+        return 0;
     }
-
-    Serial.print(" evt=");
-    Serial.print(eventToString(entry.type));
-    Serial.print(" cmd=");
-    Serial.print(commandToString(entry.command));
-    Serial.print(" success=");
-    Serial.print(entry.success ? "1" : "0");
-    Serial.print(" code=");
-    Serial.println(entry.detailCode);
-#else
+    const LogEntry entry = packed.unpack();
+    int written = 0;
     if (entry.wallTimeValid) {
-        std::printf("[LOG] %u %02u:%02u:%02u evt=%s cmd=%s success=%u code=%u\n",
-                    static_cast<unsigned>(entry.dateKey),
-                    static_cast<unsigned>(entry.hour),
-                    static_cast<unsigned>(entry.minute),
-                    static_cast<unsigned>(entry.second),
-                    eventToString(entry.type),
-                    commandToString(entry.command),
-                    static_cast<unsigned>(entry.success ? 1U : 0U),
-                    static_cast<unsigned>(entry.detailCode));
+        written = std::snprintf(out, size, "[LOG] %u %02u:%02u:%02u evt=%s cmd=%s success=%u code=%u\n",
+                                static_cast<unsigned>(entry.dateKey),
+                                static_cast<unsigned>(entry.hour),
+                                static_cast<unsigned>(entry.minute),
+                                static_cast<unsigned>(entry.second),
+                                eventToString(entry.type),
+                                commandToString(entry.command),
+                                static_cast<unsigned>(entry.success ? 1U : 0U),
+                                static_cast<unsigned>(entry.detailCode));
     } else {
-        std::printf("[LOG] bootMs=%u evt=%s cmd=%s success=%u code=%u\n",
-                    static_cast<unsigned>(entry.uptimeMs),
-                    eventToString(entry.type),
-                    commandToString(entry.command),
-                    static_cast<unsigned>(entry.success ? 1U : 0U),
-                    static_cast<unsigned>(entry.detailCode));
+        written = std::snprintf(out, size, "[LOG] bootMs=%u evt=%s cmd=%s success=%u code=%u\n",
+                                static_cast<unsigned>(entry.uptimeMs),
+                                eventToString(entry.type),
+                                commandToString(entry.command),
+                                static_cast<unsigned>(entry.success ? 1U : 0U),
+                                static_cast<unsigned>(entry.detailCode));
     }
-    std::fflush(stdout);
-#endif
-}
-}  // namespace
-
-void Logger::log(const WallClockSnapshot& timestamp,
-                 LogEventType type,
-                 Command command,
-                 bool success,
-                 uint8_t detailCode) {
-    entries_[nextIndex_] = LogEntry{
-        timestamp.bootMs,
-        timestamp.bootUs,
-        timestamp.unixMs,
-        timestamp.dateKey,
-        timestamp.hour,
-        timestamp.minute,
-        timestamp.second,
-        timestamp.weekday,
-        timestamp.valid,
-        type,
-        command,
-        success,
-        detailCode,
-    };
-
-    nextIndex_ = (nextIndex_ + 1U) % entries_.size();
-    if (size_ < entries_.size()) {
-        ++size_;
+    if (written < 0) {
+        return 0;
     }
-
-    printLogEntry(entries_[(nextIndex_ + entries_.size() - 1U) % entries_.size()]);
-
-    persistState();
+    return static_cast<size_t>(written) < size ? static_cast<size_t>(written) : size - 1U;
 }
 
-bool Logger::beginPersistence(const char* storageNamespace) {
-#if LOGGER_HAS_PREFERENCES
-    if (storageNamespace == nullptr) {
-        return false;
-    }
-
-    if (!prefs().begin(storageNamespace, false)) {
-        return false;
-    }
-
-    LoggerPersistentHeader header{};
-    const size_t headerRead = prefs().getBytes("header", &header, sizeof(header));
-    if (headerRead == sizeof(header) && header.version == kPersistenceVersion) {
-        const uint16_t maxCapacity = static_cast<uint16_t>(kCapacity);
-        nextIndex_ = (header.nextIndex < maxCapacity) ? header.nextIndex : 0;
-        size_ = (header.size <= maxCapacity) ? header.size : 0;
-
-        const size_t expected = sizeof(LogEntry) * entries_.size();
-        const size_t entriesRead = prefs().getBytes("entries", entries_.data(), expected);
-        if (entriesRead != expected) {
-            nextIndex_ = 0;
-            size_ = 0;
-            entries_.fill(LogEntry{});
-        }
-    }
-
-    persistenceReady_ = true;
-    return true;
-#else
-    (void)storageNamespace;
-    return false;
-#endif
-}
-// updates header and the entries in flash.
-void Logger::persistState() {
-#if LOGGER_HAS_PREFERENCES
-    if (!persistenceReady_) {
+void printLogEntry(const PackedLogEntry& packed) {
+    if (kDiagnosticsLogLevel < 2U) {
         return;
     }
-
-    LoggerPersistentHeader header{};
-    header.version = kPersistenceVersion;
-    header.nextIndex = static_cast<uint16_t>(nextIndex_);
-    header.size = static_cast<uint16_t>(size_);
-
-    prefs().putBytes("header", &header, sizeof(header));
-    prefs().putBytes("entries", entries_.data(), sizeof(LogEntry) * entries_.size());
+    char line[kLogLineMax];
+    const size_t length = formatLogEntry(packed, line, sizeof(line));
+#if LOGGER_HAS_ARDUINO
+    Serial.write(reinterpret_cast<const uint8_t*>(line), length);
+#else
+    std::fwrite(line, 1, length, stdout);
+    std::fflush(stdout);
 #endif
 }
 
-const std::array<LogEntry, Logger::kCapacity>& Logger::entries() const {
-    return entries_;
+PackedLogEntry PackedLogEntry::pack(const WallClockSnapshot& timestamp, LogEventType type,
+                                   Command command, bool success, uint8_t detailCode) {
+    // Wall time outside the 39-bit window (before 2024, after mid-2041) is
+    // stored as "no wall time".
+    uint64_t wall = 0;
+    if (timestamp.valid && timestamp.unixMs > kEpochUnixMs &&
+        timestamp.unixMs - kEpochUnixMs <= kWallMask) {
+        wall = timestamp.unixMs - kEpochUnixMs;
+    }
+    const uint32_t offset = wall ? static_cast<uint32_t>(utcOffsetQuarters(timestamp) + kOffsetBias) : 0;
+
+    PackedLogEntry packed{};
+    packed.words[0] = timestamp.bootMs;
+    packed.words[1] = static_cast<uint32_t>(wall);
+    packed.words[2] = static_cast<uint32_t>(wall >> 32) |
+                      (offset << 7) |
+                      ((static_cast<uint32_t>(type) & 0x0FU) << 14) |
+                      ((static_cast<uint32_t>(command) & 0x1FU) << 18) |
+                      (success ? (1UL << 23) : 0U) |
+                      (static_cast<uint32_t>(detailCode) << 24);
+    return packed;
 }
 
-size_t Logger::size() const {
-    return size_;
+LogEntry PackedLogEntry::unpack() const {
+    LogEntry entry{};
+    entry.uptimeMs   = words[0];
+    entry.uptimeUs   = words[0] * 1000U;
+    entry.type       = static_cast<LogEventType>((words[2] >> 14) & 0x0FU);
+    entry.command    = static_cast<Command>((words[2] >> 18) & 0x1FU);
+    entry.success    = (words[2] >> 23) & 1U;
+    entry.detailCode = static_cast<uint8_t>(words[2] >> 24);
+
+    const uint64_t wall = (static_cast<uint64_t>(words[2] & 0x7FU) << 32) | words[1];
+    if (wall == 0) {
+        return entry;
+    }
+    entry.wallTimeValid = true;
+    entry.unixMs = kEpochUnixMs + wall;
+
+    const int offsetSec = (static_cast<int>((words[2] >> 7) & 0x7FU) - kOffsetBias) * 900;
+    const int64_t local = static_cast<int64_t>(entry.unixMs / 1000U) + offsetSec;
+    const int64_t days  = local / 86400;
+    const uint32_t secondsOfDay = static_cast<uint32_t>(local % 86400);
+    int64_t year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    civilFromDays(days, year, month, day);
+    entry.dateKey = static_cast<uint32_t>(year * 10000 + month * 100 + day);
+    entry.hour    = static_cast<uint8_t>(secondsOfDay / 3600U);
+    entry.minute  = static_cast<uint8_t>((secondsOfDay / 60U) % 60U);
+    entry.second  = static_cast<uint8_t>(secondsOfDay % 60U);
+    entry.weekday = static_cast<uint8_t>((days + 4) % 7);  // 1970-01-01 was a Thursday
+    return entry;
 }
@@ -3,57 +3,172 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 
-#include "commands.h"
-#include "time/wall_clock.h"
-
-enum class LogEventType : uint8_t {
-    COMMAND_SENT = 0,
-    COMMAND_DROPPED = 1,
-    HUB_COMMAND_RX = 2, // command rescieved from hub
-    SCHEDULE_COMMAND = 3,
-    STATE_CHANGE = 4,
-    THERMOSTAT_CONTROL = 5,
-    TRANSMIT_FAILED = 6,
-    IR_FRAME_RX = 7, // raw IR frame received from hardware
-};
-
-struct LogEntry {
-    uint32_t uptimeMs; // milliseconds since device boot
-    uint32_t uptimeUs;
-    uint64_t unixMs; // Unix epoch timestamp in milliseconds 
-    uint32_t dateKey; //  calendar date as YYYYMMDD
-    uint8_t hour;
-    uint8_t minute;
-    uint8_t second;
-    uint8_t weekday;
-    bool wallTimeValid;
-    LogEventType type;
-    Command command;
-    bool success;
-    uint8_t detailCode; //  extra status/error code
-};
+#include "log_drain.h"
+#include "log_entry.h"
+#include "log_storage.h"
 
-class Logger {
+// log() is called from the control task (loop() when it is not running);
+// totalLogged() and copySince() may also be called from the hub worker and
+// are guarded by a mutex. entries() and size() are for the control side only.
+//
+// N is the ring capacity and Storage one of the policies in log_storage.h;
+// both are fixed at compile time, so a build only pays for the RAM and
+// backend it picks. beginPersistence() restores the newest persisted run
+// into the ring and every log() after it appends one entry to the backend.
+template <size_t N, typename Storage>
+class EventLogger {
 public:
-    static constexpr size_t kCapacity = 128;
+    static constexpr size_t kCapacity = N;
+    static_assert(N > 0, "the ring needs at least one slot");
+    static_assert(N % Storage::kCapacityMultiple == 0, "capacity does not fit the storage layout");
+
+    // entries()[i] expands ring slot i into a LogEntry on each access.
+    class EntryView {
+    public:
+        LogEntry operator[](size_t index) const { return entries_[index].unpack(); }
+        size_t size() const { return kCapacity; }
+
+    private:
+        friend class EventLogger;
+        explicit EntryView(const PackedLogEntry* entries) : entries_(entries) {}
+        const PackedLogEntry* entries_;
+    };
 
     void log(const WallClockSnapshot& timestamp,
              LogEventType type,
              Command command,
              bool success,
-             uint8_t detailCode = 0);
-    bool beginPersistence(const char* storageNamespace);
+             uint8_t detailCode = 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const size_t slot = nextIndex_;
+        entries_[slot] = PackedLogEntry::pack(timestamp, type, command, success, detailCode);
 
-    const std::array<LogEntry, kCapacity>& entries() const;
-    size_t size() const;
+        nextIndex_ = (nextIndex_ + 1U) % kCapacity;
+        if (size_ < kCapacity) {
+            ++size_;
+        }
+        ++totalLogged_;
+        lock.unlock();
 
-private:
-    void persistState();
+        // Only log() writes entries_, so printing and persisting need no lock.
+        if (drain_ != nullptr) {
+            drain_->post(entries_[slot]);
+        } else {
+            printLogEntry(entries_[slot]);
+        }
+
+        if (persistenceReady_) {
+            const uint32_t sequence = persistSequence_++;
+            storage_.append(entries_.data(), kCapacity, sequence, sequence + 1U);
+        }
+    }
+
+    // name is the storage's namespace, partition label or file path.
+    bool beginPersistence(const char* name) {
+        if (name == nullptr || !storage_.begin(name, kCapacity)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t next = 0;
+        const size_t restored = storage_.restore(entries_.data(), kCapacity, next);
+        if (restored > 0) {
+            size_ = restored;
+            nextIndex_ = next % kCapacity;
+            persistSequence_ = next;
+            for (size_t i = size_; i < kCapacity; ++i) {
+                entries_[(nextIndex_ + i - size_) % kCapacity] = PackedLogEntry{};
+            }
+        } else {
+            // Nothing stored yet: keep what was logged before this call.
+            persistSequence_ =
+                static_cast<uint32_t>(size_ > nextIndex_ ? nextIndex_ + kCapacity : nextIndex_);
+            if (size_ > 0) {
+                storage_.append(entries_.data(), kCapacity,
+                                persistSequence_ - static_cast<uint32_t>(size_), persistSequence_);
+            }
+        }
+        persistenceReady_ = true;
+        return true;
+    }
 
+    // Hands "[LOG]" printing to drain (nullptr: print inside log()). Set
+    // before the first log() from another task.
+    void setDrain(LogDrain* drain) { drain_ = drain; }
+
+    EntryView entries() const { return EntryView(entries_.data()); }
+    size_t size() const { return size_; }
+    Storage& storage() { return storage_; }
+
+    // Sequence numbers count log() calls since boot (restored entries are not
+    // numbered). Used by the hub sync to upload only what is new.
+    uint32_t totalLogged() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return totalLogged_;
+    }
+
+    // Copies up to maxCount entries starting at `sequence` (clamped to the
+    // oldest one still in RAM) into out; returns the count and sets
+    // firstSequence to the sequence of out[0].
+    size_t copySince(uint32_t sequence, LogEntry* out, size_t maxCount,
+                     uint32_t& firstSequence) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint32_t held   = static_cast<uint32_t>(size_ < totalLogged_ ? size_ : totalLogged_);
+        const uint32_t oldest = totalLogged_ - held;
+        if (sequence < oldest || sequence > totalLogged_) {
+            sequence = oldest;
+        }
+        firstSequence = sequence;
+
+        size_t count = 0;
+        while (sequence + count < totalLogged_ && count < maxCount && out != nullptr) {
+            // The newest entry sits just before nextIndex_.
+            const size_t back = totalLogged_ - (sequence + count);
+            out[count] = entries_[(nextIndex_ + kCapacity - back) % kCapacity].unpack();
+            ++count;
+        }
+        return count;
+    }
+
+private:
     // for RAM
-    std::array<LogEntry, kCapacity> entries_{};
+    std::array<PackedLogEntry, kCapacity> entries_{};
     size_t nextIndex_ = 0;
     size_t size_ = 0;
+    uint32_t totalLogged_ = 0;
     bool persistenceReady_ = false;
+    // Sequence of the next persisted entry across reboots; % kCapacity == nextIndex_.
+    uint32_t persistSequence_ = 0;
+    Storage storage_;
+    LogDrain* drain_ = nullptr;
+    mutable std::mutex mutex_;
 };
+
+// Per-build defaults: -DLOGGER_CAPACITY=<n> and one of LOGGER_STORAGE_RAM,
+// LOGGER_STORAGE_PARTITION or LOGGER_STORAGE_MMAP; otherwise NVS where
+// Preferences exists and RAM elsewhere.
+#ifndef LOGGER_CAPACITY
+#define LOGGER_CAPACITY 320
+#endif
+
+#if defined(LOGGER_STORAGE_RAM)
+using DefaultLogStorage = RamLogStorage;
+#elif defined(LOGGER_STORAGE_PARTITION)
+#if !LOG_STORAGE_HAS_PARTITION
+#error "LOGGER_STORAGE_PARTITION needs esp_partition.h"
+#endif
+using DefaultLogStorage = PartitionLogStorage;
+#elif defined(LOGGER_STORAGE_MMAP)
+#if !LOG_STORAGE_HAS_MMAP
+#error "LOGGER_STORAGE_MMAP needs a host with mmap"
+#endif
+using DefaultLogStorage = MappedFileLogStorage;
+#elif LOG_STORAGE_HAS_NVS
+using DefaultLogStorage = NvsLogStorage;
+#else
+using DefaultLogStorage = RamLogStorage;
+#endif
+
+using Logger = EventLogger<LOGGER_CAPACITY, DefaultLogStorage>;
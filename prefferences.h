@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 // ── PER-DEVICE CONFIG — change these before each flash ───────
@@ -26,15 +27,97 @@ constexpr int kTempSensorPin = 14;
 // ── Diagnostics ───────────────────────────────────────────────
 constexpr uint8_t  kDiagnosticsLogLevel       = 2;
 constexpr uint32_t kHealthSnapshotIntervalMs   = 10000;
+// "[LOG]" lines are formatted and written by a LogDrain task, so log() only
+// queues the packed entry. Entries that find the queue full are dropped.
+constexpr bool     kLogDrainEnabled           = true;
+constexpr size_t   kLogDrainQueueDepth        = 64U;
+constexpr uint32_t kLogDrainPeriodMs          = 20U;
+constexpr uint32_t kLogDrainStackBytes        = 3072U;
+constexpr uint8_t  kLogDrainPriority          = 0U;
+constexpr int      kLogDrainCore              = 0;
 constexpr float kDefaultTargetTemperatureC = 21.0F;
 
+// ── Control task ──────────────────────────────────────────────
+// Sensor -> PID -> IR runs on its own task pinned to core 1 every
+// kControlTaskPeriodMs, above loop()'s priority. loop() keeps WiFi/NTP, learn
+// result posts and the OLED; hub I/O stays on the hub worker (core 0).
+constexpr bool     kControlTaskEnabled      = true;
+constexpr uint32_t kControlTaskPeriodMs     = 50U;
+constexpr uint32_t kControlTaskStackBytes   = 8192U;
+constexpr uint8_t  kControlTaskPriority     = 3U;
+constexpr int      kControlTaskCore         = 1;
+// loop() sleep between network housekeeping passes while the task runs.
+constexpr uint32_t kNetLoopPeriodMs         = 10U;
+
 // ── Hub ───────────────────────────────────────────────────────
 constexpr const char* kHubHost = "192.168.0.10";
 constexpr int         kHubPort = 5000;
 
 constexpr uint32_t kHubCommandPollIntervalMs = 100U;
-constexpr uint32_t kHubTelemetryIntervalMs   = 2000U;
+// Minimum spacing between telemetry uploads; TelemetryPolicy decides which
+// samples are sent at all. Log-only syncs use the longer interval.
+constexpr uint32_t kHubTelemetryIntervalMs   = 1000U;
+constexpr uint32_t kHubLogSyncIntervalMs     = 5000U;
 constexpr int      kHubHttpTimeoutMs         = 2000;
+// Hub I/O runs on its own FreeRTOS task (HubWorker) and talks to loop() only
+// through HubLink queues, so a slow or dead hub never stalls control timing.
+// loop() runs on core 1 (Arduino default); the worker shares core 0 with WiFi.
+constexpr bool     kHubWorkerEnabled         = true;
+constexpr uint32_t kHubWorkerPeriodMs        = 10U;
+constexpr uint32_t kHubWorkerStackBytes      = 8192U;
+constexpr uint8_t  kHubWorkerPriority        = 1U;
+constexpr int      kHubWorkerCore            = 0;
+// Keep one TCP connection to the hub open and share it between command polls
+// and telemetry posts instead of reconnecting on every request.
+constexpr bool     kHubKeepAliveEnabled      = true;
+constexpr uint32_t kHubStatsLogIntervalMs    = 60000U;
+// Hold one long-poll open for commands instead of polling every 100 ms.
+// Falls back to interval polling while the hub does not support it.
+constexpr bool     kHubCommandPushEnabled    = true;
+constexpr uint32_t kHubLongPollHoldS         = 25U;
+constexpr uint32_t kHubPushRetryMs           = 60000U;
+// Upload telemetry and new log entries and download commands/config in one
+// POST /api/sync per cycle. Hubs without it get /api/telemetry instead.
+constexpr bool     kHubSyncEnabled           = true;
+constexpr uint8_t  kHubSyncMaxLogEntries     = 8U;
+// Samples the hub did not get wait in a TelemetryRing (spilling to NVS when
+// full) and go up via POST /api/telemetry/batch once it is reachable.
+constexpr bool     kTelemetryRingSpillToNvs      = true;
+constexpr uint8_t  kHubTelemetryBatchSize        = 8U;
+constexpr uint32_t kHubTelemetryBatchIntervalMs  = 500U;
+// Send telemetry as packed telemetry_codec frames when the hub lists "bin1"
+// in X-Telemetry-Formats; JSON otherwise.
+constexpr bool     kTelemetryBinaryEnabled       = true;
+// Encrypt bodies as binary envelope v2 (application/octet-stream) when the
+// hub lists "2" in X-Envelope-Versions; hex envelope v1 otherwise.
+constexpr bool     kHubEnvelopeV2Enabled         = true;
+// Prefer the AES-GCM envelope v3 (single pass, hardware AES) when the hub
+// lists "3"; needs kHubEnvelopeV2Enabled for the binary transport.
+constexpr bool     kHubEnvelopeAeadEnabled       = true;
+// Change-driven telemetry: send a sample when a value leaves its deadband,
+// and a keyframe at least every kTelemetryKeyframeIntervalMs.
+constexpr bool     kTelemetryPolicyEnabled       = true;
+constexpr float    kTelemetryRoomDeadbandC       = 0.2F;
+constexpr float    kTelemetryTargetDeadbandC     = 0.1F;
+constexpr float    kTelemetryPidDeadband         = 0.5F;
+constexpr uint32_t kTelemetryKeyframeIntervalMs  = 120000U;
+// Per-endpoint circuit breakers (commands, telemetry): after
+// kHubBreakerFailureThreshold transport failures in a row stop calling the
+// hub, wait a jittered backoff doubling from kHubBackoffBaseMs up to
+// kHubBackoffMaxMs, then try one probe, starting with a bare TCP connect.
+constexpr uint8_t  kHubBreakerFailureThreshold   = 3U;
+constexpr uint32_t kHubBackoffBaseMs             = 1000U;
+constexpr uint32_t kHubBackoffMaxMs              = 60000U;
+constexpr int      kHubProbeTimeoutMs            = 300;
+// Download the weekly plan as a schedule_codec frame and run it on the
+// device's SchedulePlan; the hub then stops evaluating it per telemetry
+// post. Fetched at start-up, when the hub flags a change, and every
+// kHubScheduleFetchIntervalMs; an unchanged plan costs a 304 (If-None-Match).
+// The last good plan is kept in NVS and runs from boot.
+constexpr bool     kHubScheduleSyncEnabled       = true;
+constexpr bool     kHubScheduleCacheToNvs        = true;
+constexpr uint32_t kHubScheduleFetchIntervalMs   = 6UL * 60UL * 60UL * 1000UL;
+constexpr uint32_t kHubScheduleRetryMs           = 60000U;
 
 // ── NTP ───────────────────────────────────────────────────────
 constexpr bool        kEnableIpTimezoneLookup = true;
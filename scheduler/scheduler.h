@@ -1,10 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
 
 #include "../commands.h"
+#include "../core/timer_wheel.h"
 #include "../time/wall_clock.h"
 
 constexpr uint8_t kWeekdaySunday = 1U << 0;
@@ -38,30 +40,240 @@ struct ScheduleEntry {
     uint32_t lastFiredDateKey = 0;
 };
 
-class CommandScheduler {
+// ── Local time helpers (scheduler.cpp) ────────────────────────
+namespace scheduling {
+
+// Days since 1970-01-01 for a YYYYMMDD date key.
+uint32_t dayNumber(uint32_t dateKey);
+// Seconds since 1970-01-01 on the local calendar; 0 for an invalid snapshot.
+uint32_t localSeconds(const WallClockSnapshot& wallNow);
+// Local seconds of entry's first occurrence on or after the anchor day that
+// has not fired yet. Today's occurrence counts even when its time has passed,
+// so a daily entry missed earlier in the day still fires once.
+uint32_t nextDailyFire(const ScheduleEntry& entry, uint32_t anchorDay, uint8_t anchorWeekday,
+                       uint32_t anchorDateKey);
+// The old per-entry walk over the next 7 days, for nextPlannedCommand() when
+// the index was built for another date.
+bool plannedDailyDue(const ScheduleEntry& entry, const WallClockSnapshot& wallNow, uint32_t& outDueSec);
+
+}  // namespace scheduling
+
+// N is the number of entry slots. Relative entries run on a TimerWheel keyed
+// by boot ms, so millis() wrapping does not fire them early; adding, firing
+// or dropping one is O(1). Daily entries are kept in a min-heap of {local
+// seconds since the epoch, slot}, rebuilt when the local date changes
+// (midnight, or the clock being set or jumping); adding or firing one costs
+// O(log N). A tick only looks at the wheel's next slot and the heap's head,
+// so its cost does not depend on N.
+template <size_t N>
+class FixedCommandScheduler {
 public:
-    void setEnabled(bool enabled);
-    bool enabled() const;
+    static constexpr size_t kCapacity = N;
+    static_assert(N > 0 && N <= 0xFFFFU, "slots are indexed by uint16_t");
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+    // Fires command at boot ms atMs, which must be within ~24 days of nowMs.
+    bool addEntry(uint32_t nowMs, uint32_t atMs, Command command) {
+        const size_t slot = findFreeSlot();
+        if (slot == N) {
+            return false;
+        }
+
+        entries_[slot] = ScheduleEntry{};
+        entries_[slot].active = true;
+        entries_[slot].mode = ScheduleMode::RELATIVE_ONCE;
+        entries_[slot].atMs = atMs;
+        entries_[slot].command = command;
+        relative_.advanceTo(nowMs);
+        relative_.start(atMs, static_cast<uint32_t>(slot));
+        return true;
+    }
 
-    bool addEntry(uint32_t atMs, Command command);
     bool addDailyEntry(uint8_t hour,
                        uint8_t minute,
                        uint8_t second,
                        Command command,
-                       uint8_t weekdayMask = kWeekdayAll);
+                       uint8_t weekdayMask = kWeekdayAll) {
+        if (hour > 23U || minute > 59U || second > 59U || weekdayMask == 0U) {
+            return false;
+        }
+
+        const size_t slot = findFreeSlot();
+        if (slot == N) {
+            return false;
+        }
+
+        entries_[slot] = ScheduleEntry{};
+        entries_[slot].active = true;
+        entries_[slot].mode = ScheduleMode::DAILY_WALL_CLOCK;
+        entries_[slot].command = command;
+        entries_[slot].hour = hour;
+        entries_[slot].minute = minute;
+        entries_[slot].second = second;
+        entries_[slot].weekdayMask = weekdayMask;
+        entries_[slot].lastFiredDateKey = 0;
+        // Without an index date the next tick with a valid clock builds it.
+        if (indexDateKey_ != 0U) {
+            push(daily_, dailyCount_, FireSlot{dailyFire(entries_[slot]), static_cast<uint16_t>(slot)});
+        }
+        return true;
+    }
+
+    // While disabled it only keeps the relative wheel's time, so relative
+    // entries due meanwhile fire once it is enabled again.
+    bool nextDueCommand(uint32_t nowMs, const WallClockSnapshot& wallNow, Command& outCommand) {
+        if (!enabled_) {
+            relative_.advanceTo(nowMs);
+            return false;
+        }
+
+        TimerExpiry expired;
+        if (relative_.poll(nowMs, expired)) {
+            ScheduleEntry& entry = entries_[expired.cookie];
+            outCommand = entry.command;
+            entry.active = false;
+            return true;
+        }
+
+        if (!wallNow.valid || wallNow.dateKey == 0U) {
+            return false;
+        }
+        if (wallNow.dateKey != indexDateKey_) {
+            rebuildDaily(wallNow);
+        }
 
-    bool nextDueCommand(uint32_t nowMs, const WallClockSnapshot& wallNow, Command& outCommand);
+        if (dailyCount_ > 0 && daily_[0].at <= scheduling::localSeconds(wallNow)) {
+            const uint16_t slot = daily_[0].slot;
+            outCommand = entries_[slot].command;
+            entries_[slot].lastFiredDateKey = wallNow.dateKey;
+            pop(daily_, dailyCount_);
+            push(daily_, dailyCount_, FireSlot{dailyFire(entries_[slot]), slot});
+            return true;
+        }
+
+        return false;
+    }
+
+    // An entry that is already due (one nextDueCommand() has not fired yet)
+    // reports 0 seconds.
     bool nextPlannedCommand(uint32_t nowMs,
                             const WallClockSnapshot& wallNow,
                             Command& outCommand,
                             uint32_t& outDueInSec,
-                            bool& outUsesWallClock) const;
+                            bool& outUsesWallClock) const {
+        bool found = false;
+        uint32_t bestDueSec = 0;
+        Command bestCommand = Command::NONE;
+        bool bestWall = false;
+
+        TimerExpiry nextRelative;
+        if (relative_.next(nextRelative)) {
+            const int32_t dueMs = static_cast<int32_t>(nextRelative.atMs - nowMs);
+            found = true;
+            bestDueSec = dueMs <= 0 ? 0U : static_cast<uint32_t>(dueMs) / 1000UL;
+            bestCommand = entries_[nextRelative.cookie].command;
+        }
+
+        if (!wallNow.valid || wallNow.dateKey == 0U) {
+            // No wall clock: only relative entries can be planned.
+        } else if (wallNow.dateKey == indexDateKey_) {
+            if (dailyCount_ > 0) {
+                const uint32_t now = scheduling::localSeconds(wallNow);
+                const uint32_t dueSec = daily_[0].at > now ? daily_[0].at - now : 0U;
+                if (!found || dueSec < bestDueSec) {
+                    found = true;
+                    bestDueSec = dueSec;
+                    bestCommand = entries_[daily_[0].slot].command;
+                    bestWall = true;
+                }
+            }
+        } else {
+            for (size_t i = 0; i < N; ++i) {
+                const ScheduleEntry& entry = entries_[i];
+                uint32_t dueSec = 0;
+                if (!entry.active || entry.mode != ScheduleMode::DAILY_WALL_CLOCK ||
+                    !scheduling::plannedDailyDue(entry, wallNow, dueSec)) {
+                    continue;
+                }
+                if (!found || dueSec < bestDueSec) {
+                    found = true;
+                    bestDueSec = dueSec;
+                    bestCommand = entry.command;
+                    bestWall = true;
+                }
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+
+        outCommand = bestCommand;
+        outDueInSec = bestDueSec;
+        outUsesWallClock = bestWall;
+        return true;
+    }
 
 private:
-    static constexpr size_t kMaxEntries = 16;
+    struct FireSlot {
+        uint32_t at;  // local seconds
+        uint16_t slot;
+    };
+    // std::*_heap keep the largest element first; invert for a min-heap and
+    // break ties by slot so equal times fire in slot order.
+    static bool later(const FireSlot& a, const FireSlot& b) {
+        return a.at != b.at ? a.at > b.at : a.slot > b.slot;
+    }
+    static void push(std::array<FireSlot, N>& heap, size_t& count, FireSlot item) {
+        heap[count++] = item;
+        std::push_heap(heap.begin(), heap.begin() + count, later);
+    }
+    static void pop(std::array<FireSlot, N>& heap, size_t& count) {
+        std::pop_heap(heap.begin(), heap.begin() + count, later);
+        --count;
+    }
+
+    uint32_t dailyFire(const ScheduleEntry& entry) const {
+        return scheduling::nextDailyFire(entry, indexDay_, indexWeekday_, indexDateKey_);
+    }
+
+    void rebuildDaily(const WallClockSnapshot& wallNow) {
+        indexDateKey_ = wallNow.dateKey;
+        indexDay_ = scheduling::dayNumber(wallNow.dateKey);
+        indexWeekday_ = wallNow.weekday;
+        dailyCount_ = 0;
+        for (size_t i = 0; i < N; ++i) {
+            if (entries_[i].active && entries_[i].mode == ScheduleMode::DAILY_WALL_CLOCK) {
+                daily_[dailyCount_++] = FireSlot{dailyFire(entries_[i]), static_cast<uint16_t>(i)};
+            }
+        }
+        std::make_heap(daily_.begin(), daily_.begin() + dailyCount_, later);
+    }
 
-    size_t findFreeSlot() const;
+    size_t findFreeSlot() const {
+        for (size_t i = 0; i < N; ++i) {
+            if (!entries_[i].active) {
+                return i;
+            }
+        }
+        return N;
+    }
 
-    std::array<ScheduleEntry, kMaxEntries> entries_{};
+    std::array<ScheduleEntry, N> entries_{};
+    TimerWheel<N> relative_{};
+    std::array<FireSlot, N> daily_{};
+    size_t dailyCount_ = 0;
+    uint32_t indexDateKey_ = 0;  // date the daily heap was built for
+    uint32_t indexDay_ = 0;
+    uint8_t indexWeekday_ = 0;
     bool enabled_ = false;
 };
+
+// -DSCHEDULER_CAPACITY=<n> sizes the on-device fallback schedule.
+#ifndef SCHEDULER_CAPACITY
+#define SCHEDULER_CAPACITY 16
+#endif
+
+using CommandScheduler = FixedCommandScheduler<SCHEDULER_CAPACITY>;
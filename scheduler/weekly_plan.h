@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "scheduler.h"
+
+constexpr uint16_t kMinutesPerDay  = 24U * 60U;
+constexpr uint16_t kMinutesPerWeek = 7U * kMinutesPerDay;
+
+// What a due entry asks for.
+struct ScheduleAction {
+    Command command = Command::NONE;
+    bool setpoint = false;
+    float setpointC = 0.0f;
+};
+
+// One weekly plan entry; also its schedule_codec wire layout. minuteOfWeek
+// counts from Sunday 00:00. A payload with bit 15 set is a setpoint in
+// 0.01 °C (bits 0-14), otherwise bits 0-7 are a Command code.
+struct WeeklyEntry {
+    static constexpr uint16_t kSetpointFlag = 0x8000U;
+
+    uint16_t minuteOfWeek = 0;
+    uint16_t payload      = 0;
+
+    bool    isSetpoint() const { return (payload & kSetpointFlag) != 0U; }
+    float   setpointC() const { return static_cast<float>(payload & 0x7FFFU) / 100.0f; }
+    Command command() const { return static_cast<Command>(payload & 0xFFU); }
+
+    static WeeklyEntry setpointAt(uint16_t minuteOfWeek, uint16_t centiC) {
+        return WeeklyEntry{minuteOfWeek, static_cast<uint16_t>(kSetpointFlag | (centiC & 0x7FFFU))};
+    }
+    static WeeklyEntry commandAt(uint16_t minuteOfWeek, Command command) {
+        return WeeklyEntry{minuteOfWeek, static_cast<uint16_t>(command)};
+    }
+};
+static_assert(sizeof(WeeklyEntry) == 4, "WeeklyEntry is 4 bytes in RAM and on the wire");
+
+// The hub's weekly plan: entries sorted by minute of week plus one fired bit
+// each for the current Sunday-to-Saturday week, about 4 bytes per entry
+// against ~45 for a FixedCommandScheduler slot. A tick advances a cursor
+// through today's entries, so it costs O(1) whatever N is; a new date costs
+// two binary searches and a new week also clears the bitset.
+//
+// Entries missed earlier today (boot, reload, clock jump to another date)
+// are marked fired without being replayed, except the latest missed setpoint,
+// which is the one in effect now. Commands are toggles, so replaying a
+// morning ON_OFF in the evening would do the wrong thing.
+template <size_t N>
+class WeeklyPlan {
+public:
+    static constexpr size_t kCapacity = N;
+    static_assert(N > 0 && N < 0xFFFFU, "entries are indexed by uint16_t");
+
+    void clear() {
+        count_ = 0;
+        reindex();
+    }
+
+    // Entries must be appended in minute-of-week order; false when out of
+    // order, out of range or full.
+    bool append(const WeeklyEntry& entry) {
+        if (count_ == N || entry.minuteOfWeek >= kMinutesPerWeek ||
+            (count_ > 0 && entry.minuteOfWeek < entries_[count_ - 1].minuteOfWeek)) {
+            return false;
+        }
+        entries_[count_++] = entry;
+        reindex();
+        return true;
+    }
+
+    size_t size() const { return count_; }
+    const WeeklyEntry& operator[](size_t index) const { return entries_[index]; }
+
+    bool nextDueAction(const WallClockSnapshot& wallNow, ScheduleAction& outAction) {
+        if (count_ == 0 || !wallNow.valid || wallNow.dateKey == 0U || wallNow.weekday > 6U) {
+            return false;
+        }
+        if (wallNow.dateKey != indexDateKey_) {
+            index(wallNow);
+        }
+        if (catchUp_ != kNone) {
+            emit(entries_[catchUp_], outAction);
+            catchUp_ = kNone;
+            return true;
+        }
+
+        const uint16_t now = minuteOfWeek(wallNow);
+        while (cursor_ < dayEnd_ && entries_[cursor_].minuteOfWeek <= now) {
+            const uint16_t i = cursor_++;
+            if (!fired(i)) {
+                markFired(i);
+                emit(entries_[i], outAction);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static constexpr uint16_t kNone   = 0xFFFFU;
+    static constexpr uint32_t kNoWeek = UINT32_MAX;
+
+    static uint16_t minuteOfWeek(const WallClockSnapshot& wallNow) {
+        return static_cast<uint16_t>(wallNow.weekday * kMinutesPerDay + wallNow.secondsOfDay / 60U);
+    }
+
+    static void emit(const WeeklyEntry& entry, ScheduleAction& outAction) {
+        outAction = ScheduleAction{};
+        if (entry.isSetpoint()) {
+            outAction.setpoint  = true;
+            outAction.setpointC = entry.setpointC();
+        } else {
+            outAction.command = entry.command();
+        }
+    }
+
+    bool fired(uint16_t i) const { return (fired_[i / 32U] & (1UL << (i % 32U))) != 0U; }
+    void markFired(uint16_t i) { fired_[i / 32U] |= 1UL << (i % 32U); }
+
+    // First entry at or after minute.
+    uint16_t lowerBound(uint16_t minute) const {
+        uint16_t lo = 0;
+        uint16_t hi = count_;
+        while (lo < hi) {
+            const uint16_t mid = static_cast<uint16_t>((lo + hi) / 2U);
+            if (entries_[mid].minuteOfWeek < minute) {
+                lo = static_cast<uint16_t>(mid + 1U);
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // The next tick with a valid clock re-indexes and starts a fresh week.
+    void reindex() {
+        indexDateKey_ = 0;
+        firedWeek_    = kNoWeek;
+        catchUp_      = kNone;
+    }
+
+    void index(const WallClockSnapshot& wallNow) {
+        indexDateKey_ = wallNow.dateKey;
+        const uint32_t week = scheduling::dayNumber(wallNow.dateKey) - wallNow.weekday;
+        if (week != firedWeek_) {
+            fired_.fill(0);
+            firedWeek_ = week;
+        }
+
+        const uint16_t dayStart = static_cast<uint16_t>(wallNow.weekday * kMinutesPerDay);
+        cursor_  = lowerBound(dayStart);
+        dayEnd_  = lowerBound(static_cast<uint16_t>(dayStart + kMinutesPerDay));
+        catchUp_ = kNone;
+
+        const uint16_t now = minuteOfWeek(wallNow);
+        for (; cursor_ < dayEnd_ && entries_[cursor_].minuteOfWeek < now; ++cursor_) {
+            if (fired(cursor_)) {
+                continue;
+            }
+            markFired(cursor_);
+            if (entries_[cursor_].isSetpoint()) {
+                catchUp_ = cursor_;
+            }
+        }
+    }
+
+    std::array<WeeklyEntry, N>               entries_{};
+    std::array<uint32_t, (N + 31U) / 32U>    fired_{};
+    uint32_t indexDateKey_ = 0;       // date cursor_/dayEnd_ were set for
+    uint32_t firedWeek_    = kNoWeek; // day number of the Sunday fired_ covers
+    uint16_t count_        = 0;
+    uint16_t cursor_       = 0;       // next of today's entries to check
+    uint16_t dayEnd_       = 0;       // first entry after today
+    uint16_t catchUp_      = kNone;   // missed setpoint still to report
+};
+
+// -DSCHEDULE_PLAN_CAPACITY=<n> sizes the hub's weekly plan; 336 holds a
+// half-hourly plan for every day of the week.
+#ifndef SCHEDULE_PLAN_CAPACITY
+#define SCHEDULE_PLAN_CAPACITY 336
+#endif
+
+using SchedulePlan = WeeklyPlan<SCHEDULE_PLAN_CAPACITY>;
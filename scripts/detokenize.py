@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# detokenize.py
+# Turns the serial output of a -DDIAG_TOKENIZED build back into text. Frames
+# look like "$<base64 without padding>"; everything else passes through.
+#
+#   pio device monitor -e thermoDevice_tokenized | \
+#       python3 scripts/detokenize.py .pio/build/thermoDevice_tokenized/tokens.csv
+#   python3 scripts/detokenize.py tokens.csv serial.log
+#
+# Frame layout (diagnostics/diag.h): u32 LE token, then one value per printf
+# conversion: integers as zigzag varints, floating point as f32 LE, strings as
+# a length byte (bit 7 = cut short) plus bytes.
+
+import base64
+import csv
+import re
+import struct
+import sys
+
+_FRAME = re.compile(r"^\$([A-Za-z0-9+/]+)\s*$")
+_SPEC  = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfgGcsp%])")
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            if self.pos >= len(self.data):
+                raise EOFError
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return value
+
+    def zigzag(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def f32(self):
+        if self.pos + 4 > len(self.data):
+            raise EOFError
+        (value,) = struct.unpack_from("<f", self.data, self.pos)
+        self.pos += 4
+        return value
+
+    def string(self):
+        if self.pos >= len(self.data):
+            raise EOFError
+        header = self.data[self.pos]
+        length = header & 0x7F
+        text = self.data[self.pos + 1:self.pos + 1 + length]
+        self.pos += 1 + length
+        text = text.decode("utf-8", errors="replace")
+        return text + "…" if header & 0x80 else text
+
+
+def load_db(path):
+    with open(path, newline="", encoding="utf-8") as f:
+        return {int(row["token"], 16): row["format"] for row in csv.DictReader(f)}
+
+
+def render(fmt, reader):
+    out, last = [], 0
+    for m in _SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        try:
+            if width == "*":
+                width = str(reader.zigzag())
+            if precision == "*":
+                precision = str(reader.zigzag())
+            spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+            if conv in "di":
+                out.append((spec + "d") % reader.zigzag())
+            elif conv in "ouxX":
+                # The device widened the value as it was typed; print it the
+                # way printf would have read it back.
+                bits = 64 if length in ("ll", "j") else 32
+                value = reader.zigzag() & ((1 << bits) - 1)
+                out.append((spec + ("d" if conv == "u" else conv)) % value)
+            elif conv in "eEfgG":
+                out.append((spec + conv) % reader.f32())
+            elif conv == "c":
+                out.append((spec + "c") % (reader.zigzag() & 0xFF))
+            elif conv == "s":
+                out.append((spec + "s") % reader.string())
+            elif conv == "p":
+                out.append("0x%x" % reader.varint())
+        except EOFError:
+            out.append("<?>")
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def detokenize_line(line, db):
+    m = _FRAME.match(line)
+    if not m:
+        return line
+    text = m.group(1)
+    try:
+        frame = base64.b64decode(text + "=" * (-len(text) % 4))
+    except ValueError:
+        return line
+    if len(frame) < 4:
+        return line
+    (value,) = struct.unpack_from("<I", frame)
+    fmt = db.get(value)
+    if fmt is None:
+        return "[?] unknown token %08x ($%s)\n" % (value, text)
+    return render(fmt, Reader(frame[4:])) + "\n"
+
+
+def main(argv):
+    if not argv or len(argv) > 2:
+        print("usage: detokenize.py tokens.csv [log file]", file=sys.stderr)
+        return 2
+    db = load_db(argv[0])
+    source = open(argv[1], encoding="utf-8", errors="replace") if len(argv) == 2 else sys.stdin
+    with source:
+        for line in source:
+            sys.stdout.write(detokenize_line(line, db))
+            sys.stdout.flush()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
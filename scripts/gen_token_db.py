@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# gen_token_db.py
+# Builds the token database for -DDIAG_TOKENIZED firmware: every
+# DIAG_LOGF(LEVEL, "TAG", "format", ...) call in the sources is hashed the way
+# diag::token() hashes it on the device (FNV-1a over "[LEVEL] [TAG] format").
+#
+#   python3 scripts/gen_token_db.py [-o tokens.csv] [source dirs...]
+#
+# Also runs as a PlatformIO pre-script (extra_scripts = pre:scripts/gen_token_db.py)
+# and then writes $BUILD_DIR/tokens.csv. Two formats sharing a token fail the
+# build; reword one of them.
+
+import csv
+import os
+import re
+import sys
+
+# ── Config ───────────────────────────────────────────────────
+SOURCE_EXTS = (".cpp", ".h", ".hpp")
+SKIP_DIRS   = {".git", ".pio", "test", "build"}
+# ─────────────────────────────────────────────────────────────
+
+_LITERAL = r'"(?:\\.|[^"\\\n])*"'
+_CALL = re.compile(
+    r'DIAG_LOGF\(\s*(\w+)\s*,\s*(' + _LITERAL + r')\s*,\s*((?:' + _LITERAL + r'\s*)+)')
+_ESCAPES = {
+    "n": b"\n", "t": b"\t", "r": b"\r", "0": b"\0", "a": b"\a", "b": b"\b",
+    "f": b"\f", "v": b"\v", "\\": b"\\", "\"": b"\"", "'": b"'", "?": b"?",
+}
+
+
+def unescape(literal):
+    """Bytes of one C string literal body, as the compiler would emit them."""
+    out = bytearray()
+    raw = literal.encode("utf-8")
+    i = 0
+    while i < len(raw):
+        ch = raw[i:i + 1]
+        if ch != b"\\":
+            out += ch
+            i += 1
+            continue
+        nxt = chr(raw[i + 1])
+        if nxt == "x":
+            m = re.match(rb"[0-9A-Fa-f]+", raw[i + 2:])
+            out.append(int(m.group(0), 16) & 0xFF)
+            i += 2 + len(m.group(0))
+        elif nxt in "01234567":
+            m = re.match(rb"[0-7]{1,3}", raw[i + 1:])
+            out.append(int(m.group(0), 8) & 0xFF)
+            i += 1 + len(m.group(0))
+        else:
+            out += _ESCAPES.get(nxt, nxt.encode())
+            i += 2
+    return bytes(out)
+
+
+def literals(text):
+    return b"".join(unescape(m[1:-1]) for m in re.findall(_LITERAL, text))
+
+
+def token(data):
+    value = 2166136261
+    for byte in data:
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def scan_file(path):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        text = f.read()
+    for m in _CALL.finditer(text):
+        line_start = text.rfind("\n", 0, m.start()) + 1
+        if text[line_start:m.start()].lstrip().startswith("//"):
+            continue
+        level, tag, fmt = m.group(1), literals(m.group(2)), literals(m.group(3))
+        line = text.count("\n", 0, m.start()) + 1
+        yield b"[" + level.encode() + b"] [" + tag + b"] " + fmt, "%s:%d" % (path, line)
+
+
+def scan(roots):
+    for root in roots:
+        for dirpath, dirnames, filenames in os.walk(root):
+            dirnames[:] = sorted(d for d in dirnames if d not in SKIP_DIRS)
+            for name in sorted(filenames):
+                if name.endswith(SOURCE_EXTS):
+                    yield from scan_file(os.path.join(dirpath, name))
+
+
+def build(roots):
+    """Returns ({token: format bytes}, [collision messages])."""
+    table, where, errors = {}, {}, []
+    for fmt, origin in scan(roots):
+        value = token(fmt)
+        if value in table and table[value] != fmt:
+            errors.append("token 0x%08x: %s (%s) collides with %s (%s)" % (
+                value, fmt.decode(errors="replace"), origin,
+                table[value].decode(errors="replace"), where[value]))
+            continue
+        table[value] = fmt
+        where.setdefault(value, origin)
+    return table, errors
+
+
+def write_db(table, path):
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w", newline="", encoding="utf-8") as f:
+        writer = csv.writer(f)
+        writer.writerow(["token", "format"])
+        for value in sorted(table):
+            writer.writerow(["%08x" % value, table[value].decode("utf-8", errors="replace")])
+
+
+def main(argv):
+    out = "tokens.csv"
+    if len(argv) >= 2 and argv[0] == "-o":
+        out, argv = argv[1], argv[2:]
+    table, errors = build(argv or ["."])
+    for message in errors:
+        print("[TOKENS] " + message, file=sys.stderr)
+    if errors:
+        return 1
+    write_db(table, out)
+    print("[TOKENS] %d formats -> %s" % (len(table), out))
+    return 0
+
+
+try:
+    Import("env")  # noqa: F821 -- defined when PlatformIO runs this file
+except NameError:
+    env = None
+
+if env is not None:
+    _table, _errors = build([env.subst("$PROJECT_DIR")])
+    for _message in _errors:
+        print("[TOKENS] " + _message)
+    if _errors:
+        env.Exit(1)
+    _out = os.path.join(env.subst("$BUILD_DIR"), "tokens.csv")
+    write_db(_table, _out)
+    print("[TOKENS] %d formats -> %s" % (len(_table), _out))
+elif __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// Host stand-in for the ESP32 Preferences (NVS) API, on test_desktop's
+// include path so the NVS code paths build and run in host tests. Each
+// namespace is one process-wide key map: a new instance opened on the same
+// namespace sees what an earlier one wrote, as after a reboot. wipe()
+// forgets every namespace.
+class Preferences {
+public:
+    using Blob      = std::vector<uint8_t>;
+    using Namespace = std::map<std::string, Blob>;
+
+    bool begin(const char* name, bool readOnly = false) {
+        // NVS namespace names are at most 15 characters.
+        if (name == nullptr || std::strlen(name) > 15U) {
+            return false;
+        }
+        keys_     = &namespaces()[name];
+        readOnly_ = readOnly;
+        return true;
+    }
+    void end() { keys_ = nullptr; }
+
+    bool isKey(const char* key) { return keys_ != nullptr && keys_->count(key) != 0U; }
+    bool remove(const char* key) { return writable() && keys_->erase(key) != 0U; }
+    bool clear() {
+        if (!writable()) {
+            return false;
+        }
+        keys_->clear();
+        return true;
+    }
+
+    size_t putBytes(const char* key, const void* value, size_t length) {
+        if (!writable()) {
+            return 0;
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(value);
+        (*keys_)[key].assign(bytes, bytes + length);
+        return length;
+    }
+    size_t getBytesLength(const char* key) {
+        const Blob* blob = find(key);
+        return blob ? blob->size() : 0U;
+    }
+    // 0 when the key is missing or does not fit, like nvs_get_blob().
+    size_t getBytes(const char* key, void* out, size_t capacity) {
+        const Blob* blob = find(key);
+        if (!blob || blob->size() > capacity) {
+            return 0;
+        }
+        std::memcpy(out, blob->data(), blob->size());
+        return blob->size();
+    }
+
+    // Stored with the terminator; getString() returns its length including it.
+    size_t putString(const char* key, const char* value) {
+        return putBytes(key, value, std::strlen(value) + 1U) ? std::strlen(value) : 0U;
+    }
+    size_t getString(const char* key, char* out, size_t capacity) { return getBytes(key, out, capacity); }
+
+    size_t   putUChar(const char* key, uint8_t value) { return putScalar(key, value); }
+    uint8_t  getUChar(const char* key, uint8_t fallback = 0) { return getScalar(key, fallback); }
+    size_t   putUShort(const char* key, uint16_t value) { return putScalar(key, value); }
+    uint16_t getUShort(const char* key, uint16_t fallback = 0) { return getScalar(key, fallback); }
+    size_t   putUInt(const char* key, uint32_t value) { return putScalar(key, value); }
+    uint32_t getUInt(const char* key, uint32_t fallback = 0) { return getScalar(key, fallback); }
+
+    // Test hooks.
+    static void wipe() { namespaces().clear(); }
+    static Namespace& keys(const char* name) { return namespaces()[name]; }
+
+private:
+    static std::map<std::string, Namespace>& namespaces() {
+        static std::map<std::string, Namespace> all;
+        return all;
+    }
+
+    bool writable() const { return keys_ != nullptr && !readOnly_; }
+    const Blob* find(const char* key) const {
+        if (keys_ == nullptr) {
+            return nullptr;
+        }
+        const auto it = keys_->find(key);
+        return it == keys_->end() ? nullptr : &it->second;
+    }
+
+    template <typename T>
+    size_t putScalar(const char* key, T value) {
+        return putBytes(key, &value, sizeof(value));
+    }
+    template <typename T>
+    T getScalar(const char* key, T fallback) {
+        T value{};
+        return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : fallback;
+    }
+
+    Namespace* keys_     = nullptr;
+    bool       readOnly_ = false;
+};
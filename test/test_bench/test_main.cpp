@@ -0,0 +1,661 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include "app/control_task.h"
+#include "core/timer_wheel.h"
+#include "crypto/base64.h"
+#include "crypto/message_crypto.h"
+#include "diagnostics/diag.h"
+#include "hub/hub_link.h"
+#include "hub/hub_messages.h"
+#include "hub/hub_worker.h"
+#include "hub/json_reader.h"
+#include "hub_additions/hub_loopback_endpoint.h"
+#include "log_drain.h"
+#include "logger.h"
+#include "prefferences.h"
+#include "scheduler/scheduler.h"
+#include "scheduler/weekly_plan.h"
+
+// Host benchmarks: pio test -e bench_desktop
+// Each bench prints its numbers and asserts only on properties that do not
+// depend on the machine (allocation counts, correctness of the result).
+
+namespace {
+
+// Counts heap allocations so benches can assert a hot path never allocates.
+std::atomic<size_t> gAllocations{0};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// Representative /api/sync reply: config fields, two commands and fields the
+// device does not know about.
+const char kSyncResponse[] =
+    "{\"status\": \"ok\", \"auto_control\": true, \"scheduled_target\": 21.5, "
+    "\"pid_mode\": \"ECO\", \"log_ack\": 1234, "
+    "\"commands\": [{\"command\": \"temp_up\"}, "
+    "{\"command\": \"send_ir\", \"protocol\": 8, \"address\": 4660, "
+    "\"ir_command\": 22, \"name\": \"Fan speed\"}]}";
+
+}  // namespace
+
+void* operator new(size_t size) {
+    ++gAllocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void setUp() {}
+void tearDown() {}
+
+// JSON reader: sync response parse throughput with zero heap allocations.
+void bench_json_reader_sync_response() {
+    constexpr int kIterations = 200000;
+    const size_t length = sizeof(kSyncResponse) - 1;
+
+    HubResponseMessage message;
+    const size_t allocationsBefore = gAllocations;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        parseHubResponse(kSyncResponse, length, message);
+    }
+    const Clock::time_point end = Clock::now();
+    const size_t allocations = gAllocations - allocationsBefore;
+
+    const double nsPerParse = elapsedNs(start, end) / kIterations;
+    std::printf("[BENCH] json_reader sync response: %zu bytes, %.0f ns/parse, %.1f MB/s, %zu allocs\n",
+                length, nsPerParse, (length / nsPerParse) * 1e3, allocations);
+
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_EQUAL_UINT8(2, message.commandCount);
+    TEST_ASSERT_TRUE(message.hasScheduledTarget);
+}
+
+// JSON reader: single command poll reply.
+void bench_json_reader_command() {
+    constexpr int kIterations = 500000;
+    const char payload[] = "{\"command\": \"temp_down\"}";
+
+    HubCommandMessage message;
+    const size_t allocationsBefore = gAllocations;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        parseHubCommand(payload, sizeof(payload) - 1, message);
+    }
+    const Clock::time_point end = Clock::now();
+
+    std::printf("[BENCH] json_reader command: %.0f ns/parse\n",
+                elapsedNs(start, end) / kIterations);
+    TEST_ASSERT_EQUAL_UINT32(0, gAllocations - allocationsBefore);
+    TEST_ASSERT_EQUAL_STRING("temp_down", message.command);
+}
+
+// Control loop vs. a hub that takes kHubHttpTimeoutMs per exchange: the worst
+// loop iteration must stay far below the network stall.
+void bench_loop_latency_with_stalled_hub() {
+    HubReceiver receiver;
+    Logger logger;
+    HubLink link(receiver, logger);
+    HubLoopbackEndpoint endpoint(link);
+    endpoint.setLatencyMs(static_cast<uint32_t>(kHubHttpTimeoutMs));
+    HubWorker worker(endpoint, 1U);
+
+    WallClockSnapshot wall{};
+    link.tick(wall, true);
+    TEST_ASSERT_TRUE(worker.begin());
+
+    constexpr int kLoopPeriodMs = 1;
+    const Clock::time_point benchStart = Clock::now();
+    double worstNs = 0.0;
+    double totalNs = 0.0;
+    int iterations = 0;
+    HubLink::Telemetry telemetry;
+    while (elapsedNs(benchStart, Clock::now()) < 2.5e9) {
+        const Clock::time_point start = Clock::now();
+        wall.bootMs = static_cast<uint32_t>(elapsedNs(benchStart, start) / 1e6);
+        link.tick(wall, true);
+        telemetry.roomTempC += 0.05f;  // a sample past the deadband every few loops
+        link.submitTelemetry(telemetry, wall);
+        if (iterations % 500 == 0) {
+            endpoint.queueCommand(Command::TEMP_UP);
+        }
+        Command cmd;
+        while (receiver.poll(cmd)) {
+        }
+        const double ns = elapsedNs(start, Clock::now());
+        worstNs = ns > worstNs ? ns : worstNs;
+        totalNs += ns;
+        ++iterations;
+        std::this_thread::sleep_for(std::chrono::milliseconds(kLoopPeriodMs));
+    }
+    worker.stop();
+
+    std::printf("[BENCH] loop with %d ms hub stall: %d iterations, avg %.1f us, worst %.1f us, "
+                "hub exchanges %lu, worker stalls %lu, worst service %lu ms\n",
+                kHubHttpTimeoutMs, iterations, totalNs / iterations / 1e3, worstNs / 1e3,
+                static_cast<unsigned long>(endpoint.exchanges()),
+                static_cast<unsigned long>(link.stats().workerStalls),
+                static_cast<unsigned long>(worker.maxServiceMs()));
+    TEST_ASSERT_TRUE(worker.maxServiceMs() >= static_cast<uint32_t>(kHubHttpTimeoutMs));
+    TEST_ASSERT_TRUE(worstNs < kHubHttpTimeoutMs * 1e6 / 20.0);
+}
+
+// Control pipeline on a ControlTask while the hub worker is stuck in a full
+// HTTP timeout: the control period should not move.
+void bench_control_task_period_with_stalled_hub() {
+    HubReceiver receiver;
+    Logger logger;
+    HubLink link(receiver, logger);
+    HubLoopbackEndpoint endpoint(link);
+    endpoint.setLatencyMs(static_cast<uint32_t>(kHubHttpTimeoutMs));
+    HubWorker worker(endpoint, 1U);
+
+    struct Pipeline : ControlStep {
+        HubLink&     link;
+        HubReceiver& receiver;
+        HubLink::Telemetry telemetry;
+        uint32_t steps = 0;
+        Pipeline(HubLink& l, HubReceiver& r) : link(l), receiver(r) {}
+        void controlStep(uint32_t nowMs) override {
+            WallClockSnapshot wall{};
+            wall.bootMs = nowMs;
+            link.tick(wall, true);
+            telemetry.roomTempC += 0.05f;
+            link.submitTelemetry(telemetry, wall);
+            if (++steps % 50 == 0) {
+                link.requestKeyframe();
+            }
+            Command cmd;
+            while (receiver.poll(cmd)) {
+            }
+        }
+    } pipeline(link, receiver);
+
+    constexpr uint32_t kPeriodMs = 10U;
+    ControlTask control(pipeline, kPeriodMs);
+    TEST_ASSERT_TRUE(worker.begin());
+    TEST_ASSERT_TRUE(control.begin());
+    for (int i = 0; i < 5; ++i) {
+        endpoint.queueCommand(Command::TEMP_UP);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    control.stop();
+    worker.stop();
+
+    const ControlTask::Stats stats = control.stats();
+    std::printf("[BENCH] control task every %lu ms with %d ms hub stall: %lu cycles, "
+                "overruns %lu, worst step %lu us, worst start delay %lu us\n",
+                static_cast<unsigned long>(kPeriodMs), kHubHttpTimeoutMs,
+                static_cast<unsigned long>(stats.cycles),
+                static_cast<unsigned long>(stats.overruns),
+                static_cast<unsigned long>(stats.maxStepUs),
+                static_cast<unsigned long>(stats.maxLatenessUs));
+    TEST_ASSERT_EQUAL_UINT32(pipeline.steps, stats.cycles);
+    TEST_ASSERT_TRUE(stats.cycles >= 2500U / kPeriodMs / 2U);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+}
+
+// log() cost with "[LOG]" printing inline vs. handed to a LogDrain task.
+// Every posted entry must end up printed or counted as dropped.
+void bench_logger_log_with_drain() {
+    constexpr int kEntries = 256;
+    WallClockSnapshot wall{};
+
+    auto measure = [&](Logger& logger, double& worstNs) {
+        double totalNs = 0.0;
+        worstNs = 0.0;
+        for (int i = 0; i < kEntries; ++i) {
+            wall.bootMs = static_cast<uint32_t>(i);
+            const Clock::time_point start = Clock::now();
+            logger.log(wall, LogEventType::COMMAND_SENT, Command::TEMP_UP, true, 7);
+            const double ns = elapsedNs(start, Clock::now());
+            worstNs = ns > worstNs ? ns : worstNs;
+            totalNs += ns;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return totalNs / kEntries;
+    };
+
+    Logger inlineLogger;
+    double inlineWorstNs = 0.0;
+    const double inlineAvgNs = measure(inlineLogger, inlineWorstNs);
+
+    LogDrain drain;
+    Logger drainedLogger;
+    drainedLogger.setDrain(&drain);
+    TEST_ASSERT_TRUE(drain.begin());
+    const size_t allocationsBefore = gAllocations;
+    double drainedWorstNs = 0.0;
+    const double drainedAvgNs = measure(drainedLogger, drainedWorstNs);
+    const size_t allocations = gAllocations - allocationsBefore;
+    drain.stop();
+
+    const LogDrain::Stats stats = drain.stats();
+    std::printf("[BENCH] log(): inline avg %.0f ns worst %.0f ns | drained avg %.0f ns worst %.0f ns "
+                "(printed %lu, dropped %lu, max depth %lu)\n",
+                inlineAvgNs, inlineWorstNs, drainedAvgNs, drainedWorstNs,
+                static_cast<unsigned long>(stats.printed), static_cast<unsigned long>(stats.dropped),
+                static_cast<unsigned long>(stats.maxDepth));
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+    TEST_ASSERT_EQUAL_UINT32(kEntries, stats.posted);
+    TEST_ASSERT_EQUAL_UINT32(stats.posted, stats.printed + stats.dropped);
+}
+
+// Bytes on the wire and formatting cost per line: printf text (what a
+// default build prints) against a "$<base64>" tokenized frame.
+void bench_diag_tokenized_vs_text() {
+    constexpr int kIterations = 20000;
+    char     text[diag::kFormattedMaxChars];
+    uint8_t  frame[diag::kTokenizedMaxBytes];
+    char     line[1 + base64::encodedSize(diag::kTokenizedMaxBytes) + 2];
+    size_t   textBytes[3]  = {0, 0, 0};
+    size_t   frameBytes[3] = {0, 0, 0};
+    double   textNs[3]     = {0, 0, 0};
+    double   frameNs[3]    = {0, 0, 0};
+    const char* const kNames[3] = {"hub backlog", "heater off", "pid"};
+
+#define BENCH_DIAG_LINE(index, format, ...)                                                  \
+    do {                                                                                     \
+        Clock::time_point start = Clock::now();                                              \
+        for (int i = 0; i < kIterations; ++i) {                                              \
+            textBytes[index] = static_cast<size_t>(                                          \
+                std::snprintf(text, sizeof(text), format "\n", __VA_ARGS__));                \
+        }                                                                                    \
+        textNs[index] = elapsedNs(start, Clock::now()) / kIterations;                        \
+        constexpr uint32_t kToken = diag::token(format);                                     \
+        start = Clock::now();                                                                \
+        for (int i = 0; i < kIterations; ++i) {                                              \
+            const size_t n = diag::encodeTokenized(frame, sizeof(frame), kToken, __VA_ARGS__); \
+            size_t chars = base64::encode(frame, n, line + 1, sizeof(line) - 1);             \
+            while (chars > 0 && line[chars] == '=') --chars;                                 \
+            frameBytes[index] = chars + 2;                                                   \
+        }                                                                                    \
+        frameNs[index] = elapsedNs(start, Clock::now()) / kIterations;                       \
+    } while (0)
+
+    const size_t allocationsBefore = gAllocations.load();
+    BENCH_DIAG_LINE(0, "[INFO] [HUB] Backlog: sent %ld, %lu left (dropped %lu)",
+                    12L, 3UL, 0UL);
+    BENCH_DIAG_LINE(1, "[INFO] [HEAT] OFF at %02d:%02d — ran %um%02us | %.1f°C → %.1f°C "
+                       "(%.1f° rise) | target was %.1f°C",
+                    7, 5, 12U, 3U, 19.5f, 21.25f, 1.75f, 21.0f);
+    BENCH_DIAG_LINE(2, "[INFO] [PID] room=%.2f°C target=%.2f°C err=%+.2f "
+                       "P=%+.2f I=%+.3f D=%+.2f steps=%+d kp=%.2f maxSteps=%d",
+                    20.1, 21.0, 0.9, 1.2, -0.012, 0.0, -2, 1.5, 3);
+#undef BENCH_DIAG_LINE
+    const size_t allocations = gAllocations.load() - allocationsBefore;
+
+    for (int i = 0; i < 3; ++i) {
+        std::printf("[BENCH] diag %-11s: text %3u B %5.0f ns | tokenized %2u B %4.0f ns (%.1fx smaller)\n",
+                    kNames[i], static_cast<unsigned>(textBytes[i]), textNs[i],
+                    static_cast<unsigned>(frameBytes[i]), frameNs[i],
+                    static_cast<double>(textBytes[i]) / frameBytes[i]);
+        TEST_ASSERT_LESS_THAN(textBytes[i], frameBytes[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+// The pre-index tick: scan every slot for a due entry.
+bool scanDueCommand(const ScheduleEntry* entries, size_t count, uint32_t nowMs,
+                    const WallClockSnapshot& wallNow) {
+    for (size_t i = 0; i < count; ++i) {
+        const ScheduleEntry& entry = entries[i];
+        if (!entry.active) continue;
+        if (entry.mode == ScheduleMode::RELATIVE_ONCE) {
+            if (entry.atMs <= nowMs) return true;
+            continue;
+        }
+        if ((entry.weekdayMask & (1U << wallNow.weekday)) == 0U) continue;
+        const uint32_t target = entry.hour * 3600UL + entry.minute * 60UL + entry.second;
+        if (wallNow.secondsOfDay >= target && entry.lastFiredDateKey != wallNow.dateKey) return true;
+    }
+    return false;
+}
+
+template <size_t N>
+void benchSchedulerTick(int iterations) {
+    // Too big for the stack at 4096 slots.
+    static FixedCommandScheduler<N> scheduler;
+    static std::array<ScheduleEntry, N> scanEntries;
+    scheduler.setEnabled(true);
+    for (size_t i = 0; i < N; ++i) {
+        ScheduleEntry& entry = scanEntries[i];
+        entry.active = true;
+        if (i % 4U == 0U) {
+            entry.mode = ScheduleMode::RELATIVE_ONCE;
+            entry.atMs = 3600000U + static_cast<uint32_t>(i);
+            TEST_ASSERT_TRUE(scheduler.addEntry(0, entry.atMs, Command::TEMP_UP));
+        } else {
+            entry.mode = ScheduleMode::DAILY_WALL_CLOCK;
+            entry.hour = static_cast<uint8_t>(6U + i % 16U);
+            entry.minute = static_cast<uint8_t>(i % 60U);
+            entry.weekdayMask = static_cast<uint8_t>(kWeekdayWeekdays | (i % 3U == 0U ? kWeekdayWeekend : 0U));
+            TEST_ASSERT_TRUE(scheduler.addDailyEntry(entry.hour, entry.minute, 0, Command::TEMP_DOWN,
+                                                     entry.weekdayMask));
+        }
+    }
+
+    // Monday 05:00, an hour before anything is due; the clock advances 1 ms a tick.
+    WallClockSnapshot wall{};
+    wall.valid = true;
+    wall.dateKey = 20260223;
+    wall.weekday = 1;
+    wall.secondsOfDay = 5U * 3600U;
+    Command out = Command::NONE;
+    size_t due = 0;
+
+    const Clock::time_point indexStart = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        due += scheduler.nextDueCommand(static_cast<uint32_t>(i), wall, out) ? 1U : 0U;
+    }
+    const double indexNs = elapsedNs(indexStart, Clock::now()) / iterations;
+
+    const Clock::time_point scanStart = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        due += scanDueCommand(scanEntries.data(), N, static_cast<uint32_t>(i), wall) ? 1U : 0U;
+    }
+    const double scanNs = elapsedNs(scanStart, Clock::now()) / iterations;
+
+    std::printf("[BENCH] scheduler tick %4u entries: index %6.1f ns | full scan %8.1f ns\n",
+                static_cast<unsigned>(N), indexNs, scanNs);
+    TEST_ASSERT_EQUAL_UINT32(0, due);
+}
+
+// Idle-tick cost of CommandScheduler::nextDueCommand as the schedule grows,
+// next to the per-slot scan it replaced.
+void bench_scheduler_tick() {
+    benchSchedulerTick<16>(200000);
+    benchSchedulerTick<256>(200000);
+    benchSchedulerTick<4096>(20000);
+}
+
+template <size_t N>
+void benchTimerWheel(int iterations) {
+    static TimerWheel<N> wheel;
+    wheel.reset(0xFFF00000U);  // expiries run across the millis() wrap
+    uint32_t seed = 1;
+    auto nextDelay = [&seed]() {
+        seed = seed * 1664525U + 1013904223U;
+        return 1U + (seed >> 8) % 2000000U;  // up to ~33 min
+    };
+    for (size_t i = 0; i + 1 < N; ++i) {
+        TEST_ASSERT_NOT_EQUAL(kNoTimer, wheel.start(wheel.nowMs() + nextDelay(), i));
+    }
+
+    const Clock::time_point startCancelStart = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        wheel.cancel(wheel.start(wheel.nowMs() + nextDelay(), 0));
+    }
+    const double startCancelNs = elapsedNs(startCancelStart, Clock::now()) / iterations;
+
+    // Idle polls 1 ms apart, short of the first expiry.
+    TimerExpiry expiry;
+    TimerExpiry first;
+    TEST_ASSERT_TRUE(wheel.next(first));
+    const uint32_t idleStartMs = wheel.nowMs();
+    const uint32_t idlePolls = std::min<uint32_t>(first.atMs - idleStartMs - 1U, 1000U);
+    const Clock::time_point idleStart = Clock::now();
+    for (uint32_t i = 1; i <= idlePolls; ++i) {
+        TEST_ASSERT_FALSE(wheel.poll(idleStartMs + i, expiry));
+    }
+    const double idleNs = elapsedNs(idleStart, Clock::now()) / (idlePolls ? idlePolls : 1U);
+
+    // One late poll drains every timer, cascades included.
+    size_t expired = 0;
+    const Clock::time_point expireStart = Clock::now();
+    while (wheel.poll(idleStartMs + 2000001U + idlePolls, expiry)) {
+        ++expired;
+    }
+    const double expireNs = elapsedNs(expireStart, Clock::now()) / expired;
+
+    std::printf("[BENCH] timer wheel %4u timers: start+cancel %5.1f ns | idle poll %5.1f ns | "
+                "expire %5.1f ns per timer\n",
+                static_cast<unsigned>(N), startCancelNs, idleNs, expireNs);
+    TEST_ASSERT_EQUAL_UINT32(N - 1, expired);
+}
+
+// TimerWheel start/cancel and expiry cost as the number of live timers grows.
+void bench_timer_wheel() {
+    benchTimerWheel<16>(200000);
+    benchTimerWheel<256>(200000);
+    benchTimerWheel<4096>(200000);
+}
+
+WallClockSnapshot benchWall(uint8_t weekday, uint32_t minuteOfDay) {
+    WallClockSnapshot wall{};
+    wall.valid = true;
+    wall.dateKey = 20260222U + weekday;  // Sunday 2026-02-22 .. Saturday 02-28
+    wall.weekday = weekday;
+    wall.secondsOfDay = minuteOfDay * 60U;
+    return wall;
+}
+
+// RAM and tick cost of a 7x48 half-hourly plan: WeeklyPlan (4-byte entries
+// plus a fired bitset) next to the same times as FixedCommandScheduler daily
+// commands, and the default 16-slot scheduler for scale.
+void bench_weekly_plan_memory_and_tick() {
+    constexpr size_t kEntries = 7U * 48U;
+    static WeeklyPlan<kEntries> plan;
+    static FixedCommandScheduler<kEntries> scheduler;
+    scheduler.setEnabled(true);
+    for (uint8_t day = 0; day < 7U; ++day) {
+        for (uint16_t slot = 0; slot < 48U; ++slot) {
+            const uint16_t centiC = static_cast<uint16_t>(slot % 2U == 0U ? 2100U : 1750U);
+            const uint16_t minute = static_cast<uint16_t>(slot * 30U);
+            TEST_ASSERT_TRUE(plan.append(WeeklyEntry::setpointAt(day * kMinutesPerDay + minute, centiC)));
+            TEST_ASSERT_TRUE(scheduler.addDailyEntry(static_cast<uint8_t>(minute / 60U),
+                                                     static_cast<uint8_t>(minute % 60U), 0,
+                                                     slot % 2U == 0U ? Command::TEMP_UP : Command::TEMP_DOWN,
+                                                     static_cast<uint8_t>(1U << day)));
+        }
+    }
+
+    std::printf("[BENCH] schedule RAM: FixedCommandScheduler<16> %5u B | <%u> %5u B (%.1f B/entry) | "
+                "WeeklyPlan<%u> %4u B (%.1f B/entry)\n",
+                static_cast<unsigned>(sizeof(FixedCommandScheduler<16>)),
+                static_cast<unsigned>(kEntries), static_cast<unsigned>(sizeof(scheduler)),
+                static_cast<double>(sizeof(scheduler)) / kEntries,
+                static_cast<unsigned>(kEntries), static_cast<unsigned>(sizeof(plan)),
+                static_cast<double>(sizeof(plan)) / kEntries);
+    TEST_ASSERT_LESS_THAN(sizeof(scheduler) / 8U, sizeof(plan));
+
+    // A simulated week, one tick a minute from Sunday 00:00: every entry fires once.
+    ScheduleAction action;
+    Command command = Command::NONE;
+    size_t planFired = 0;
+    size_t schedulerFired = 0;
+    const Clock::time_point planWeekStart = Clock::now();
+    for (uint8_t day = 0; day < 7U; ++day) {
+        for (uint32_t minute = 0; minute < kMinutesPerDay; ++minute) {
+            while (plan.nextDueAction(benchWall(day, minute), action)) ++planFired;
+        }
+    }
+    const double planWeekNs = elapsedNs(planWeekStart, Clock::now()) / kMinutesPerWeek;
+    const Clock::time_point schedulerWeekStart = Clock::now();
+    for (uint8_t day = 0; day < 7U; ++day) {
+        for (uint32_t minute = 0; minute < kMinutesPerDay; ++minute) {
+            while (scheduler.nextDueCommand(0, benchWall(day, minute), command)) ++schedulerFired;
+        }
+    }
+    const double schedulerWeekNs = elapsedNs(schedulerWeekStart, Clock::now()) / kMinutesPerWeek;
+
+    // Idle ticks between entries, the common case.
+    constexpr int kIterations = 200000;
+    const WallClockSnapshot idle = benchWall(6, 23U * 60U + 45U);
+    size_t due = 0;
+    const Clock::time_point planIdleStart = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        due += plan.nextDueAction(idle, action) ? 1U : 0U;
+    }
+    const double planIdleNs = elapsedNs(planIdleStart, Clock::now()) / kIterations;
+    const Clock::time_point schedulerIdleStart = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        due += scheduler.nextDueCommand(0, idle, command) ? 1U : 0U;
+    }
+    const double schedulerIdleNs = elapsedNs(schedulerIdleStart, Clock::now()) / kIterations;
+
+    std::printf("[BENCH] schedule tick %u entries: WeeklyPlan idle %5.1f ns, week %6.1f ns/min | "
+                "FixedCommandScheduler idle %5.1f ns, week %6.1f ns/min\n",
+                static_cast<unsigned>(kEntries), planIdleNs, planWeekNs, schedulerIdleNs,
+                schedulerWeekNs);
+    TEST_ASSERT_EQUAL_UINT32(kEntries, planFired);
+    TEST_ASSERT_EQUAL_UINT32(kEntries, schedulerFired);
+    TEST_ASSERT_EQUAL_UINT32(0, due);
+}
+
+// Per-envelope cost through the buffer API (and the String API where there
+// is one) with the key schedule and HMAC pad states reused, next to what
+// building them costs (previously paid on every envelope).
+void bench_message_crypto_envelope() {
+    const char telemetry[] =
+        "{\"room_temp\":21.5,\"target_temp\":22.0,\"power\":true,\"mode\":\"FAST\","
+        "\"pid_p\":1.25,\"pid_i\":0.125,\"pid_d\":0.50,\"pid_steps\":1,\"integral\":0.125}";
+    const size_t telemetryLen = sizeof(telemetry) - 1;
+    constexpr int kIterations = 2000;
+
+    MessageCrypto crypto(DEVICE_PASS);
+    size_t checksum = 0;
+#if MESSAGE_CRYPTO_HAS_STRING
+    const String telemetryString(telemetry);
+    const Clock::time_point warmStart = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        const String envelope = crypto.encryptEnvelope(telemetryString);
+        checksum += crypto.decryptEnvelope(envelope).length();
+    }
+    const double warmNs = elapsedNs(warmStart, Clock::now()) / kIterations;
+#endif
+
+    char    envelope[512];
+    uint8_t plain[512];
+    const size_t allocationsBefore = gAllocations.load();
+    const Clock::time_point bufferStart = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        const size_t envelopeLen = crypto.encryptEnvelope(
+            reinterpret_cast<const uint8_t*>(telemetry), telemetryLen, envelope, sizeof(envelope));
+        size_t plainLen = 0;
+        crypto.decryptEnvelope(envelope, envelopeLen, plain, sizeof(plain), plainLen);
+        checksum += plainLen;
+    }
+    const double bufferNs = elapsedNs(bufferStart, Clock::now()) / kIterations;
+    const size_t bufferAllocations = gAllocations.load() - allocationsBefore;
+
+    const Clock::time_point setupStart = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        MessageCrypto fresh(DEVICE_PASS);
+        checksum += fresh.encryptEnvelope(reinterpret_cast<const uint8_t*>(telemetry), telemetryLen,
+                                          envelope, sizeof(envelope)) ? 1 : 0;
+    }
+    const double setupNs = elapsedNs(setupStart, Clock::now()) / kIterations;
+
+#if MESSAGE_CRYPTO_HAS_STRING
+    std::printf("[BENCH] envelope %u B: encrypt+decrypt %.0f ns (String), %.0f ns (buffer), "
+                "key setup + encrypt %.0f ns\n",
+                static_cast<unsigned>(telemetryLen), warmNs, bufferNs, setupNs);
+    TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(kIterations * (2 * telemetryLen + 1)),
+                             static_cast<uint32_t>(checksum));
+#else
+    std::printf("[BENCH] envelope %u B: encrypt+decrypt %.0f ns, key setup + encrypt %.0f ns\n",
+                static_cast<unsigned>(telemetryLen), bufferNs, setupNs);
+    TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(kIterations * (telemetryLen + 1)),
+                             static_cast<uint32_t>(checksum));
+#endif
+    TEST_ASSERT_EQUAL_UINT32(0, bufferAllocations);
+}
+
+// Envelopes/s and payload B/s (seal + open) for v1, v2 and v3 (AES-GCM) at
+// the sizes the device actually sends and receives.
+void bench_message_crypto_throughput() {
+    struct Payload {
+        const char* name;
+        size_t      size;
+    };
+    const Payload kPayloads[] = {
+        {"bin1 sample", 3 + 20},
+        {"command", 48},
+        {"telemetry json", 135},
+        {"bin1 batch", 3 + 8 * 20},
+        {"sync json", 768},
+    };
+    constexpr double kBudgetNs = 50e6;  // per payload and version
+
+    MessageCrypto crypto(DEVICE_PASS);
+    uint8_t data[1024];
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<uint8_t>(' ' + i % 90);
+    char    v1[MessageCrypto::v1EnvelopeSize(sizeof(data)) + 1];
+    uint8_t v2[sizeof(data) + MessageCrypto::kV2Overhead];
+    uint8_t v3[sizeof(data) + MessageCrypto::kV3Overhead];
+    uint8_t plain[sizeof(v1)];
+
+    for (const Payload& payload : kPayloads) {
+        double rate[3] = {0, 0, 0};
+        for (int version = 1; version <= 3; ++version) {
+            size_t envelopes = 0;
+            size_t plainLen  = 0;
+            bool   ok        = true;
+            const Clock::time_point start = Clock::now();
+            double elapsed = 0;
+            while (elapsed < kBudgetNs) {
+                for (int i = 0; i < 64; ++i) {
+                    if (version == 1) {
+                        const size_t n = crypto.encryptEnvelope(data, payload.size, v1, sizeof(v1));
+                        ok &= crypto.decryptEnvelope(v1, n, plain, sizeof(plain), plainLen);
+                    } else if (version == 2) {
+                        const size_t n = crypto.sealV2(data, payload.size, v2, sizeof(v2));
+                        ok &= crypto.openV2(v2, n, plain, sizeof(plain), plainLen);
+                    } else {
+                        const size_t n = crypto.sealV3(data, payload.size, v3, sizeof(v3));
+                        ok &= crypto.openV3(v3, n, plain, sizeof(plain), plainLen);
+                    }
+                    ok &= plainLen == payload.size;
+                }
+                envelopes += 64;
+                elapsed = elapsedNs(start, Clock::now());
+            }
+            TEST_ASSERT_TRUE(ok);
+            rate[version - 1] = envelopes / (elapsed / 1e9);
+        }
+        std::printf("[BENCH] crypto %-14s %4u B: v1 %8.0f env/s %6.1f MB/s | v2 %8.0f env/s %6.1f MB/s"
+                    " | v3 %8.0f env/s %6.1f MB/s\n",
+                    payload.name, static_cast<unsigned>(payload.size),
+                    rate[0], rate[0] * payload.size / 1e6, rate[1], rate[1] * payload.size / 1e6,
+                    rate[2], rate[2] * payload.size / 1e6);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+
+    RUN_TEST(bench_json_reader_sync_response);
+    RUN_TEST(bench_json_reader_command);
+    RUN_TEST(bench_loop_latency_with_stalled_hub);
+    RUN_TEST(bench_control_task_period_with_stalled_hub);
+    RUN_TEST(bench_logger_log_with_drain);
+    RUN_TEST(bench_diag_tokenized_vs_text);
+    RUN_TEST(bench_scheduler_tick);
+    RUN_TEST(bench_timer_wheel);
+    RUN_TEST(bench_weekly_plan_memory_and_tick);
+    RUN_TEST(bench_message_crypto_envelope);
+    RUN_TEST(bench_message_crypto_throughput);
+
+    return UNITY_END();
+}
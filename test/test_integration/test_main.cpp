@@ -150,7 +150,7 @@ void test_integration_hub_overrides_scheduler_for_current_tick() {
     ThermoDeviceController thermoDevice(sender, receiver, hub, scheduler, logger);
     thermoDevice.begin(true);
 
-    TEST_ASSERT_TRUE(scheduler.addEntry(500, Command::OFF));
+    TEST_ASSERT_TRUE(scheduler.addEntry(0, 500, Command::OFF));
     TEST_ASSERT_TRUE(hub.pushMockCommand(Command::ON));
 
     WallClockSnapshot wall = makeWall(20260223, 1, 6, 30, 0, 500, 500000);
@@ -1,6 +1,8 @@
 #include <unity.h>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
+#include <string>
 
 #include "IRSender.h"
 #define private public
@@ -8,12 +10,31 @@
 #include "app/adaptive_thermostat_tuning.h"
 #include "app/retrofit_controller.h"
 #undef private
+#include "core/spsc_queue.h"
+#include "core/timer_wheel.h"
+#include "crypto/aes_gcm.h"
+#include "crypto/base64.h"
+#include "crypto/message_crypto.h"
+#include "diagnostics/diag.h"
+#include "hub/circuit_breaker.h"
 #include "heater/heater.h"
 #include "hub_additions/hub_ai_insights.h"
+#include "hub_additions/hub_loopback_endpoint.h"
+#include "hub/hub_link.h"
+#include "hub/hub_long_poll.h"
+#include "hub/hub_messages.h"
 #include "hub/hub_receiver.h"
+#include "hub/request_stats.h"
+#include "hub/schedule_codec.h"
+#include "hub/schedule_store.h"
+#include "hub/schedule_sync.h"
+#include "hub/telemetry_codec.h"
+#include "hub/telemetry_policy.h"
+#include "hub/telemetry_ring.h"
 #include "hub_additions/hub_mock_scheduler.h"
 #include "logger.h"
 #include "scheduler/scheduler.h"
+#include "scheduler/weekly_plan.h"
 #include "time/mock_clock.h"
 
 namespace {
@@ -178,7 +199,7 @@ void test_scheduler_relative_due() {
     CommandScheduler scheduler;
     scheduler.setEnabled(true);
 
-    TEST_ASSERT_TRUE(scheduler.addEntry(1000, Command::ON));
+    TEST_ASSERT_TRUE(scheduler.addEntry(0, 1000, Command::ON));
 
     Command out = Command::NONE;
     const WallClockSnapshot noWall{};
@@ -211,7 +232,7 @@ void test_scheduler_daily_once_per_day() {
 void test_scheduler_next_planned_command() {
     CommandScheduler scheduler;
     scheduler.setEnabled(true);
-    TEST_ASSERT_TRUE(scheduler.addEntry(7000, Command::OFF));
+    TEST_ASSERT_TRUE(scheduler.addEntry(5000, 7000, Command::OFF));
     TEST_ASSERT_TRUE(scheduler.addDailyEntry(9, 0, 0, Command::ON, kWeekdayAll));
 
     const WallClockSnapshot wall = makeWall(20260223, 1, 8, 59, 55, true);
@@ -225,6 +246,147 @@ void test_scheduler_next_planned_command() {
     TEST_ASSERT_EQUAL_UINT32(2, dueInSec);
 }
 
+// Entries fire in time order whatever slot they landed in; N is a compile-time capacity.
+void test_scheduler_fires_in_time_order_at_capacity() {
+    FixedCommandScheduler<256> scheduler;
+    scheduler.setEnabled(true);
+    for (uint32_t i = 0; i < 256; ++i) {
+        TEST_ASSERT_TRUE(scheduler.addEntry(0, 100000U - i * 10U, i % 2U ? Command::TEMP_UP : Command::TEMP_DOWN));
+    }
+    TEST_ASSERT_FALSE(scheduler.addEntry(0, 1, Command::TEMP_UP));
+
+    const WallClockSnapshot noWall{};
+    Command out = Command::NONE;
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(100000U - 2551U, noWall, out));
+    TEST_ASSERT_TRUE(scheduler.nextDueCommand(100000U - 2550U, noWall, out));
+    TEST_ASSERT_EQUAL(Command::TEMP_UP, out);
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(100000U - 2550U, noWall, out));
+
+    size_t fired = 1;
+    while (scheduler.nextDueCommand(100000U, noWall, out)) {
+        ++fired;
+    }
+    TEST_ASSERT_EQUAL_UINT32(256, fired);
+    TEST_ASSERT_TRUE(scheduler.addEntry(100000U, 100001U, Command::TEMP_UP));
+}
+
+// Timers expire earliest first, cancelled ones never, and a late poll fires a periodic timer once, in phase.
+void test_timer_wheel_orders_cancels_and_repeats() {
+    TimerWheel<4> wheel;
+    const TimerId a = wheel.start(100, 1);
+    TEST_ASSERT_NOT_EQUAL(kNoTimer, wheel.start(50, 2));
+    const TimerId c = wheel.start(100, 3);
+    const TimerId periodic = wheel.start(30, 4, 40);
+    TEST_ASSERT_EQUAL(kNoTimer, wheel.start(10, 5));
+    TEST_ASSERT_TRUE(wheel.cancel(c));
+    TEST_ASSERT_FALSE(wheel.cancel(c));
+
+    TimerExpiry expired;
+    TEST_ASSERT_FALSE(wheel.poll(29, expired));
+    TEST_ASSERT_TRUE(wheel.poll(30, expired));
+    TEST_ASSERT_EQUAL_UINT32(periodic, expired.id);
+    const uint32_t expected[] = {2, 4, 1};  // 50, 70, 100
+    for (uint32_t cookie : expected) {
+        TEST_ASSERT_TRUE(wheel.poll(100, expired));
+        TEST_ASSERT_EQUAL_UINT32(cookie, expired.cookie);
+    }
+    TEST_ASSERT_FALSE(wheel.poll(100, expired));
+    TEST_ASSERT_FALSE(wheel.pending(a));
+    TEST_ASSERT_TRUE(wheel.pending(periodic));
+
+    TEST_ASSERT_TRUE(wheel.poll(1000, expired));
+    TEST_ASSERT_EQUAL_UINT32(110, expired.atMs);
+    TEST_ASSERT_FALSE(wheel.poll(1000, expired));
+    TEST_ASSERT_TRUE(wheel.next(expired));
+    TEST_ASSERT_EQUAL_UINT32(1030, expired.atMs);
+    TEST_ASSERT_TRUE(wheel.cancel(periodic));
+    TEST_ASSERT_FALSE(wheel.next(expired));
+}
+
+// Relative entries due just past the millis() wrap wait for it instead of firing at once.
+void test_scheduler_relative_entries_survive_millis_wrap() {
+    TimerWheel<2> wheel(0xFFFFFF00U);
+    TimerExpiry expired;
+    TEST_ASSERT_NOT_EQUAL(kNoTimer, wheel.start(0x100U, 7));
+    TEST_ASSERT_FALSE(wheel.poll(0xFFFFFFFFU, expired));
+    TEST_ASSERT_FALSE(wheel.poll(0xFFU, expired));
+    TEST_ASSERT_TRUE(wheel.poll(0x100U, expired));
+    TEST_ASSERT_EQUAL_UINT32(7, expired.cookie);
+
+    CommandScheduler scheduler;
+    scheduler.setEnabled(true);
+    const WallClockSnapshot noWall{};
+    Command out = Command::NONE;
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0xFFFFFF00U, noWall, out));
+    TEST_ASSERT_TRUE(scheduler.addEntry(0xFFFFFF00U, 0xFFFFFF00U + 0x200U, Command::TEMP_UP));
+    uint32_t dueInSec = 99;
+    bool usesWall = true;
+    TEST_ASSERT_TRUE(scheduler.nextPlannedCommand(0xFFFFFF00U, noWall, out, dueInSec, usesWall));
+    TEST_ASSERT_EQUAL_UINT32(0, dueInSec);
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0xFFFFFFFFU, noWall, out));
+    TEST_ASSERT_TRUE(scheduler.nextDueCommand(0x100U, noWall, out));
+    TEST_ASSERT_EQUAL(Command::TEMP_UP, out);
+}
+
+// A scheduler left disabled for longer than 2^31 ms still places a new relative entry against now.
+void test_scheduler_relative_entries_after_long_disable() {
+    CommandScheduler scheduler;
+    const WallClockSnapshot noWall{};
+    Command out = Command::NONE;
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0x40000000U, noWall, out));
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0xC0000000U, noWall, out));
+    TEST_ASSERT_TRUE(scheduler.addEntry(0xC0000000U, 0xC0000000U + 1000U, Command::TEMP_DOWN));
+    scheduler.setEnabled(true);
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0xC0000000U + 999U, noWall, out));
+    TEST_ASSERT_TRUE(scheduler.nextDueCommand(0xC0000000U + 1000U, noWall, out));
+    TEST_ASSERT_EQUAL(Command::TEMP_DOWN, out);
+
+    // An unpolled wheel catches up before a start() far from its last time.
+    TimerWheel<2> wheel;
+    wheel.advanceTo(0x90000000U);
+    TEST_ASSERT_NOT_EQUAL(kNoTimer, wheel.start(0x90000000U + 50U, 3));
+    TimerExpiry expired;
+    TEST_ASSERT_FALSE(wheel.poll(0x90000000U + 49U, expired));
+    TEST_ASSERT_TRUE(wheel.poll(0x90000000U + 50U, expired));
+    TEST_ASSERT_EQUAL_UINT32(3, expired.cookie);
+}
+
+// A clock jump to another date rebuilds the daily index against the new date.
+void test_scheduler_daily_index_follows_clock_jumps() {
+    TEST_ASSERT_EQUAL_UINT32(0, scheduling::dayNumber(19700101));
+    TEST_ASSERT_EQUAL_UINT32(11017, scheduling::dayNumber(20000301));
+    TEST_ASSERT_EQUAL_UINT32(20507, scheduling::dayNumber(20260223));
+
+    CommandScheduler scheduler;
+    scheduler.setEnabled(true);
+    TEST_ASSERT_TRUE(scheduler.addDailyEntry(8, 0, 0, Command::TEMP_UP, kWeekdayMonday));
+
+    Command out = Command::NONE;
+    TEST_ASSERT_TRUE(scheduler.nextDueCommand(0, makeWall(20260223, 1, 9, 0, 0, true), out));
+    TEST_ASSERT_EQUAL(Command::TEMP_UP, out);
+
+    // Wednesday is not in the mask; setting the clock back to Monday does not refire.
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0, makeWall(20260225, 3, 9, 0, 0, true), out));
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0, makeWall(20260223, 1, 8, 30, 0, true), out));
+
+    // An entry added once the index exists is planned from the index date.
+    TEST_ASSERT_TRUE(scheduler.addDailyEntry(10, 0, 0, Command::TEMP_DOWN, kWeekdayAll));
+    Command next = Command::NONE;
+    uint32_t dueInSec = 0;
+    bool usesWall = false;
+    const WallClockSnapshot mondayAt930 = makeWall(20260223, 1, 9, 30, 0, true);
+    TEST_ASSERT_TRUE(scheduler.nextPlannedCommand(0, mondayAt930, next, dueInSec, usesWall));
+    TEST_ASSERT_EQUAL(Command::TEMP_DOWN, next);
+    TEST_ASSERT_TRUE(usesWall);
+    TEST_ASSERT_EQUAL_UINT32(1800, dueInSec);
+
+    TEST_ASSERT_TRUE(scheduler.nextDueCommand(0, makeWall(20260302, 1, 8, 0, 0, true), out));
+    TEST_ASSERT_EQUAL(Command::TEMP_UP, out);
+    TEST_ASSERT_TRUE(scheduler.nextDueCommand(0, makeWall(20260302, 1, 10, 0, 0, true), out));
+    TEST_ASSERT_EQUAL(Command::TEMP_DOWN, out);
+    TEST_ASSERT_FALSE(scheduler.nextDueCommand(0, makeWall(20260302, 1, 23, 0, 0, true), out));
+}
+
 // Logger must preserve failure detailCode field.
 void test_logger_detail_code_is_recorded() {
     Logger logger;
@@ -248,6 +410,939 @@ void test_logger_detail_code_is_recorded() {
     TEST_ASSERT_EQUAL_UINT8(4, first.detailCode);
 }
 
+// copySince must return only entries newer than the cursor, clamped to the ring.
+void test_logger_copy_since_returns_new_entries_in_order() {
+    Logger logger;
+    WallClockSnapshot ts{};
+    for (uint8_t i = 0; i < 5; ++i) {
+        logger.log(ts, LogEventType::COMMAND_SENT, Command::ON_OFF, true, i);
+    }
+
+    LogEntry out[8];
+    uint32_t first = 0;
+    TEST_ASSERT_EQUAL_UINT32(2, logger.copySince(3, out, 8, first));
+    TEST_ASSERT_EQUAL_UINT32(3, first);
+    TEST_ASSERT_EQUAL_UINT8(3, out[0].detailCode);
+    TEST_ASSERT_EQUAL_UINT8(4, out[1].detailCode);
+    TEST_ASSERT_EQUAL_UINT32(0, logger.copySince(5, out, 8, first));
+
+    for (size_t i = 0; i < Logger::kCapacity; ++i) {
+        logger.log(ts, LogEventType::COMMAND_SENT, Command::ON_OFF, true, 9);
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, logger.copySince(0, out, 8, first));
+    TEST_ASSERT_EQUAL_UINT32(5, first);
+}
+
+// Packed log entries keep wall time to the ms and expand local calendar fields on read.
+void test_packed_log_entry_round_trips_wall_time() {
+    // 2026-01-01 00:00:00.123 UTC seen from UTC+05:45.
+    WallClockSnapshot ts{};
+    ts.valid   = true;
+    ts.bootMs  = 4242;
+    ts.unixMs  = 1767225600123ULL;
+    ts.dateKey = 20260101;
+    ts.hour    = 5;
+    ts.minute  = 45;
+    ts.second  = 0;
+    ts.weekday = 4;
+
+    const LogEntry e =
+        PackedLogEntry::pack(ts, LogEventType::HUB_LINK_UP, Command::LEARN_CUSTOM, true, 201).unpack();
+    TEST_ASSERT_TRUE(e.wallTimeValid);
+    TEST_ASSERT_TRUE(e.unixMs == ts.unixMs);
+    TEST_ASSERT_EQUAL_UINT32(4242, e.uptimeMs);
+    TEST_ASSERT_EQUAL_UINT32(20260101, e.dateKey);
+    TEST_ASSERT_EQUAL_UINT8(5, e.hour);
+    TEST_ASSERT_EQUAL_UINT8(45, e.minute);
+    TEST_ASSERT_EQUAL_UINT8(4, e.weekday);
+    TEST_ASSERT_EQUAL(LogEventType::HUB_LINK_UP, e.type);
+    TEST_ASSERT_EQUAL(Command::LEARN_CUSTOM, e.command);
+    TEST_ASSERT_TRUE(e.success);
+    TEST_ASSERT_EQUAL_UINT8(201, e.detailCode);
+
+    ts.valid = false;
+    const LogEntry noWall =
+        PackedLogEntry::pack(ts, LogEventType::COMMAND_SENT, Command::NONE, false, 0).unpack();
+    TEST_ASSERT_FALSE(noWall.wallTimeValid);
+    TEST_ASSERT_EQUAL_UINT32(0, noWall.dateKey);
+}
+
+// A RAM-only logger sized at compile time wraps at N and never persists.
+void test_event_logger_capacity_is_compile_time() {
+    EventLogger<16, RamLogStorage> logger;
+    TEST_ASSERT_EQUAL_UINT32(16, (EventLogger<16, RamLogStorage>::kCapacity));
+    TEST_ASSERT_FALSE(logger.beginPersistence("log"));
+
+    WallClockSnapshot ts{};
+    for (uint32_t i = 0; i < 20; ++i) {
+        ts.bootMs = i;
+        logger.log(ts, LogEventType::COMMAND_SENT, Command::ON_OFF, true);
+    }
+    TEST_ASSERT_EQUAL_UINT32(16, logger.size());
+    TEST_ASSERT_EQUAL_UINT32(16, logger.entries()[0].uptimeMs);
+    TEST_ASSERT_EQUAL_UINT32(19, logger.entries()[3].uptimeMs);
+
+    LogEntry out[4];
+    uint32_t first = 0;
+    TEST_ASSERT_EQUAL_UINT32(4, logger.copySince(0, out, 4, first));
+    TEST_ASSERT_EQUAL_UINT32(4, first);
+    TEST_ASSERT_EQUAL_UINT32(4, out[0].uptimeMs);
+}
+
+// With a drain attached log() only queues; a full queue drops and counts entries.
+void test_log_drain_queues_and_counts_drops() {
+    LogDrain drain;
+    EventLogger<16, RamLogStorage> logger;
+    logger.setDrain(&drain);
+
+    WallClockSnapshot ts{};
+    for (size_t i = 0; i < kLogDrainQueueDepth + 5; ++i) {
+        logger.log(ts, LogEventType::COMMAND_SENT, Command::ON_OFF, true);
+    }
+    LogDrain::Stats stats = drain.stats();
+    TEST_ASSERT_EQUAL_UINT32(kLogDrainQueueDepth + 5, stats.posted);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.printed);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overflows);
+    TEST_ASSERT_EQUAL_UINT32(kLogDrainQueueDepth, stats.maxDepth);
+
+    TEST_ASSERT_EQUAL_UINT32(kLogDrainQueueDepth, drain.drain());
+    logger.log(ts, LogEventType::COMMAND_SENT, Command::ON_OFF, true);
+    TEST_ASSERT_EQUAL_UINT32(1, drain.drain());
+    stats = drain.stats();
+    TEST_ASSERT_EQUAL_UINT32(kLogDrainQueueDepth + 1, stats.printed);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overflows);
+}
+
+// Tokenized frames: FNV-1a token, then zigzag varints, f32 and length-prefixed strings.
+void test_diag_tokenized_frame_encoding() {
+    static_assert(diag::token("a") == 0xE40C292CU, "token must match scripts/gen_token_db.py");
+    TEST_ASSERT_EQUAL_HEX32(0x811C9DC5U, diag::token(""));
+
+    uint8_t frame[diag::kTokenizedMaxBytes];
+    const size_t length = diag::encodeTokenized(frame, sizeof(frame), 0x04030201U,
+                                                -2, 300U, 1.5f, "fan", true);
+    const uint8_t expected[] = {0x01, 0x02, 0x03, 0x04,  // token, little endian
+                                0x03,                    // -2
+                                0xD8, 0x04,              // 300
+                                0x00, 0x00, 0xC0, 0x3F,  // 1.5f
+                                0x03, 'f', 'a', 'n',
+                                0x02};                   // true
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, sizeof(expected));
+
+    // A string that does not fit is cut and flagged in its length byte.
+    uint8_t small[8];
+    TEST_ASSERT_EQUAL_UINT32(8, diag::encodeTokenized(small, sizeof(small), 0U, "abcdefgh"));
+    TEST_ASSERT_EQUAL_HEX8(0x80U | 3U, small[4]);
+    TEST_ASSERT_EQUAL_MEMORY("abc", small + 5, 3);
+}
+
+#if LOG_STORAGE_HAS_NVS
+// NVS segments restore the newest contiguous run; another capacity starts the namespace afresh.
+void test_nvs_log_storage_restores_newest_segments() {
+    Preferences::wipe();
+    WallClockSnapshot ts{};
+    {
+        EventLogger<16, NvsLogStorage> logger;
+        TEST_ASSERT_TRUE(logger.beginPersistence("evlog"));
+        for (uint32_t i = 1; i <= 36; ++i) {
+            ts.bootMs = i;
+            logger.log(ts, LogEventType::STATE_CHANGE, Command::NONE, true);
+        }
+    }
+    // Sequences 0..35: s0 holds 32..35 and s1 24..31, so 16..23 are gone.
+    TEST_ASSERT_EQUAL_UINT32(3, Preferences::keys("evlog").size());
+
+    EventLogger<16, NvsLogStorage> restored;
+    TEST_ASSERT_TRUE(restored.beginPersistence("evlog"));
+    TEST_ASSERT_EQUAL_UINT32(12, restored.size());
+    TEST_ASSERT_EQUAL_UINT32(36, restored.entries()[3].uptimeMs);
+    TEST_ASSERT_EQUAL_UINT32(25, restored.entries()[8].uptimeMs);
+
+    ts.bootMs = 37;
+    restored.log(ts, LogEventType::STATE_CHANGE, Command::NONE, true);
+    EventLogger<16, NvsLogStorage> again;
+    TEST_ASSERT_TRUE(again.beginPersistence("evlog"));
+    TEST_ASSERT_EQUAL_UINT32(13, again.size());
+    TEST_ASSERT_EQUAL_UINT32(37, again.entries()[4].uptimeMs);
+
+    EventLogger<8, NvsLogStorage> smaller;
+    TEST_ASSERT_TRUE(smaller.beginPersistence("evlog"));
+    TEST_ASSERT_EQUAL_UINT32(0, smaller.size());
+    TEST_ASSERT_EQUAL_UINT32(1, Preferences::keys("evlog").size());
+}
+#endif
+
+#if LOG_STORAGE_HAS_MMAP
+// The mapped-file backend keeps every entry and restores the newest N on reopen.
+void test_mapped_file_log_storage_restores_ring() {
+    const char* path = "test_event_log.bin";
+    std::remove(path);
+    WallClockSnapshot ts{};
+    {
+        EventLogger<8, MappedFileLogStorage> logger;
+        ts.bootMs = 1;
+        logger.log(ts, LogEventType::STATE_CHANGE, Command::NONE, true);  // before begin: kept
+        TEST_ASSERT_TRUE(logger.beginPersistence(path));
+        for (uint32_t i = 2; i <= 100; ++i) {
+            ts.bootMs = i;
+            logger.log(ts, LogEventType::STATE_CHANGE, Command::NONE, true);
+        }
+    }
+
+    EventLogger<8, MappedFileLogStorage> restored;
+    TEST_ASSERT_TRUE(restored.beginPersistence(path));
+    TEST_ASSERT_EQUAL_UINT32(8, restored.size());
+    TEST_ASSERT_TRUE(restored.storage().recordCount() == 100U);
+    TEST_ASSERT_EQUAL_UINT32(1, restored.storage().records()[0].unpack().uptimeMs);
+    // 100 entries persisted at sequences 0..99: the newest sits in slot 99 % 8.
+    TEST_ASSERT_EQUAL_UINT32(100, restored.entries()[3].uptimeMs);
+    TEST_ASSERT_EQUAL_UINT32(93, restored.entries()[4].uptimeMs);
+
+    ts.bootMs = 101;
+    restored.log(ts, LogEventType::STATE_CHANGE, Command::NONE, true);
+    TEST_ASSERT_TRUE(restored.storage().recordCount() == 101U);
+    restored.storage().close();
+    std::remove(path);
+}
+#endif
+
+// Telemetry ring keeps samples oldest-first and drops the oldest when full.
+void test_telemetry_ring_drops_oldest_and_drains_in_order() {
+    TelemetryRing ring;
+    for (uint32_t i = 0; i < TelemetryRing::kCapacity + 3; ++i) {
+        TelemetrySample s{};
+        s.bootMs = i;
+        ring.push(s);
+    }
+    TEST_ASSERT_EQUAL_UINT32(TelemetryRing::kCapacity, ring.size());
+    TEST_ASSERT_EQUAL_UINT32(3, ring.dropped());
+
+    TelemetrySample out[4];
+    TEST_ASSERT_EQUAL_UINT32(4, ring.peek(out, 4));
+    TEST_ASSERT_EQUAL_UINT32(3, out[0].bootMs);
+    ring.pop(2);
+    TEST_ASSERT_EQUAL_UINT32(1, ring.peek(out, 1));
+    TEST_ASSERT_EQUAL_UINT32(5, out[0].bootMs);
+    ring.pop(TelemetryRing::kCapacity);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+#if TELEMETRY_RING_HAS_PREFERENCES
+// After a reboot, spilled samples without wall time cannot be dated by bootMs and are dropped.
+void test_telemetry_ring_drops_undated_samples_from_an_earlier_boot() {
+    Preferences::wipe();
+    auto fill = [](TelemetryRing& ring, bool dated) {
+        for (uint32_t i = 0; i < TelemetryRing::kCapacity + TelemetryRing::kBlockSize; ++i) {
+            TelemetrySample s{};
+            s.bootMs = i;
+            s.unixMs = dated && i >= 4 && i != 10 ? 1700000000000ULL + i : 0;
+            ring.push(s);
+        }
+    };
+    TelemetrySample out[TelemetryRing::kBlockSize];
+    {
+        TelemetryRing ring;
+        TEST_ASSERT_TRUE(ring.beginSpill("tring"));
+        fill(ring, true);
+        TEST_ASSERT_EQUAL_UINT32(TelemetryRing::kBlockSize, ring.spilled());
+        // Same boot: bootMs still dates them.
+        TEST_ASSERT_EQUAL_UINT32(4, ring.peek(out, 4));
+        TEST_ASSERT_EQUAL_UINT32(0, out[0].bootMs);
+    }
+
+    TelemetryRing rebooted;
+    TEST_ASSERT_TRUE(rebooted.beginSpill("tring"));
+    TEST_ASSERT_EQUAL_UINT32(TelemetryRing::kBlockSize, rebooted.size());
+    TEST_ASSERT_EQUAL_UINT32(6, rebooted.peek(out, TelemetryRing::kBlockSize));
+    TEST_ASSERT_EQUAL_UINT32(4, out[0].bootMs);
+    TEST_ASSERT_EQUAL_UINT32(4, rebooted.dropped());
+    rebooted.pop(6);
+    TEST_ASSERT_EQUAL_UINT32(5, rebooted.peek(out, TelemetryRing::kBlockSize));
+    TEST_ASSERT_EQUAL_UINT32(11, out[0].bootMs);
+    rebooted.pop(5);
+    TEST_ASSERT_TRUE(rebooted.empty());
+    TEST_ASSERT_EQUAL_UINT32(5, rebooted.dropped());
+
+    // Undated samples spilled in this boot are kept.
+    fill(rebooted, false);
+    TEST_ASSERT_EQUAL_UINT32(4, rebooted.peek(out, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, out[0].bootMs);
+    TEST_ASSERT_EQUAL_UINT32(5, rebooted.dropped());
+}
+#endif
+
+// The weekly plan fires each entry once a week and replays only the latest missed setpoint.
+void test_weekly_plan_fires_once_per_week_and_skips_missed_commands() {
+    const uint16_t monday = kMinutesPerDay;
+    const uint16_t tuesday = 2 * kMinutesPerDay;
+    WeeklyPlan<4> plan;
+    TEST_ASSERT_TRUE(plan.append(WeeklyEntry::commandAt(monday + 7 * 60, Command::ON_OFF)));
+    TEST_ASSERT_TRUE(plan.append(WeeklyEntry::setpointAt(monday + 7 * 60, 2100)));
+    TEST_ASSERT_TRUE(plan.append(WeeklyEntry::setpointAt(monday + 22 * 60, 1700)));
+    TEST_ASSERT_FALSE(plan.append(WeeklyEntry::commandAt(monday + 6 * 60, Command::ON_OFF)));
+    TEST_ASSERT_FALSE(plan.append(WeeklyEntry::commandAt(kMinutesPerWeek, Command::ON_OFF)));
+    TEST_ASSERT_TRUE(plan.append(WeeklyEntry::commandAt(tuesday + 7 * 60, Command::ON_OFF)));
+    TEST_ASSERT_FALSE(plan.append(WeeklyEntry::commandAt(tuesday + 8 * 60, Command::ON_OFF)));
+    TEST_ASSERT_EQUAL_UINT32(4, plan.size());
+
+    // Boot at noon: the 07:00 ON_OFF is skipped, the 07:00 setpoint still applies.
+    ScheduleAction action;
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260223, 1, 12, 0, 0, true), action));
+    TEST_ASSERT_TRUE(action.setpoint);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, action.setpointC);
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260223, 1, 12, 0, 0, true), action));
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260223, 1, 22, 0, 30, true), action));
+    TEST_ASSERT_EQUAL_FLOAT(17.0f, action.setpointC);
+
+    // Clock jumps back within the day, or to Wednesday and back: nothing fires twice.
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260223, 1, 8, 0, 0, true), action));
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260225, 3, 8, 0, 0, true), action));
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260223, 1, 23, 0, 0, true), action));
+
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260224, 2, 6, 59, 59, true), action));
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260224, 2, 7, 0, 0, true), action));
+    TEST_ASSERT_FALSE(action.setpoint);
+    TEST_ASSERT_EQUAL(Command::ON_OFF, action.command);
+
+    // A new week starts with every entry unfired, same-minute entries in plan order.
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260302, 1, 7, 0, 0, true), action));
+    TEST_ASSERT_EQUAL(Command::ON_OFF, action.command);
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260302, 1, 7, 0, 0, true), action));
+    TEST_ASSERT_TRUE(action.setpoint);
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260302, 1, 7, 0, 0, true), action));
+}
+
+// sch2 frames round-trip, load into a weekly plan, and bad or oversized frames leave it untouched.
+void test_schedule_codec_loads_weekly_plan() {
+    const WeeklyEntry entries[2] = {
+        WeeklyEntry::setpointAt(kMinutesPerDay + 6 * 60 + 30, 2150),
+        WeeklyEntry::commandAt(6 * kMinutesPerDay + 9 * 60, Command::TEMP_DOWN),
+    };
+
+    uint8_t frame[schedule_codec::kHeaderSize + 2 * schedule_codec::kEntrySize];
+    TEST_ASSERT_EQUAL_UINT32(0, schedule_codec::encode(entries, 2, frame, sizeof(frame) - 1));
+    const size_t length = schedule_codec::encode(entries, 2, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frame), length);
+    // Same bytes as compile_schedule() in thermohub.py for this plan.
+    const uint8_t expected[] = {2, 2, 0, 0x26, 0x07, 0x66, 0x88, 0xDC, 0x23, 3, 0};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, sizeof(expected));
+
+    WeeklyPlan<1> small;
+    TEST_ASSERT_FALSE(schedule_codec::load(frame, length, small));
+    WeeklyPlan<2> plan;
+    TEST_ASSERT_TRUE(plan.append(WeeklyEntry::commandAt(0, Command::ON_OFF)));
+    TEST_ASSERT_TRUE(schedule_codec::load(frame, length, plan));
+    TEST_ASSERT_EQUAL_UINT32(2, plan.size());
+
+    ScheduleAction action;
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260223, 1, 13, 0, 0, true), action));
+    TEST_ASSERT_TRUE(action.setpoint);
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, action.setpointC);
+    TEST_ASSERT_FALSE(plan.nextDueAction(makeWall(20260223, 1, 13, 0, 0, true), action));
+    TEST_ASSERT_TRUE(plan.nextDueAction(makeWall(20260228, 6, 9, 0, 0, true), action));
+    TEST_ASSERT_EQUAL(Command::TEMP_DOWN, action.command);
+
+    frame[3 + schedule_codec::kEntrySize + 2] = 0x09;  // command 9
+    TEST_ASSERT_FALSE(schedule_codec::load(frame, length, plan));
+    frame[3 + schedule_codec::kEntrySize + 2] = 3;
+    frame[3 + schedule_codec::kEntrySize + 1] = 0x00;  // earlier than entry 0
+    TEST_ASSERT_FALSE(schedule_codec::load(frame, length, plan));
+    frame[3 + schedule_codec::kEntrySize + 1] = 0x23;
+    TEST_ASSERT_FALSE(schedule_codec::load(frame, length - 1, plan));
+    TEST_ASSERT_EQUAL_UINT32(2, plan.size());
+}
+
+// The cached frame and its ETag survive a reboot; a corrupt or oversized frame is not loaded.
+void test_schedule_store_round_trips_frame_and_etag() {
+    Preferences::wipe();
+    const WeeklyEntry entries[2] = {
+        WeeklyEntry::setpointAt(6 * 60, 2100),
+        WeeklyEntry::commandAt(22 * 60, Command::TEMP_DOWN),
+    };
+    uint8_t frame[schedule_codec::kHeaderSize + 2 * schedule_codec::kEntrySize];
+    const size_t length = schedule_codec::encode(entries, 2, frame, sizeof(frame));
+
+    {
+        ScheduleStore store;
+        TEST_ASSERT_TRUE(store.begin("sched"));
+        TEST_ASSERT_TRUE(store.save(frame, length, "\"v1\""));
+    }
+    ScheduleStore store;
+    TEST_ASSERT_TRUE(store.begin("sched"));
+    uint8_t out[sizeof(frame)] = {};
+    size_t outLength = 0;
+    char etag[ScheduleStore::kEtagSize] = {'x'};
+    TEST_ASSERT_TRUE(store.load(out, sizeof(out), outLength, etag));
+    TEST_ASSERT_EQUAL_UINT32(length, outLength);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, out, length);
+    TEST_ASSERT_EQUAL_STRING("\"v1\"", etag);
+
+    // A frame the hub sent without an ETag must not keep the old one.
+    TEST_ASSERT_TRUE(store.save(frame, length, ""));
+    TEST_ASSERT_TRUE(store.load(out, sizeof(out), outLength, etag));
+    TEST_ASSERT_EQUAL_STRING("", etag);
+
+    TEST_ASSERT_FALSE(store.load(out, sizeof(out) - 1, outLength, etag));
+    frame[0] = schedule_codec::kVersion + 1;
+    TEST_ASSERT_TRUE(store.save(frame, length, "\"v2\""));
+    TEST_ASSERT_FALSE(store.load(out, sizeof(out), outLength, etag));
+
+    ScheduleStore closed;
+    TEST_ASSERT_FALSE(closed.load(out, sizeof(out), outLength, etag));
+    TEST_ASSERT_FALSE(closed.save(frame, length, nullptr));
+}
+
+// A 304 keeps the plan restored from NVS; only a valid frame that fits replaces it.
+void test_schedule_sync_keeps_cached_plan_until_a_new_one_arrives() {
+    Preferences::wipe();
+    HubReceiver receiver;
+    Logger logger;
+    HubLink link(receiver, logger);
+    const WeeklyEntry entries[2] = {
+        WeeklyEntry::commandAt(7 * 60, Command::ON_OFF),
+        WeeklyEntry::commandAt(23 * 60, Command::ON_OFF),
+    };
+    uint8_t frame[schedule_codec::kHeaderSize + 2 * schedule_codec::kEntrySize];
+    const size_t length = schedule_codec::encode(entries, 2, frame, sizeof(frame));
+    {
+        ScheduleStore store;
+        TEST_ASSERT_TRUE(store.begin("sched"));
+        TEST_ASSERT_TRUE(store.save(frame, length, "\"v1\""));
+    }
+
+    ScheduleSync sync(link);
+    TEST_ASSERT_TRUE(sync.begin("sched"));
+    TEST_ASSERT_TRUE(sync.local());
+    TEST_ASSERT_EQUAL_STRING("\"v1\"", sync.etag());
+    size_t pendingLength = 0;
+    TEST_ASSERT_NOT_NULL(link.pendingSchedule(pendingLength));
+    TEST_ASSERT_EQUAL_UINT32(length, pendingLength);
+    link.clearPendingSchedule();
+
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::NOT_MODIFIED, sync.onResponse(304, nullptr, 0, ""));
+    TEST_ASSERT_NULL(link.pendingSchedule(pendingLength));
+    TEST_ASSERT_TRUE(sync.local());
+    TEST_ASSERT_EQUAL_STRING("\"v1\"", sync.etag());
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::RETRY, sync.onResponse(-1, nullptr, 0, ""));
+
+    uint8_t corrupt[sizeof(frame)];
+    memcpy(corrupt, frame, sizeof(frame));
+    corrupt[0] = schedule_codec::kVersion + 1;
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::RETRY,
+                      sync.onResponse(200, corrupt, sizeof(corrupt), "\"v2\""));
+    TEST_ASSERT_EQUAL_STRING("\"v1\"", sync.etag());
+
+    frame[schedule_codec::kHeaderSize + schedule_codec::kEntrySize + 2] =
+        static_cast<uint8_t>(Command::TEMP_UP);
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::APPLIED, sync.onResponse(200, frame, length, "\"v2\""));
+    TEST_ASSERT_EQUAL_STRING("\"v2\"", sync.etag());
+    TEST_ASSERT_NOT_NULL(link.pendingSchedule(pendingLength));
+    // loop() still holds that plan, so the next one waits for a retry.
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::RETRY, sync.onResponse(200, frame, length, "\"v3\""));
+    link.clearPendingSchedule();
+
+    ScheduleSync rebooted(link);
+    TEST_ASSERT_TRUE(rebooted.begin("sched"));
+    TEST_ASSERT_EQUAL_STRING("\"v2\"", rebooted.etag());
+    const uint8_t* restored = link.pendingSchedule(pendingLength);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, restored, length);
+    link.clearPendingSchedule();
+
+    // More entries than SchedulePlan holds: the hub goes back to running it.
+    static WeeklyEntry many[SchedulePlan::kCapacity + 1];
+    for (size_t i = 0; i < SchedulePlan::kCapacity + 1; ++i) {
+        many[i] = WeeklyEntry::commandAt(static_cast<uint16_t>(i * 20), Command::TEMP_UP);
+    }
+    static uint8_t big[schedule_codec::kHeaderSize + sizeof(many)];
+    const size_t bigLength = schedule_codec::encode(many, SchedulePlan::kCapacity + 1, big, sizeof(big));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(big), bigLength);
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::HUB_RUNS_IT, rebooted.onResponse(200, big, bigLength, "\"v4\""));
+    TEST_ASSERT_FALSE(rebooted.local());
+    TEST_ASSERT_NULL(rebooted.etag());
+    TEST_ASSERT_NULL(link.pendingSchedule(pendingLength));
+
+    const char json[] = "{\"schedule\":[]}";
+    TEST_ASSERT_EQUAL(ScheduleSync::Outcome::HUB_RUNS_IT,
+                      rebooted.onResponse(200, reinterpret_cast<const uint8_t*>(json), sizeof(json) - 1, ""));
+}
+
+// Binary telemetry frames must round-trip within fixed-point precision.
+void test_telemetry_codec_round_trips_samples() {
+    uint8_t frame[telemetry_codec::kHeaderSize + 2 * telemetry_codec::kSampleSize];
+    telemetry_codec::FrameWriter writer(frame, sizeof(frame));
+
+    TelemetrySample wall{};
+    wall.unixMs      = 1700000000123ULL;
+    wall.roomTempC   = 21.37f;
+    wall.targetTempC = -999.0f;
+    wall.pidI        = -0.125f;
+    wall.pidSteps    = -2;
+    wall.powerOn     = true;
+    wall.ecoMode     = true;
+    TelemetrySample aged{};
+    aged.bootMs    = 1000;
+    aged.roomTempC = 19.5f;
+
+    TEST_ASSERT_TRUE(writer.addSample(wall, 5000));
+    TEST_ASSERT_TRUE(writer.addSample(aged, 5000));
+    TEST_ASSERT_FALSE(writer.addSample(aged, 5000));
+    const size_t length = writer.finish();
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frame), length);
+
+    TelemetrySample out{};
+    TEST_ASSERT_TRUE(telemetry_codec::decodeSample(frame, length, 0, 5000, out));
+    TEST_ASSERT_TRUE(out.unixMs == wall.unixMs);
+    TEST_ASSERT_FLOAT_WITHIN(0.006f, 21.37f, out.roomTempC);
+    TEST_ASSERT_EQUAL_FLOAT(-999.0f, out.targetTempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -0.125f, out.pidI);
+    TEST_ASSERT_EQUAL_INT8(-2, out.pidSteps);
+    TEST_ASSERT_TRUE(out.powerOn && out.ecoMode);
+
+    TEST_ASSERT_TRUE(telemetry_codec::decodeSample(frame, length, 1, 5000, out));
+    TEST_ASSERT_EQUAL_UINT32(1000, out.bootMs);
+    TEST_ASSERT_EQUAL_FLOAT(19.5f, out.roomTempC);
+}
+
+// Telemetry policy sends on deadband crossings and keyframes, not every sample.
+void test_telemetry_policy_sends_changes_and_keyframes() {
+    TelemetryPolicy::Config config;
+    config.roomTempDeadbandC  = 0.2F;
+    config.keyframeIntervalMs = 60000U;
+    TelemetryPolicy policy(config);
+
+    TelemetrySample sample{};
+    sample.roomTempC   = 20.0F;
+    sample.targetTempC = 21.0F;
+    TEST_ASSERT_TRUE(policy.offer(sample, 0));  // first sample is a keyframe
+
+    sample.roomTempC = 20.1F;
+    TEST_ASSERT_FALSE(policy.offer(sample, 1000));
+    sample.roomTempC = 20.15F;
+    TEST_ASSERT_FALSE(policy.offer(sample, 2000));
+    sample.roomTempC = 20.25F;  // drift adds up past the deadband
+    TEST_ASSERT_TRUE(policy.offer(sample, 3000));
+
+    sample.powerOn = true;
+    TEST_ASSERT_TRUE(policy.offer(sample, 4000));
+    TEST_ASSERT_FALSE(policy.offer(sample, 5000));
+
+    TEST_ASSERT_TRUE(policy.evaluate(sample, 60000) == TelemetryPolicy::Decision::KEYFRAME);
+    TEST_ASSERT_TRUE(policy.offer(sample, 60000));
+    TEST_ASSERT_FALSE(policy.offer(sample, 61000));
+    policy.requestKeyframe();
+    TEST_ASSERT_TRUE(policy.offer(sample, 62000));
+
+    TEST_ASSERT_EQUAL_UINT32(9, policy.stats().evaluated);
+    TEST_ASSERT_EQUAL_UINT32(2, policy.stats().changes);
+    TEST_ASSERT_EQUAL_UINT32(3, policy.stats().keyframes);
+}
+
+// HubSocket that plays back what the test queues as the hub's reply.
+class ScriptedHubSocket : public HubSocket {
+public:
+    bool   connectOk = true;
+    bool   open      = false;
+    int    connects  = 0;
+    std::string sent;
+    std::string reply;
+
+    bool connected() override { return open; }
+    bool connect(const char*, uint16_t, uint32_t) override {
+        ++connects;
+        open = connectOk;
+        return open;
+    }
+    size_t write(const uint8_t* data, size_t length) override {
+        sent.append(reinterpret_cast<const char*>(data), length);
+        return length;
+    }
+    int available() override { return static_cast<int>(reply.size()); }
+    int read(uint8_t* out, size_t length) override {
+        const size_t n = length < reply.size() ? length : reply.size();
+        memcpy(out, reply.data(), n);
+        reply.erase(0, n);
+        return static_cast<int>(n);
+    }
+    void stop() override { open = false; }
+};
+
+// A held long-poll stays WAITING until the hub answers, keeps its socket, and flags X-Long-Poll.
+void test_hub_long_poll_detects_held_request() {
+    ScriptedHubSocket socket;
+    HubLongPoll poll(socket);
+    TEST_ASSERT_TRUE(poll.start("/api/command/pending?wait=25", 1000, 25000));
+    TEST_ASSERT_EQUAL_INT(1, socket.connects);
+    TEST_ASSERT_TRUE(socket.sent.find("GET /api/command/pending?wait=25 HTTP/1.1\r\n") == 0);
+    TEST_ASSERT_TRUE(socket.sent.find("Connection: keep-alive\r\n") != std::string::npos);
+
+    TEST_ASSERT_EQUAL(HubLongPoll::State::WAITING, poll.poll(2000));
+    socket.reply = "HTTP/1.1 200 OK\r\nX-Long-Poll: 25\r\ncontent-length: 2";
+    TEST_ASSERT_EQUAL(HubLongPoll::State::WAITING, poll.poll(20000));
+    socket.reply = "8\r\n\r\n{\"command\":\"TEMP_UP\",\"id\":7}";
+    TEST_ASSERT_EQUAL(HubLongPoll::State::DONE, poll.poll(21000));
+    TEST_ASSERT_EQUAL_INT(200, poll.status());
+    TEST_ASSERT_TRUE(poll.serverHeld());
+    TEST_ASSERT_EQUAL_UINT32(28, poll.bodyLength());
+    TEST_ASSERT_EQUAL_STRING("{\"command\":\"TEMP_UP\",\"id\":7}", poll.body());
+
+    // Kept alive: the next poll goes out on the same connection.
+    poll.reset();
+    TEST_ASSERT_EQUAL(HubLongPoll::State::IDLE, poll.state());
+    TEST_ASSERT_TRUE(poll.start("/api/command/pending?wait=25", 21000, 25000));
+    TEST_ASSERT_EQUAL_INT(1, socket.connects);
+    TEST_ASSERT_EQUAL(HubLongPoll::State::FAILED, poll.poll(21000 + 25000 + 5000));
+    TEST_ASSERT_FALSE(socket.open);
+}
+
+// What HubClient falls back to polling on: an immediate answer, an error status; plus transport failures.
+void test_hub_long_poll_reports_old_hubs_and_failures() {
+    ScriptedHubSocket socket;
+    HubLongPoll poll(socket);
+    TEST_ASSERT_TRUE(poll.start("/api/command/pending?wait=25", 0, 25000));
+    socket.reply = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n{}";
+    TEST_ASSERT_EQUAL(HubLongPoll::State::DONE, poll.poll(10));
+    TEST_ASSERT_FALSE(poll.serverHeld());
+    poll.reset();
+
+    TEST_ASSERT_TRUE(poll.start("/api/command/pending?wait=25", 0, 25000));
+    socket.reply = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    TEST_ASSERT_EQUAL(HubLongPoll::State::DONE, poll.poll(10));
+    TEST_ASSERT_EQUAL_INT(404, poll.status());
+    poll.close();
+    TEST_ASSERT_FALSE(socket.open);
+
+    // No Content-Length (chunked) is not supported.
+    TEST_ASSERT_TRUE(poll.start("/api/command/pending?wait=25", 0, 25000));
+    TEST_ASSERT_EQUAL_INT(2, socket.connects);
+    socket.reply = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+    TEST_ASSERT_EQUAL(HubLongPoll::State::FAILED, poll.poll(10));
+    poll.reset();
+
+    // The hub closes the connection while holding the request.
+    TEST_ASSERT_TRUE(poll.start("/api/command/pending?wait=25", 0, 25000));
+    socket.open = false;
+    TEST_ASSERT_EQUAL(HubLongPoll::State::FAILED, poll.poll(10));
+    poll.reset();
+
+    socket.connectOk = false;
+    TEST_ASSERT_FALSE(poll.start("/api/command/pending?wait=25", 0, 25000));
+    TEST_ASSERT_EQUAL(HubLongPoll::State::FAILED, poll.state());
+}
+
+// Request stats count reconnects and failures, and average latency over timed requests only.
+void test_request_stats_count_connects_failures_and_latency() {
+    RequestStats stats;
+    TEST_ASSERT_EQUAL_UINT32(0, stats.averageLatencyMs());
+
+    stats.begin(true);   // first request opens the connection
+    stats.end(200, 120);
+    stats.begin(false);  // kept alive
+    stats.end(304, 20);
+    stats.begin(false);
+    stats.end(500, 40);
+    stats.begin(true);   // transport error: timed, then reconnected
+    stats.end(-1, 300);
+    stats.begin(false);  // held long-poll that never went out
+    stats.fail();
+
+    TEST_ASSERT_EQUAL_UINT32(5, stats.requests);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.connects);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.timed);
+    TEST_ASSERT_EQUAL_UINT32(300, stats.lastLatencyMs);
+    TEST_ASSERT_EQUAL_UINT32(300, stats.maxLatencyMs);
+    TEST_ASSERT_EQUAL_UINT32(120, stats.averageLatencyMs());
+}
+
+// Circuit breaker opens after the threshold, backs off with jitter and closes on a good probe.
+void test_circuit_breaker_backs_off_and_probes() {
+    CircuitBreaker::Config config;
+    config.failureThreshold = 3;
+    config.baseBackoffMs    = 1000U;
+    config.maxBackoffMs     = 4000U;
+    CircuitBreaker breaker(config);
+    breaker.seed(42);
+
+    for (int i = 0; i < 2; ++i) {
+        TEST_ASSERT_TRUE(breaker.allowRequest(0));
+        breaker.recordFailure(0);
+    }
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::CLOSED);
+    breaker.recordFailure(0);
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::OPEN);
+    TEST_ASSERT_EQUAL_UINT32(1, breaker.trips());
+
+    // Each wait lies in [backoff / 2, backoff], and the backoff doubles up to the cap.
+    uint32_t now = 0;
+    const uint32_t expectedBackoff[] = {1000U, 2000U, 4000U, 4000U};
+    for (uint32_t backoff : expectedBackoff) {
+        const uint32_t wait = breaker.retryInMs(now);
+        TEST_ASSERT_TRUE(wait >= backoff / 2 && wait <= backoff);
+        TEST_ASSERT_FALSE(breaker.allowRequest(now + wait - 1));
+        now += wait;
+        TEST_ASSERT_TRUE(breaker.allowRequest(now));  // the one half-open probe
+        TEST_ASSERT_FALSE(breaker.allowRequest(now));
+        breaker.recordFailure(now);
+        TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::OPEN);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, breaker.trips());
+    TEST_ASSERT_EQUAL_UINT32(4, breaker.retries());
+
+    now += breaker.retryInMs(now);
+    TEST_ASSERT_TRUE(breaker.allowRequest(now));
+    breaker.recordSuccess();
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::CLOSED);
+    TEST_ASSERT_EQUAL_UINT32(0, breaker.outageRetries());
+
+    // Devices seeded differently do not retry in step.
+    CircuitBreaker a(config);
+    CircuitBreaker b(config);
+    a.seed(1);
+    b.seed(2);
+    for (int i = 0; i < 3; ++i) {
+        a.recordFailure(0);
+        b.recordFailure(0);
+    }
+    TEST_ASSERT_TRUE(a.retryInMs(0) != b.retryInMs(0));
+}
+
+// A probe handed back unsent (HubClient returning early after admit()) must not wedge the breaker.
+void test_circuit_breaker_cancelled_probe_probes_again() {
+    CircuitBreaker::Config config;
+    config.failureThreshold = 1;
+    CircuitBreaker breaker(config);
+    breaker.recordFailure(0);
+    const uint32_t due = breaker.retryInMs(0);
+
+    TEST_ASSERT_TRUE(breaker.allowRequest(due));
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::HALF_OPEN);
+    breaker.cancelProbe();
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::OPEN);
+    TEST_ASSERT_EQUAL_UINT32(0, breaker.retries());
+    TEST_ASSERT_EQUAL_UINT32(0, breaker.retryInMs(due));
+
+    TEST_ASSERT_TRUE(breaker.allowRequest(due + 1));
+    breaker.recordSuccess();
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::CLOSED);
+    breaker.cancelProbe();  // no probe out: a no-op
+    TEST_ASSERT_TRUE(breaker.state() == CircuitBreaker::State::CLOSED);
+    TEST_ASSERT_EQUAL_UINT32(1, breaker.retries());
+}
+
+// base64 matches RFC 4648 vectors, round-trips every tail length and rejects bad input.
+void test_base64_round_trips_and_rejects_bad_input() {
+    char text[16] = {0};
+    TEST_ASSERT_EQUAL_UINT32(8, base64::encode(reinterpret_cast<const uint8_t*>("foob"), 4, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("Zm9vYg==", text);
+    TEST_ASSERT_EQUAL_UINT32(8, base64::encode(reinterpret_cast<const uint8_t*>("fooba"), 5, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("Zm9vYmE=", text);
+    TEST_ASSERT_EQUAL_UINT32(0, base64::encode(reinterpret_cast<const uint8_t*>("foobar"), 6, text, 8));
+
+    uint8_t data[40];
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<uint8_t>(i * 37 + 250);
+    for (size_t len = 0; len <= sizeof(data); ++len) {
+        char encoded[64] = {0};
+        const size_t n = base64::encode(data, len, encoded, sizeof(encoded));
+        TEST_ASSERT_EQUAL_UINT32(base64::encodedSize(len), n);
+        uint8_t decoded[40] = {0};
+        size_t decodedLen = 0;
+        TEST_ASSERT_TRUE(base64::decode(encoded, n, decoded, sizeof(decoded), decodedLen));
+        TEST_ASSERT_EQUAL_UINT32(len, decodedLen);
+        if (len > 0) TEST_ASSERT_EQUAL_UINT8_ARRAY(data, decoded, len);
+    }
+
+    uint8_t out[8];
+    size_t outLen = 0;
+    TEST_ASSERT_FALSE(base64::decode("Zm9", 3, out, sizeof(out), outLen));        // length
+    TEST_ASSERT_FALSE(base64::decode("Zm9v:g==", 8, out, sizeof(out), outLen));   // alphabet
+    TEST_ASSERT_FALSE(base64::decode("Zg==Zm9v", 8, out, sizeof(out), outLen));   // inner padding
+    TEST_ASSERT_FALSE(base64::decode("Zm9vYmFy", 8, out, 5, outLen));             // output full
+}
+
+// Host MessageCrypto opens envelopes built by the hub's Python code and round-trips its own.
+void test_message_crypto_matches_hub_envelopes() {
+    // Python MessageCrypto("retrofit-test"), nonce 00..0f, ts 1700000000000.
+    const char* kV1 =
+        "1700000000000:000102030405060708090a0b0c0d0e0fa724995b895fa3ab37e0607a732e259e"
+        "315febf9b6a4c62e65088f77b693fcde:"
+        "7066780401ab1e5a14072c2e75f7375e5076644f0ff9869622a82037b3fbddd5";
+    const char* kV2 =
+        "AnhWNBIAAQIDBAUGBwgJCgsMDQ4PpySZW4lfo6s34GB6cy4lnjFf6/m2pMYuZQiPd7aT/N6NzADl/E2sCy3p"
+        "AotukOEpUaactaWAx0Bqb1iFPI8Eyg==";
+    // Same plaintext as v3: AES-GCM via OpenSSL, iv 00..0b, ts 0x12345678.
+    const char* kV3 =
+        "A3hWNBIAAQIDBAUGBwgJCgu36G0wh4kezag/Jj+2ftsXe//EZ9DIbKcksf0Zc7o5xUP6EP0pQxd7KMWp0hb+"
+        "GSA=";
+    const char* kPlain = "{\"command\":\"on_off\",\"sync\":true}";
+
+    MessageCrypto crypto("retrofit-test");
+    uint8_t plain[256];
+    size_t plainLen = 0;
+    TEST_ASSERT_TRUE(crypto.decryptEnvelope(kV1, strlen(kV1), plain, sizeof(plain), plainLen));
+    TEST_ASSERT_EQUAL_UINT32(strlen(kPlain), plainLen);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(kPlain, plain, plainLen);
+    TEST_ASSERT_TRUE(crypto.decryptEnvelope(kV2, strlen(kV2), plain, sizeof(plain), plainLen));
+    TEST_ASSERT_EQUAL_UINT32(strlen(kPlain), plainLen);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(kPlain, plain, plainLen);
+    TEST_ASSERT_TRUE(crypto.decryptEnvelope(kV3, strlen(kV3), plain, sizeof(plain), plainLen));
+    TEST_ASSERT_EQUAL_UINT32(strlen(kPlain), plainLen);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(kPlain, plain, plainLen);
+
+    char v1[MessageCrypto::v1EnvelopeSize(40) + 1];
+    const size_t v1Len = crypto.encryptEnvelope(reinterpret_cast<const uint8_t*>(kPlain),
+                                                strlen(kPlain), v1, sizeof(v1));
+    TEST_ASSERT_TRUE(v1Len > 0);
+    TEST_ASSERT_TRUE(crypto.decryptEnvelope(v1, v1Len, plain, sizeof(plain), plainLen));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(kPlain, plain, plainLen);
+
+    uint8_t v2[64 + MessageCrypto::kV2Overhead];
+    const size_t v2Len = crypto.sealV2(reinterpret_cast<const uint8_t*>(kPlain), strlen(kPlain),
+                                       v2, sizeof(v2));
+    TEST_ASSERT_EQUAL_UINT32(strlen(kPlain) + MessageCrypto::kV2Overhead, v2Len);
+    v2[MessageCrypto::kV2PayloadOffset] ^= 0x01;
+    TEST_ASSERT_FALSE(crypto.openV2(v2, v2Len, plain, sizeof(plain), plainLen));
+    v2[MessageCrypto::kV2PayloadOffset] ^= 0x01;
+    TEST_ASSERT_TRUE(crypto.openV2(v2, v2Len, plain, sizeof(plain), plainLen));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(kPlain, plain, plainLen);
+
+    uint8_t v3[64 + MessageCrypto::kV3Overhead];
+    const size_t v3Len = crypto.sealV3(reinterpret_cast<const uint8_t*>(kPlain), strlen(kPlain),
+                                       v3, sizeof(v3));
+    TEST_ASSERT_EQUAL_UINT32(strlen(kPlain) + MessageCrypto::kV3Overhead, v3Len);
+    v3[1] ^= 0x01;  // ts is authenticated too
+    TEST_ASSERT_FALSE(crypto.openV3(v3, v3Len, plain, sizeof(plain), plainLen));
+    v3[1] ^= 0x01;
+    TEST_ASSERT_TRUE(crypto.openV3(v3, v3Len, plain, sizeof(plain), plainLen));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(kPlain, plain, plainLen);
+
+    MessageCrypto wrongKey("not-the-password");
+    TEST_ASSERT_FALSE(wrongKey.decryptEnvelope(kV1, strlen(kV1), plain, sizeof(plain), plainLen));
+    TEST_ASSERT_FALSE(wrongKey.decryptEnvelope(kV3, strlen(kV3), plain, sizeof(plain), plainLen));
+}
+
+// Portable AES-GCM reproduces GCM spec test case 4 (AES-128, 60-byte payload, 20-byte AAD).
+void test_aes_gcm_matches_spec_vector() {
+    const uint8_t key[16] = {0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+                             0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08};
+    const uint8_t iv[12]  = {0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88};
+    const uint8_t aad[20] = {0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed,
+                             0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2};
+    const uint8_t plain[60] = {
+        0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26,
+        0x9a, 0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31,
+        0x8a, 0x72, 0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49,
+        0xa6, 0xb5, 0x25, 0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39};
+    const uint8_t cipher[60] = {
+        0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4,
+        0x9c, 0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac,
+        0xa1, 0x2e, 0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac,
+        0x84, 0xaa, 0x05, 0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91};
+    const uint8_t tag[16] = {0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb,
+                             0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47};
+
+    AesGcm128 gcm;
+    gcm.setKey(key);
+    uint8_t out[60];
+    uint8_t outTag[16];
+    gcm.seal(iv, aad, sizeof(aad), plain, out, sizeof(plain), outTag);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(cipher, out, sizeof(cipher));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(tag, outTag, sizeof(tag));
+
+    TEST_ASSERT_TRUE(gcm.open(iv, aad, sizeof(aad), out, out, sizeof(out), tag));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(plain, out, sizeof(plain));
+    outTag[15] ^= 0x80;
+    TEST_ASSERT_FALSE(gcm.open(iv, aad, sizeof(aad), cipher, out, sizeof(cipher), outTag));
+}
+
+// SPSC queue holds Capacity - 1 items and keeps FIFO order across wrap-around.
+void test_spsc_queue_is_bounded_fifo() {
+    SpscQueue<int, 4> queue;
+    TEST_ASSERT_TRUE(queue.empty());
+    for (int round = 0; round < 3; ++round) {
+        TEST_ASSERT_TRUE(queue.push(round * 10 + 1));
+        TEST_ASSERT_TRUE(queue.push(round * 10 + 2));
+        TEST_ASSERT_TRUE(queue.push(round * 10 + 3));
+        TEST_ASSERT_FALSE(queue.push(99));
+        TEST_ASSERT_EQUAL_UINT32(3, queue.size());
+
+        int out = 0;
+        for (int i = 1; i <= 3; ++i) {
+            TEST_ASSERT_TRUE(queue.pop(out));
+            TEST_ASSERT_EQUAL_INT(round * 10 + i, out);
+        }
+        TEST_ASSERT_FALSE(queue.pop(out));
+    }
+}
+
+// HubLink carries telemetry out and commands/config in without loop() touching the network.
+void test_hub_link_round_trip_through_loopback_endpoint() {
+    HubReceiver receiver;
+    Logger logger;
+    HubLink link(receiver, logger);
+    HubLoopbackEndpoint endpoint(link);
+    WallClockSnapshot wall{};
+
+    link.tick(wall, true);
+    HubLink::Telemetry telemetry;
+    telemetry.roomTempC = 20.0f;
+    link.submitTelemetry(telemetry, wall);
+    link.submitTelemetry(telemetry, wall);  // unchanged: held back by the policy
+    TEST_ASSERT_TRUE(endpoint.queueCommand(Command::TEMP_UP));
+    endpoint.service(0);
+    TEST_ASSERT_EQUAL_UINT32(1, endpoint.samplesReceived());
+    TEST_ASSERT_TRUE(link.hubReachable());
+
+    Command cmd = Command::NONE;
+    TEST_ASSERT_FALSE(receiver.poll(cmd));  // applied on loop()'s next tick
+    link.tick(wall, true);
+    TEST_ASSERT_TRUE(receiver.poll(cmd));
+    TEST_ASSERT_EQUAL(Command::TEMP_UP, cmd);
+    TEST_ASSERT_EQUAL(LogEventType::HUB_COMMAND_RX, logger.entries()[0].type);
+
+    HubEvent event;
+    event.kind        = HubEvent::Kind::AUTO_CONTROL;
+    event.autoControl = true;
+    TEST_ASSERT_TRUE(link.postEvent(event));
+    TEST_ASSERT_FALSE(link.autoControl());
+    link.tick(wall, true);
+    TEST_ASSERT_TRUE(link.autoControl());
+
+    // A stalled worker defers telemetry instead of blocking loop().
+    for (int i = 0; i < 20; ++i) {
+        telemetry.roomTempC += 1.0f;
+        link.submitTelemetry(telemetry, wall);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, link.stats().workerStalls);
+}
+
+// Hub responses parse in one pass; zero values are present, not missing.
+void test_hub_response_parser_keeps_zero_values_and_commands() {
+    const char json[] =
+        "{\"status\": \"ok\", \"extra\": {\"a\": [1, \"]\"]}, \"auto_control\": false, "
+        "\"scheduled_target\": 0.0, \"commands\": [{\"command\": null}, "
+        "{\"command\": \"send_ir\", \"protocol\": 8, \"address\": 0, \"ir_command\": 22, "
+        "\"name\": \"Fan \\u00e9\"}]}";
+    HubResponseMessage message;
+    TEST_ASSERT_TRUE(parseHubResponse(json, sizeof(json) - 1, message));
+    TEST_ASSERT_TRUE(message.hasAutoControl);
+    TEST_ASSERT_FALSE(message.autoControl);
+    TEST_ASSERT_TRUE(message.hasScheduledTarget);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, message.scheduledTarget);
+    TEST_ASSERT_FALSE(message.hasPidMode);
+    TEST_ASSERT_EQUAL_UINT8(2, message.commandCount);
+    TEST_ASSERT_FALSE(message.commands[0].hasCommand);
+    TEST_ASSERT_EQUAL_STRING("send_ir", message.commands[1].command);
+    TEST_ASSERT_TRUE(message.commands[1].hasIr);
+    TEST_ASSERT_EQUAL_INT32(0, message.commands[1].address);
+    TEST_ASSERT_EQUAL_STRING("Fan \xc3\xa9", message.commands[1].name);
+
+    const char truncated[] = "{\"auto_control\": true, \"commands\": [{\"command\": \"on";
+    TEST_ASSERT_FALSE(parseHubResponse(truncated, sizeof(truncated) - 1, message));
+}
+
 // Native host build has no Arduino hardware, so TX must report HW_UNAVAILABLE.
 void test_ir_sender_reports_hardware_unavailable_in_native() {
     IRSender sender;
@@ -487,7 +1582,7 @@ void test_hub_has_priority_over_scheduler_when_both_ready() {
     ThermoDeviceController controller(sender, receiver, hub, scheduler, logger);
     controller.begin(true);
 
-    TEST_ASSERT_TRUE(scheduler.addEntry(500, Command::OFF));
+    TEST_ASSERT_TRUE(scheduler.addEntry(0, 500, Command::OFF));
     TEST_ASSERT_TRUE(hub.pushMockCommand(Command::ON));
 
     WallClockSnapshot wall = hostLocalWithSecondOffset(500, 500000, 3);
@@ -676,7 +1771,44 @@ int main(int, char**) {
     RUN_TEST(test_scheduler_relative_due);
     RUN_TEST(test_scheduler_daily_once_per_day);
     RUN_TEST(test_scheduler_next_planned_command);
+    RUN_TEST(test_scheduler_fires_in_time_order_at_capacity);
+    RUN_TEST(test_timer_wheel_orders_cancels_and_repeats);
+    RUN_TEST(test_scheduler_relative_entries_survive_millis_wrap);
+    RUN_TEST(test_scheduler_relative_entries_after_long_disable);
+    RUN_TEST(test_scheduler_daily_index_follows_clock_jumps);
     RUN_TEST(test_logger_detail_code_is_recorded);
+    RUN_TEST(test_logger_copy_since_returns_new_entries_in_order);
+    RUN_TEST(test_packed_log_entry_round_trips_wall_time);
+    RUN_TEST(test_event_logger_capacity_is_compile_time);
+    RUN_TEST(test_log_drain_queues_and_counts_drops);
+    RUN_TEST(test_diag_tokenized_frame_encoding);
+#if LOG_STORAGE_HAS_NVS
+    RUN_TEST(test_nvs_log_storage_restores_newest_segments);
+#endif
+#if LOG_STORAGE_HAS_MMAP
+    RUN_TEST(test_mapped_file_log_storage_restores_ring);
+#endif
+    RUN_TEST(test_telemetry_ring_drops_oldest_and_drains_in_order);
+#if TELEMETRY_RING_HAS_PREFERENCES
+    RUN_TEST(test_telemetry_ring_drops_undated_samples_from_an_earlier_boot);
+#endif
+    RUN_TEST(test_weekly_plan_fires_once_per_week_and_skips_missed_commands);
+    RUN_TEST(test_schedule_codec_loads_weekly_plan);
+    RUN_TEST(test_schedule_store_round_trips_frame_and_etag);
+    RUN_TEST(test_schedule_sync_keeps_cached_plan_until_a_new_one_arrives);
+    RUN_TEST(test_telemetry_codec_round_trips_samples);
+    RUN_TEST(test_telemetry_policy_sends_changes_and_keyframes);
+    RUN_TEST(test_hub_long_poll_detects_held_request);
+    RUN_TEST(test_hub_long_poll_reports_old_hubs_and_failures);
+    RUN_TEST(test_request_stats_count_connects_failures_and_latency);
+    RUN_TEST(test_circuit_breaker_backs_off_and_probes);
+    RUN_TEST(test_circuit_breaker_cancelled_probe_probes_again);
+    RUN_TEST(test_base64_round_trips_and_rejects_bad_input);
+    RUN_TEST(test_message_crypto_matches_hub_envelopes);
+    RUN_TEST(test_aes_gcm_matches_spec_vector);
+    RUN_TEST(test_spsc_queue_is_bounded_fifo);
+    RUN_TEST(test_hub_link_round_trip_through_loopback_endpoint);
+    RUN_TEST(test_hub_response_parser_keeps_zero_values_and_commands);
     RUN_TEST(test_ir_sender_reports_hardware_unavailable_in_native);
     RUN_TEST(test_hub_mock_scheduler_pushes_expected_commands);
     RUN_TEST(test_hub_mock_scheduler_can_be_disabled);
@@ -9,6 +9,7 @@ Install:
 
 import json
 import csv
+import asyncio
 import time
 import secrets
 import sqlite3
@@ -16,9 +17,11 @@ import logging
 import hashlib
 import hmac as hmac_lib
 import os
+import base64
+import struct
 from datetime import datetime, timedelta
 from pathlib import Path
-from typing import Optional
+from typing import List, Optional
 from collections import defaultdict
 
 import numpy as np
@@ -27,25 +30,40 @@ from fastapi import FastAPI, HTTPException, Request, Form
 from fastapi.middleware.cors import CORSMiddleware
 from starlette.middleware.sessions import SessionMiddleware
 from fastapi.staticfiles import StaticFiles
-from fastapi.responses import FileResponse, HTMLResponse, RedirectResponse
+from fastapi.responses import FileResponse, HTMLResponse, RedirectResponse, JSONResponse, PlainTextResponse, Response
 from pydantic import BaseModel
 
 # ── CRYPTO ────────────────────────────────────────────────────
 # Mirrors MessageCrypto in crypto/message_crypto.h/.cpp
 # Requires: pip install cryptography
+# Envelope versions the hub reads; devices switch to the highest one they
+# support in X-Envelope-Versions and send it as X-Encrypted.
+ENVELOPE_V2       = 2
+ENVELOPE_V3       = 3
+ENVELOPE_VERSIONS = "1,2,3"
+_V2_HEADER   = struct.Struct("<BI")   # version, sender clock ms (v3 too)
+_V2_OVERHEAD = _V2_HEADER.size + 16 + 32
+_V3_OVERHEAD = _V2_HEADER.size + 12 + 16
+
 class MessageCrypto:
     """AES-128-CTR + HMAC-SHA256 authenticated encryption.
 
-    Envelope format: "<ts>:<hex(nonce16||ciphertext)>:<hex(hmac32)>"
+    Envelope v1: "<ts>:<hex(nonce16||ciphertext)>:<hex(hmac32)>"
+    Envelope v2: [0x02][ts u32 LE][nonce16][ciphertext][hmac32], HMAC over
+      everything before it. Raw bytes in request bodies, base64 in responses.
+    Envelope v3: [0x03][ts u32 LE][iv12][ciphertext][tag16], AES-128-GCM with
+      the first 5 bytes as associated data. Same transport as v2.
     Keys derived from device password via SHA-256:
       aes_key  = sha256(password)[0:16]
       hmac_key = sha256(password)[0:32]
+      aead_key = hmac(hmac_key, "v3-aead")[0:16]
     """
 
     def __init__(self, password: str):
         h = hashlib.sha256(password.encode()).digest()
         self._aes_key  = h[:16]
         self._hmac_key = h
+        self._aead_key = hmac_lib.new(h, b"v3-aead", hashlib.sha256).digest()[:16]
 
     def _aes_ctr(self, nonce16: bytes, data: bytes) -> bytes:
         from cryptography.hazmat.primitives.ciphers import Cipher, algorithms, modes
@@ -55,15 +73,20 @@ class MessageCrypto:
         enc = cipher.encryptor()
         return enc.update(data) + enc.finalize()
 
-    def encrypt_envelope(self, plaintext: str) -> str:
+    def encrypt_envelope(self, plaintext: str | bytes) -> str:
         nonce = os.urandom(16)
-        ciphertext = self._aes_ctr(nonce, plaintext.encode())
+        data = plaintext.encode() if isinstance(plaintext, str) else plaintext
+        ciphertext = self._aes_ctr(nonce, data)
         ts  = str(int(time.time() * 1000))
         enc = (nonce + ciphertext).hex()
         mac = hmac_lib.new(self._hmac_key, f"{ts}:{enc}".encode(), hashlib.sha256).hexdigest()
         return f"{ts}:{enc}:{mac}"
 
     def decrypt_envelope(self, envelope: str) -> str | None:
+        plaintext = self.decrypt_envelope_bytes(envelope)
+        return plaintext.decode() if plaintext is not None else None
+
+    def decrypt_envelope_bytes(self, envelope: str) -> bytes | None:
         parts = envelope.split(":", 2)
         if len(parts) != 3:
             return None
@@ -76,8 +99,41 @@ class MessageCrypto:
         raw = bytes.fromhex(enc)
         if len(raw) < 16:
             return None
-        plaintext = self._aes_ctr(raw[:16], raw[16:])
-        return plaintext.decode()
+        return self._aes_ctr(raw[:16], raw[16:])
+
+    def seal_v2(self, plaintext: bytes) -> bytes:
+        nonce = os.urandom(16)
+        head = _V2_HEADER.pack(ENVELOPE_V2, int(time.time() * 1000) & 0xFFFFFFFF) + nonce
+        body = head + self._aes_ctr(nonce, plaintext)
+        return body + hmac_lib.new(self._hmac_key, body, hashlib.sha256).digest()
+
+    def open_v2(self, envelope: bytes) -> bytes | None:
+        if len(envelope) < _V2_OVERHEAD or envelope[0] != ENVELOPE_V2:
+            return None
+        body, sig = envelope[:-32], envelope[-32:]
+        expected = hmac_lib.new(self._hmac_key, body, hashlib.sha256).digest()
+        if not hmac_lib.compare_digest(expected, sig):
+            return None
+        return self._aes_ctr(body[5:21], body[21:])
+
+    def seal_v3(self, plaintext: bytes) -> bytes:
+        from cryptography.hazmat.primitives.ciphers.aead import AESGCM
+        iv = os.urandom(12)
+        head = _V2_HEADER.pack(ENVELOPE_V3, int(time.time() * 1000) & 0xFFFFFFFF)
+        return head + iv + AESGCM(self._aead_key).encrypt(iv, plaintext, head)
+
+    def open_v3(self, envelope: bytes) -> bytes | None:
+        from cryptography.exceptions import InvalidTag
+        from cryptography.hazmat.primitives.ciphers.aead import AESGCM
+        if len(envelope) < _V3_OVERHEAD or envelope[0] != ENVELOPE_V3:
+            return None
+        try:
+            return AESGCM(self._aead_key).decrypt(envelope[5:17], envelope[17:], envelope[:5])
+        except InvalidTag:
+            return None
+
+    def seal_binary(self, version: int, plaintext: bytes) -> bytes:
+        return self.seal_v3(plaintext) if version == ENVELOPE_V3 else self.seal_v2(plaintext)
 
 
 # ── CONFIG ────────────────────────────────────────────────────
@@ -271,6 +327,19 @@ def init_db():
             value TEXT
         );
 
+        CREATE TABLE IF NOT EXISTS device_log (
+            id        INTEGER PRIMARY KEY AUTOINCREMENT,
+            ts        TEXT    NOT NULL,
+            device_id TEXT,
+            seq       INTEGER,
+            type      INTEGER,
+            command   INTEGER,
+            success   INTEGER,
+            detail    INTEGER,
+            unix_ms   INTEGER,
+            boot_ms   INTEGER
+        );
+
         CREATE TABLE IF NOT EXISTS custom_buttons (
             id          INTEGER PRIMARY KEY AUTOINCREMENT,
             name        TEXT NOT NULL UNIQUE,
@@ -294,6 +363,18 @@ class TelemetryIn(BaseModel):
     pid_steps:   Optional[int]   = None
     integral:    Optional[float] = None
 
+class TelemetrySampleIn(TelemetryIn):
+    ts:     Optional[int] = None   # unix ms when the device had wall time
+    age_ms: Optional[int] = None   # otherwise: how long ago it was taken
+
+class TelemetryBatchIn(BaseModel):
+    samples: List[TelemetrySampleIn] = []
+
+class SyncIn(BaseModel):
+    telemetry: Optional[TelemetryIn] = None
+    # [seq, type, command, success, detail, unix_ms, boot_ms] — see logger.h
+    logs:      List[List[int]] = []
+
 class CommandIn(BaseModel):
     command: str   # 'on' | 'off' | 'temp_up' | 'temp_down'
     ir_only: bool = False  # if True, don't update target temp
@@ -341,6 +422,7 @@ device_state = {
     "pid":          {"p": 0, "i": 0, "d": 0, "steps": 0},
     "last_seen":    None,
     "auto_control": False,
+    "hub_link":     None,   # device circuit breakers, from X-Hub-Link
 }
 # Set to True when the user explicitly disables PID via the dashboard.
 # Prevents the schedule from re-enabling it until the user turns it on again.
@@ -381,6 +463,47 @@ last_manual_slot_key: str = ""            # which slot was active at that moment
 # Each unique slot+command only fires once until the slot changes.
 last_schedule_cmd_key: str = ""
 
+# ── COMMAND PUSH (long-poll) ─────────────────────────────────
+# Devices may hold GET /api/command/pending?wait=N open; it completes as soon as
+# a command is queued. Commands are inserted from sync handlers running in the
+# threadpool, so waking the waiters goes through call_soon_threadsafe.
+LONG_POLL_MAX_WAIT_S = 30
+_command_loop: Optional[asyncio.AbstractEventLoop] = None
+_command_event: Optional[asyncio.Event] = None
+
+def _current_command_event() -> asyncio.Event:
+    global _command_loop, _command_event
+    if _command_event is None:
+        _command_loop  = asyncio.get_running_loop()
+        _command_event = asyncio.Event()
+    return _command_event
+
+def _wake_command_waiters():
+    global _command_event
+    if _command_event is not None:
+        _command_event.set()
+        _command_event = asyncio.Event()
+
+def notify_command_queued():
+    """Complete any outstanding long-polls. Safe to call from any thread."""
+    if _command_loop is not None:
+        _command_loop.call_soon_threadsafe(_wake_command_waiters)
+
+# Devices only send telemetry on change or keyframe, and config rides on the
+# telemetry response. A dashboard config change therefore sets this flag; the
+# next command poll carries "sync": true and the device sends a sample at once.
+_device_sync_requested = False
+
+def request_device_sync():
+    global _device_sync_requested
+    _device_sync_requested = True
+    notify_command_queued()
+
+def take_device_sync_request() -> bool:
+    global _device_sync_requested
+    requested, _device_sync_requested = _device_sync_requested, False
+    return requested
+
 # ─────────────────────────────────────────────────────────────
 #  ROUTES
 # ─────────────────────────────────────────────────────────────
@@ -451,13 +574,153 @@ def require_auth(device_id: str, request: Request):
         return device_id   # Browser auth via session
     raise HTTPException(401, "Unauthorized")
 
-# ── ESP32: POST telemetry ──────────────────────────────────────
-@app.post("/api/telemetry")
-async def post_telemetry(request: Request):
-    global last_schedule_cmd_key
-    device_id  = request.headers.get("X-Device-ID", "").upper()
-    encrypted  = request.headers.get("Content-Type", "") == "application/x-encrypted"
-    device_pwd = None
+# ── ESP32: binary telemetry ("bin1") ─────────────────────────
+# Mirrors hub/telemetry_codec.h. Devices switch to it once they see
+# "bin1" in X-Telemetry-Formats and mark such bodies X-Telemetry-Format: bin1.
+TELEMETRY_BIN_FORMAT = "bin1"
+TELEMETRY_FORMATS    = "json," + TELEMETRY_BIN_FORMAT
+_BIN_HEADER = struct.Struct("<BBB")         # version, sample count, log count
+_BIN_SAMPLE = struct.Struct("<B6shhhhhhb")  # 20 bytes
+_BIN_LOG    = struct.Struct("<IBBBB6sI")    # 18 bytes
+
+def decode_telemetry_frame(frame: bytes):
+    """Return (samples, logs) with logs in the /api/sync JSON list layout."""
+    version, n_samples, n_logs = _BIN_HEADER.unpack_from(frame, 0)
+    if version != 1:
+        raise ValueError(f"unsupported telemetry frame version {version}")
+    if len(frame) < _BIN_HEADER.size + n_samples * _BIN_SAMPLE.size + n_logs * _BIN_LOG.size:
+        raise ValueError("truncated telemetry frame")
+
+    samples, logs = [], []
+    offset = _BIN_HEADER.size
+    for _ in range(n_samples):
+        flags, t, room, target, p, i, d, integral, steps = _BIN_SAMPLE.unpack_from(frame, offset)
+        offset += _BIN_SAMPLE.size
+        t = int.from_bytes(t, "little")
+        samples.append(TelemetrySampleIn(
+            ts          = t if flags & 0x04 else None,
+            age_ms      = None if flags & 0x04 else t,
+            room_temp   = None if flags & 0x08 else room / 100,
+            target_temp = None if flags & 0x10 else target / 100,
+            power       = bool(flags & 0x01),
+            mode        = "ECO" if flags & 0x02 else "FAST",
+            pid_p = p / 100, pid_i = i / 1000, pid_d = d / 100,
+            pid_steps = steps, integral = integral / 1000,
+        ))
+    for _ in range(n_logs):
+        seq, ev_type, command, flags, detail, unix_ms, boot_ms = _BIN_LOG.unpack_from(frame, offset)
+        offset += _BIN_LOG.size
+        logs.append([seq, ev_type, command, flags & 0x01, detail,
+                     int.from_bytes(unix_ms, "little"), boot_ms])
+    return samples, logs
+
+# ── ESP32: binary schedule ("sch2") ──────────────────────────
+# Mirrors hub/schedule_codec.h. Devices fetch GET /api/schedule?format=sch2,
+# run the plan on their own WeeklyPlan and mark uploads X-Local-Schedule: sch2,
+# which stops apply_telemetry() from evaluating it for them. Every row is one
+# 4-byte entry keyed by minute of the week (Sunday 00:00 = 0), sorted.
+SCHEDULE_BIN_FORMAT      = "sch2"
+SCHEDULE_BIN_MAX_ENTRIES = 0xFFFF
+_SCH_HEADER   = struct.Struct("<BH")  # version, entry count
+_SCH_ENTRY    = struct.Struct("<HH")  # minute of week, payload
+_SCH_SETPOINT = 0x8000                # payload flag; low 15 bits are 0.01 °C
+_SCH_WEEKDAYS = {"Sun": 0, "Mon": 1, "Tue": 2, "Wed": 3, "Thu": 4, "Fri": 5, "Sat": 6}
+# Command codes from commands.h; "on"/"off" are the ON_OFF toggle, as when queued.
+_SCH_COMMANDS = {"on": 0x01, "off": 0x01, "on_off": 0x01, "temp_up": 0x02, "temp_down": 0x03}
+
+# Compiled from the schedule table at startup and on every save. The ETag
+# hashes the frame, so devices holding it get a 304 (If-None-Match).
+schedule_cache = {"frame": _SCH_HEADER.pack(2, 0), "hub_only": False, "etag": '"0"'}
+
+def compile_schedule(rows) -> tuple[bytes, bool]:
+    """
+    Return (sch2 frame, hub_only). hub_only is set when some rows cannot run
+    on the device (custom IR buttons), so the hub must keep evaluating them.
+    """
+    entries, hub_only = set(), False
+    for row in rows:
+        day = _SCH_WEEKDAYS.get(row["day"])
+        try:
+            hour, minute = (int(x) for x in row["time"].split(":")[:2])
+        except (AttributeError, ValueError):
+            continue
+        if day is None or not (0 <= hour < 24 and 0 <= minute < 60):
+            continue
+        minute_of_week = day * 1440 + hour * 60 + minute
+        if row["type"] == "command":
+            code = _SCH_COMMANDS.get(row["command"] or "")
+            if code is None:
+                hub_only = True
+                continue
+            entries.add((minute_of_week, code))
+        elif row["temp"]:
+            centi = round(float(row["temp"]) * 100)
+            if 0 < centi < _SCH_SETPOINT:
+                entries.add((minute_of_week, _SCH_SETPOINT | centi))
+
+    entries = sorted(entries)
+    if len(entries) > SCHEDULE_BIN_MAX_ENTRIES:
+        log.warning("Schedule has %d entries, sending the first %d to devices",
+                    len(entries), SCHEDULE_BIN_MAX_ENTRIES)
+        entries = entries[:SCHEDULE_BIN_MAX_ENTRIES]
+    frame = bytearray(_SCH_HEADER.pack(2, len(entries)))
+    for minute_of_week, payload in entries:
+        frame += _SCH_ENTRY.pack(minute_of_week, payload)
+    return bytes(frame), hub_only
+
+def refresh_schedule_cache():
+    with get_db() as conn:
+        rows = conn.execute("SELECT day, time, type, temp, command FROM schedule").fetchall()
+    frame, hub_only = compile_schedule(rows)
+    schedule_cache.update(frame=frame, hub_only=hub_only,
+                          etag='"%s"' % hashlib.sha256(frame).hexdigest()[:16])
+
+# ── ESP32: link health ────────────────────────────────────────
+# Devices report their per-endpoint circuit breakers on every upload:
+#   X-Hub-Link: cmd=closed,1,4;tel=closed,2,6   (endpoint=state,trips,retries)
+# trips = times the breaker opened since boot, retries = probes sent.
+HUB_LINK_ENDPOINTS = {"cmd": "command", "tel": "telemetry"}
+
+def note_hub_link(device_id: str, header: str):
+    link = {}
+    for part in header.split(";"):
+        name, _, value = part.partition("=")
+        fields = value.split(",")
+        if name not in HUB_LINK_ENDPOINTS or len(fields) != 3:
+            continue
+        try:
+            link[HUB_LINK_ENDPOINTS[name]] = {
+                "state": fields[0], "trips": int(fields[1]), "retries": int(fields[2]),
+            }
+        except ValueError:
+            continue
+    if not link:
+        return
+    previous = device_state["hub_link"] or {}
+    for endpoint, health in link.items():
+        if health["trips"] > previous.get(endpoint, {}).get("trips", 0):
+            log.warning("%s lost the hub on %s: %d outage(s), %d retries since boot",
+                        device_id or "Device", endpoint, health["trips"], health["retries"])
+    device_state["hub_link"] = link
+
+# ── ESP32: shared request/response plumbing ───────────────────
+async def read_device_body(request: Request):
+    """
+    Authenticate an ESP32 POST and return (device_pwd, payload, envelope).
+    payload is the JSON text, or the decoded bytes for a bin1 body. envelope
+    is the envelope version the body came in (0: not encrypted) and the one
+    device_response() answers with. Encrypted bodies that fail to decrypt fall
+    back to the raw body; an unreadable v2/v3 body is a 400.
+    """
+    device_id    = request.headers.get("X-Device-ID", "").upper()
+    content_type = request.headers.get("Content-Type", "")
+    binary       = request.headers.get("X-Telemetry-Format", "") == TELEMETRY_BIN_FORMAT
+    x_encrypted  = request.headers.get("X-Encrypted", "")
+    binary_env   = (int(x_encrypted) if x_encrypted in (str(ENVELOPE_V2), str(ENVELOPE_V3))
+                    else 0)
+    encrypted    = content_type == "application/x-encrypted" or (
+                   binary_env and content_type == "application/octet-stream")
+    device_pwd   = None
 
     if device_id and device_id in DEVICES:
         device_pwd = DEVICES[device_id]["password"]
@@ -465,24 +728,62 @@ async def post_telemetry(request: Request):
         if auth_header != device_pwd:
             raise HTTPException(401, "Unauthorized")
 
-    raw_body = await request.body()
-    raw_str = raw_body.decode()
-    json_str = raw_str  # default: treat as plain JSON
+    link_header = request.headers.get("X-Hub-Link", "")
+    if link_header:
+        note_hub_link(device_id, link_header)
 
-    crypto_active = False
+    raw_body = await request.body()
+    if encrypted and device_pwd and binary_env:
+        # Raw bytes as application/octet-stream, base64 otherwise.
+        try:
+            envelope = (raw_body if content_type == "application/octet-stream"
+                        else base64.b64decode(raw_body, validate=True))
+        except ValueError:
+            envelope = b""
+        crypto = MessageCrypto(device_pwd)
+        decrypted = (crypto.open_v3(envelope) if binary_env == ENVELOPE_V3
+                     else crypto.open_v2(envelope))
+        if decrypted is None:
+            log.warning("v%d envelope from %s failed to verify", binary_env, device_id)
+            raise HTTPException(400, "Bad envelope")
+        return device_pwd, decrypted if binary else decrypted.decode(), binary_env
+
+    payload = raw_body if binary else raw_body.decode()  # default: not encrypted
+    envelope_version = 0
     if encrypted and device_pwd:
-        decrypted = MessageCrypto(device_pwd).decrypt_envelope(raw_str)
+        crypto = MessageCrypto(device_pwd)
+        envelope = raw_body.decode()
+        decrypted = (crypto.decrypt_envelope_bytes(envelope) if binary
+                     else crypto.decrypt_envelope(envelope))
         if decrypted is not None:
-            json_str = decrypted
-            crypto_active = True
+            payload = decrypted
+            envelope_version = 1
         else:
-            log.warning("Telemetry decryption failed for %s — falling back to plain JSON", device_id)
-
-    try:
-        data = TelemetryIn(**json.loads(json_str))
-    except Exception as e:
-        log.error("Failed to parse telemetry body: %s | raw: %.80s", e, raw_str)
-        raise HTTPException(400, "Bad telemetry body")
+            log.warning("Decryption failed for %s — falling back to raw body", device_id)
+    return device_pwd, payload, envelope_version
+
+def device_response(payload: dict, device_pwd: Optional[str], envelope: int,
+                    headers: Optional[dict] = None):
+    headers = {**(headers or {}),
+               "X-Telemetry-Formats": TELEMETRY_FORMATS,
+               "X-Envelope-Versions": ENVELOPE_VERSIONS}
+    if envelope and device_pwd:
+        crypto = MessageCrypto(device_pwd)
+        plain = json.dumps(payload)
+        body = (base64.b64encode(crypto.seal_binary(envelope, plain.encode())).decode()
+                if envelope in (ENVELOPE_V2, ENVELOPE_V3)
+                else crypto.encrypt_envelope(plain))
+        return PlainTextResponse(body, media_type="application/x-encrypted", headers=headers)
+    return JSONResponse(payload, headers=headers)
+
+def apply_telemetry(data: TelemetryIn, local_schedule: bool = False) -> dict:
+    """
+    Record one telemetry sample and evaluate the schedule against it, unless
+    the device runs the schedule itself (local_schedule) and every entry can
+    run there. Returns the config the device should apply (auto_control, and
+    pid_mode / scheduled_target when they changed).
+    """
+    global last_schedule_cmd_key
     now = datetime.utcnow().isoformat()
 
     # -999 is the ESP32 sentinel for "no sensor connected" — treat as None
@@ -514,7 +815,12 @@ async def post_telemetry(request: Request):
             conn.commit()
 
     # Check schedule for current slot
-    action = get_scheduled_action_now()
+    action = None
+    if not local_schedule or schedule_cache["hub_only"]:
+        action = get_scheduled_action_now()
+        if action and local_schedule and (action["type"] == "temp" or
+                                          action["command"] in _SCH_COMMANDS):
+            action = None  # the device fires this one itself
     response = {"status": "ok", "auto_control": device_state["auto_control"]}
 
     # Push pid_mode config to ESP32 if it differs from what the device reported
@@ -555,6 +861,7 @@ async def post_telemetry(request: Request):
                         conn.execute("INSERT INTO commands (ts, command, source) VALUES (?,?,?)",
                                      (datetime.utcnow().isoformat(), "on", "schedule"))
                         conn.commit()
+                    notify_command_queued()
                     log.info("Schedule turned heater ON")
 
                 if need_update:
@@ -580,16 +887,144 @@ async def post_telemetry(request: Request):
                         (datetime.utcnow().isoformat(), action["command"], "schedule")
                     )
                     conn.commit()
+                notify_command_queued()
                 log.info("Schedule command queued: %s", action["command"])
 
-    if crypto_active:
-        from fastapi.responses import PlainTextResponse
-        return PlainTextResponse(
-            MessageCrypto(device_pwd).encrypt_envelope(json.dumps(response)),
-            media_type="application/x-encrypted"
-        )
     return response
 
+# ── ESP32: POST telemetry (pre-sync firmware) ──────────────────
+@app.post("/api/telemetry")
+async def post_telemetry(request: Request):
+    device_pwd, payload, envelope = await read_device_body(request)
+    try:
+        if isinstance(payload, bytes):
+            data = decode_telemetry_frame(payload)[0][0]
+        else:
+            data = TelemetryIn(**json.loads(payload))
+    except Exception as e:
+        log.error("Failed to parse telemetry body: %s | raw: %.80s", e, payload)
+        raise HTTPException(400, "Bad telemetry body")
+    local_schedule = request.headers.get("X-Local-Schedule", "") == SCHEDULE_BIN_FORMAT
+    return device_response(apply_telemetry(data, local_schedule), device_pwd, envelope)
+
+# ── ESP32: POST buffered telemetry after an outage ────────────
+# Back-pressure for store-and-forward uploads: at most TELEMETRY_BATCH_MAX
+# samples per request and one request per TELEMETRY_BATCH_MIN_INTERVAL_S per
+# device. The device drops only what was accepted and waits retry_after_ms.
+TELEMETRY_BATCH_MAX = 32
+TELEMETRY_BATCH_MIN_INTERVAL_S = 0.25
+_last_batch_at: dict = {}
+
+@app.post("/api/telemetry/batch")
+async def post_telemetry_batch(request: Request):
+    """
+    Historical samples the device buffered while the hub was unreachable.
+    They are stored with their own timestamps and do not touch live state or
+    the schedule.
+    """
+    device_id = request.headers.get("X-Device-ID", "").upper()
+    device_pwd, payload, envelope = await read_device_body(request)
+    try:
+        if isinstance(payload, bytes):
+            body = TelemetryBatchIn(samples=decode_telemetry_frame(payload)[0])
+        else:
+            body = TelemetryBatchIn(**json.loads(payload))
+    except Exception as e:
+        log.error("Failed to parse telemetry batch: %s | raw: %.80s", e, payload)
+        raise HTTPException(400, "Bad telemetry batch")
+
+    now_mono = time.monotonic()
+    wait_s = _last_batch_at.get(device_id, 0) + TELEMETRY_BATCH_MIN_INTERVAL_S - now_mono
+    if wait_s > 0:
+        return device_response({"status": "busy", "accepted": 0,
+                                "retry_after_ms": int(wait_s * 1000) + 1},
+                               device_pwd, envelope)
+    _last_batch_at[device_id] = now_mono
+
+    NO_SENSOR = -999.0
+    now = datetime.utcnow()
+    rows = []
+    for sample in body.samples[:TELEMETRY_BATCH_MAX]:
+        if sample.ts:
+            ts = datetime.utcfromtimestamp(sample.ts / 1000)
+        else:
+            ts = now - timedelta(milliseconds=sample.age_ms or 0)
+        room   = None if (sample.room_temp   is None or sample.room_temp   <= NO_SENSOR) else sample.room_temp
+        target = None if (sample.target_temp is None or sample.target_temp <= NO_SENSOR) else sample.target_temp
+        rows.append((ts.isoformat(), room, target,
+                     int(sample.power) if sample.power is not None else None,
+                     sample.mode, sample.pid_p, sample.pid_i, sample.pid_d,
+                     sample.pid_steps, sample.integral))
+
+    try:
+        with get_db() as conn:
+            conn.executemany("""
+                INSERT INTO telemetry
+                  (ts, room_temp, target_temp, power, mode, pid_p, pid_i, pid_d, pid_steps, integral)
+                VALUES (?,?,?,?,?,?,?,?,?,?)
+            """, rows)
+            conn.commit()
+    except sqlite3.OperationalError as e:
+        log.warning("Telemetry batch deferred: %s", e)
+        return device_response({"status": "busy", "accepted": 0, "retry_after_ms": 2000},
+                               device_pwd, envelope)
+
+    log.info("Stored %d buffered telemetry samples from %s", len(rows), device_id or "?")
+    return device_response({"status": "ok", "accepted": len(rows), "retry_after_ms": 0},
+                           device_pwd, envelope)
+
+# ── ESP32: combined sync ──────────────────────────────────────
+@app.post("/api/sync")
+async def post_sync(request: Request):
+    """
+    One round-trip per device cycle: takes the pending telemetry sample and
+    log entries recorded since the last sync, returns every queued command
+    plus any config change or schedule override. Replaces separate
+    /api/telemetry and /api/command/pending requests.
+    """
+    device_id = request.headers.get("X-Device-ID", "").upper()
+    device_pwd, payload, envelope = await read_device_body(request)
+    try:
+        if isinstance(payload, bytes):
+            samples, logs = decode_telemetry_frame(payload)
+            body = SyncIn(telemetry=samples[0] if samples else None, logs=logs)
+        else:
+            body = SyncIn(**json.loads(payload))
+    except Exception as e:
+        log.error("Failed to parse sync body: %s | raw: %.80s", e, payload)
+        raise HTTPException(400, "Bad sync body")
+
+    if body.telemetry is not None:
+        local_schedule = request.headers.get("X-Local-Schedule", "") == SCHEDULE_BIN_FORMAT
+        response = apply_telemetry(body.telemetry, local_schedule)
+    else:
+        response = {"status": "ok", "auto_control": device_state["auto_control"]}
+
+    if body.logs:
+        store_device_logs(device_id, body.logs)
+        response["log_ack"] = body.logs[-1][0]
+
+    response["commands"] = dequeue_pending_commands(SYNC_MAX_COMMANDS)
+    return device_response(response, device_pwd, envelope)
+
+def store_device_logs(device_id: str, logs: list):
+    rows = []
+    for entry in logs:
+        if len(entry) < 7:
+            continue
+        seq, ev_type, command, success, detail, unix_ms, boot_ms = entry[:7]
+        rows.append((datetime.utcnow().isoformat(), device_id or None, seq, ev_type,
+                     command, int(bool(success)), detail, unix_ms or None, boot_ms))
+    if not rows:
+        return
+    with get_db() as conn:
+        conn.executemany("""
+            INSERT INTO device_log
+              (ts, device_id, seq, type, command, success, detail, unix_ms, boot_ms)
+            VALUES (?,?,?,?,?,?,?,?,?)
+        """, rows)
+        conn.commit()
+
 # ── Dashboard: GET current status ─────────────────────────────
 @app.get("/api/status")
 def get_status():
@@ -609,6 +1044,7 @@ def set_auto_control(body: AutoControlIn):
                      (json.dumps(body.enabled),))
         conn.commit()
     log.info("Auto control %s", "enabled" if body.enabled else "disabled")
+    request_device_sync()
     return {"status": "ok", "auto_control": body.enabled}
 
 # ── Dashboard / ESP32: send command ───────────────────────────
@@ -679,33 +1115,43 @@ def post_command(body: CommandIn):
         conn.execute("INSERT INTO commands (ts, command, source) VALUES (?,?,'dashboard')",
                      (datetime.utcnow().isoformat(), body.command))
         conn.commit()
+    notify_command_queued()
 
     log.info("Command queued: %s", body.command)
     return {"status": "queued", "command": body.command}
 
 # ── ESP32: poll for pending command ───────────────────────────
-@app.get("/api/command/pending")
-def get_pending_command(request: Request):
+SYNC_MAX_COMMANDS = 8
+
+def _resolve_command(conn, cmd: str) -> dict:
     """
-    ESP32 calls this after each telemetry POST.
-    Returns the most recent unacknowledged command if any, then marks it done.
-    For custom buttons, resolves the button ID to raw IR data so the device
-    can send it directly without needing to store codes locally.
-    Encrypts the response when the device sends X-Encrypted: 1.
+    Build the device payload for a queued command. Custom buttons are
+    resolved to raw IR data so the device can send them without storing codes
+    locally; returns {"command": None} when that is not possible.
     """
-    device_id = request.headers.get("X-Device-ID", "").upper()
-    want_encrypted = request.headers.get("X-Encrypted", "0") == "1"
-    device_pwd = DEVICES.get(device_id, {}).get("password") if device_id else None
-
-    def _maybe_encrypt(payload: dict) -> object:
-        if want_encrypted and device_pwd:
-            from fastapi.responses import PlainTextResponse
-            return PlainTextResponse(
-                MessageCrypto(device_pwd).encrypt_envelope(json.dumps(payload)),
-                media_type="application/x-encrypted"
-            )
-        return payload
-
+    if cmd.startswith("custom_"):
+        try:
+            button_id = int(cmd.split("_", 1)[1])
+            btn = conn.execute(
+                "SELECT name, protocol, address, command FROM custom_buttons WHERE id=?",
+                (button_id,)
+            ).fetchone()
+            if btn and not (btn["protocol"] == 0 and btn["address"] == 0 and btn["command"] == 0):
+                return {
+                    "command": "send_ir",
+                    "protocol": btn["protocol"],
+                    "address": btn["address"],
+                    "ir_command": btn["command"],
+                    "name": btn["name"]
+                }
+        except (ValueError, IndexError):
+            pass
+        return {"command": None}
+
+    return {"command": cmd}
+
+def dequeue_pending_command() -> dict:
+    """Pop the most recent unacknowledged command, marking it sent."""
     with get_db() as conn:
         row = conn.execute("""
             SELECT id, command FROM commands
@@ -714,33 +1160,62 @@ def get_pending_command(request: Request):
             ORDER BY id DESC LIMIT 1
         """).fetchone()
         if not row:
-            return _maybe_encrypt({"command": None})
+            return {"command": None}
         conn.execute("UPDATE commands SET source='sent' WHERE id=?", (row["id"],))
         conn.commit()
+        return _resolve_command(conn, row["command"])
 
-        cmd = row["command"]
-
-        # Resolve custom button to raw IR data
-        if cmd.startswith("custom_"):
-            try:
-                button_id = int(cmd.split("_", 1)[1])
-                btn = conn.execute(
-                    "SELECT name, protocol, address, command FROM custom_buttons WHERE id=?",
-                    (button_id,)
-                ).fetchone()
-                if btn and not (btn["protocol"] == 0 and btn["address"] == 0 and btn["command"] == 0):
-                    return _maybe_encrypt({
-                        "command": "send_ir",
-                        "protocol": btn["protocol"],
-                        "address": btn["address"],
-                        "ir_command": btn["command"],
-                        "name": btn["name"]
-                    })
-            except (ValueError, IndexError):
-                pass
-            return _maybe_encrypt({"command": None})
-
-        return _maybe_encrypt({"command": cmd})
+def dequeue_pending_commands(limit: int) -> list:
+    """Pop up to `limit` unacknowledged commands, oldest first, marking them sent."""
+    with get_db() as conn:
+        rows = conn.execute("""
+            SELECT id, command FROM commands
+            WHERE source IN ('dashboard','schedule')
+              AND ts > datetime('now', '-30 seconds')
+            ORDER BY id ASC LIMIT ?
+        """, (limit,)).fetchall()
+        if not rows:
+            return []
+        conn.executemany("UPDATE commands SET source='sent' WHERE id=?",
+                         [(row["id"],) for row in rows])
+        conn.commit()
+        payloads = [_resolve_command(conn, row["command"]) for row in rows]
+    return [p for p in payloads if p["command"] is not None]
+
+@app.get("/api/command/pending")
+async def get_pending_command(request: Request, wait: float = 0):
+    """
+    ESP32 polls this for queued commands.
+    With ?wait=N (long-poll) the request is held for up to N seconds and
+    completes the moment a command is queued; the X-Long-Poll response header
+    tells the device push is supported. Without it, returns immediately.
+    Encrypts the response in the envelope version the device names in
+    X-Encrypted (1, 2 or 3).
+    """
+    device_id = request.headers.get("X-Device-ID", "").upper()
+    envelope = request.headers.get("X-Encrypted", "0")
+    envelope = int(envelope) if envelope in ("1", str(ENVELOPE_V2), str(ENVELOPE_V3)) else 0
+    device_pwd = DEVICES.get(device_id, {}).get("password") if device_id else None
+
+    wait = max(0.0, min(wait, LONG_POLL_MAX_WAIT_S))
+    deadline = time.monotonic() + wait
+    while True:
+        # Grab the event before checking the queue so a command inserted in
+        # between still wakes us.
+        event = _current_command_event()
+        payload = dequeue_pending_command()
+        if take_device_sync_request():
+            payload["sync"] = True
+        remaining = deadline - time.monotonic()
+        if payload["command"] is not None or payload.get("sync") or remaining <= 0:
+            break
+        try:
+            await asyncio.wait_for(event.wait(), remaining)
+        except asyncio.TimeoutError:
+            pass
+
+    headers = {"X-Long-Poll": "1"} if wait > 0 else {}
+    return device_response(payload, device_pwd, envelope, headers)
 
 # ── IR Learn: GET status (dashboard polls this) ───────────────
 @app.get("/api/learn/status")
@@ -870,6 +1345,7 @@ def learn_custom_button(button_id: int):
         conn.execute("INSERT INTO commands (ts, command, source) VALUES (?,?,'dashboard')",
                      (datetime.utcnow().isoformat(), "learn_custom"))
         conn.commit()
+    notify_command_queued()
     log.info("Starting learn for custom button: id=%d name=%s", button_id, row["name"])
     return {"status": "ok", "id": button_id, "name": row["name"]}
 
@@ -888,6 +1364,7 @@ def send_custom_button(button_id: int):
         conn.execute("INSERT INTO commands (ts, command, source) VALUES (?,?,?)",
                      (datetime.utcnow().isoformat(), f"custom_{button_id}", "dashboard"))
         conn.commit()
+    notify_command_queued()
     log.info("Custom button queued: %s (proto=%d addr=0x%04X cmd=0x%04X)",
              row["name"], row["protocol"], row["address"], row["command"])
     return {"status": "queued", "name": row["name"], "protocol": row["protocol"],
@@ -927,7 +1404,29 @@ def get_history(hours: int = 336):
 
 # ── Schedule: GET ─────────────────────────────────────────────
 @app.get("/api/schedule")
-def get_schedule():
+def get_schedule(request: Request, format: str = ""):
+    """
+    The dashboard gets the rows as JSON. ESP32s ask for ?format=sch2 and get
+    the compiled frame, encrypted in the envelope version named in
+    X-Encrypted like every other device response, or a bodiless 304 when
+    If-None-Match names the current ETag.
+    """
+    if format == SCHEDULE_BIN_FORMAT:
+        headers = {"ETag": schedule_cache["etag"]}
+        if request.headers.get("If-None-Match") == schedule_cache["etag"]:
+            return Response(status_code=304, headers=headers)
+        device_id  = request.headers.get("X-Device-ID", "").upper()
+        device_pwd = DEVICES.get(device_id, {}).get("password") if device_id else None
+        envelope   = request.headers.get("X-Encrypted", "0")
+        envelope   = int(envelope) if envelope in ("1", str(ENVELOPE_V2), str(ENVELOPE_V3)) else 0
+        frame = schedule_cache["frame"]
+        if envelope and device_pwd:
+            crypto = MessageCrypto(device_pwd)
+            body = (base64.b64encode(crypto.seal_binary(envelope, frame)).decode()
+                    if envelope in (ENVELOPE_V2, ENVELOPE_V3)
+                    else crypto.encrypt_envelope(frame))
+            return PlainTextResponse(body, media_type="application/x-encrypted", headers=headers)
+        return Response(frame, media_type="application/octet-stream", headers=headers)
     with get_db() as conn:
         rows = conn.execute("SELECT day, time, type, temp, command FROM schedule ORDER BY day, time").fetchall()
     return {"schedule": [dict(r) for r in rows]}
@@ -942,6 +1441,10 @@ def save_schedule(body: ScheduleIn):
             [(e.day, e.time, e.type, e.temp, e.command) for e in body.schedule]
         )
         conn.commit()
+    etag = schedule_cache["etag"]
+    refresh_schedule_cache()
+    if schedule_cache["etag"] != etag:
+        request_device_sync()  # devices re-fetch at once instead of within 6 h
     log.info("Schedule saved: %d entries", len(body.schedule))
     return {"status": "saved", "entries": len(body.schedule)}
 
@@ -1018,6 +1521,8 @@ def save_config(body: ConfigIn):
                          [(k, json.dumps(v)) for k, v in data.items()])
         conn.commit()
     log.info("Config updated: %s", list(data.keys()))
+    if "pid_mode" in data:
+        request_device_sync()
     return {"status": "saved", "keys": list(data.keys())}
 
 # ── ESP32: poll config (on boot) ──────────────────────────────
@@ -1068,6 +1573,7 @@ def get_scheduled_action_now() -> dict | None:
 @app.on_event("startup")
 def startup():
     init_db()
+    refresh_schedule_cache()
     with get_db() as conn:
         for key in ("target_temp",):
             row = conn.execute("SELECT value FROM config WHERE key=?", (key,)).fetchone()
@@ -1,17 +1,24 @@
 #include "app/adaptive_thermostat_tuning.h"
+#include "app/control_task.h"
 #include "app/pid_thermostat_controller.h"
 #include "commands.h"
+#include "core/spsc_queue.h"
+#include "core/timer_wheel.h"
 #include "diagnostics/diag.h"
 #include "hub/hub_client.h"
 #include "hub/hub_connectivity.h"
+#include "hub/hub_link.h"
 #include "hub/hub_receiver.h"
+#include "hub/hub_worker.h"
+#include "hub/schedule_codec.h"
+#include "log_drain.h"
 #include "logger.h"
 #include "prefferences.h"
 #include "time/wall_clock.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
-#include <scheduler/scheduler.h>
+#include <scheduler/weekly_plan.h>
 #include <WiFiManager.h>
 
 // ── HARDWARE FLAGS ────────────────────────────────────────────
@@ -87,27 +94,39 @@ namespace MockRoom {
 
 bool should_reprovision() {
     pinMode(PROVISION_BUTTON_GPIO, INPUT_PULLUP);
-    Serial.printf("[WIFI] Boot button state: %d\n", digitalRead(PROVISION_BUTTON_GPIO));
+    DIAG_LOGF(INFO, "WIFI", "Boot button state: %d", digitalRead(PROVISION_BUTTON_GPIO));
     if (digitalRead(PROVISION_BUTTON_GPIO) == LOW) {
-        Serial.println("[WIFI] Button held, hold 3s to reprovision...");
+        DIAG_LOGF(INFO, "WIFI", "Button held, hold 3s to reprovision...");
         delay(HOLD_DURATION_MS);
         if (digitalRead(PROVISION_BUTTON_GPIO) == LOW) {
-            Serial.println("[WIFI] Confirmed.");
+            DIAG_LOGF(INFO, "WIFI", "Confirmed.");
             return true;
         }
-        Serial.println("[WIFI] Released too early, ignoring.");
+        DIAG_LOGF(INFO, "WIFI", "Released too early, ignoring.");
     }
     return false;
 }
 
 // ── GLOBALS ──────────────────────────────────────────────────
+void runControlStep(uint32_t nowMs);
+
 namespace {
+    // Sensor -> PID -> IR, run by gControlTask (or loop() as a fallback).
+    struct ControlPipeline : ControlStep {
+        void controlStep(uint32_t nowMs) override { runControlStep(nowMs); }
+    };
+
     HubReceiver              gHubReceiver;
     Logger                   gLogger;
+    LogDrain                 gLogDrain;
     NtpClock                 gWallClock;
     HubConnectivity          gHubConnectivity;
-    HubClient                gHubClient(gHubReceiver, gLogger);
-    CommandScheduler         gCommandScheduler;
+    HubLink                  gHubLink(gHubReceiver, gLogger);
+    HubClient                gHubClient(gHubLink, gLogger);
+    HubWorker                gHubWorker(gHubClient, kHubWorkerPeriodMs);
+    ControlPipeline          gControlPipeline;
+    ControlTask              gControlTask(gControlPipeline, kControlTaskPeriodMs);
+    SchedulePlan             gSchedulePlan;  // the hub's weekly plan
     PidThermostatController  gPid;
     AdaptiveThermostatTuning gAdaptive;
 
@@ -140,38 +159,78 @@ namespace {
     enum class LearnState { IDLE, WARMUP, LISTENING, DONE_OK, DONE_FAIL };
     LearnState gLearnState    = LearnState::IDLE;
     Command    gLearnTarget   = Command::NONE;
-    uint32_t   gLearnStartMs  = 0;
+    // Warm-up, then listen timeout: a phase ends when gLearnTimer expires.
+    TimerWheel<2> gControlTimers;
+    TimerId    gLearnTimer    = kNoTimer;
     constexpr uint32_t kLearnWarmupMs   = 800;   // WiFi-active grace period before IR capture
     constexpr uint32_t kLearnTimeoutMs  = 10000;
+
+    // PID steps still to send, one per gIrStepTimer expiry (> 0: TEMP_UP).
+    int        gIrStepsPending = 0;
+    TimerId    gIrStepTimer    = kNoTimer;
+    constexpr uint32_t kIrStepGapMs     = 50;    // heater needs a gap between presses
 #endif
 
 #ifdef REAL_OLED
     Adafruit_SSD1306 gDisplay(128, 64, &Wire, -1);
 #endif
+
+    // ── Control task <-> loop() ──────────────────────────────
+    // The only data crossing between the two. Everything above belongs to the
+    // control task once it runs; loop() keeps WiFi, learn posts and the OLED.
+    struct NetStatus {
+        bool wifiConnected = false;
+    };
+    SpscQueue<NetStatus, 4> gNetStatusQueue;  // loop() -> control, on change
+    bool gWifiConnected = false;              // control task's copy
+
+#ifdef REAL_IR_TX
+    struct LearnReport {
+        Command  target   = Command::NONE;
+        bool     success  = false;
+        bool     hasCode  = false;
+        uint8_t  protocol = 0;
+        uint16_t address  = 0;
+        uint16_t command  = 0;
+    };
+    SpscQueue<LearnReport, 4> gLearnReportQueue;  // control -> loop(), posted to the hub
+#endif
+
+#ifdef REAL_OLED
+    struct DisplayState {
+        float       roomTempC   = 0.0f;
+        float       targetTempC = 0.0f;
+        bool        heaterOn    = false;
+        const char* lastIrCmd   = "none";
+        int         lastIrSteps = 0;
+        PidThermostatController::Result pid{};
+    };
+    SpscQueue<DisplayState, 4> gDisplayQueue;  // control -> loop(), latest wins
+#endif
 } // namespace
 
 // ── OLED UPDATE ───────────────────────────────────────────────
 #ifdef REAL_OLED
-void updateDisplay(float roomTempC, float targetTempC, bool heaterOn) {
+void updateDisplay(const DisplayState& state) {
     gDisplay.clearDisplay();
     gDisplay.setTextColor(SSD1306_WHITE);
 
     // Row 1: big room temp + power state
     gDisplay.setTextSize(2);
     gDisplay.setCursor(0, 0);
-    gDisplay.printf("%.1fC", roomTempC);
+    gDisplay.printf("%.1fC", state.roomTempC);
     gDisplay.setTextSize(1);
     gDisplay.setCursor(90, 4);
-    gDisplay.print(heaterOn ? "[ ON ]" : "[OFF]");
+    gDisplay.print(state.heaterOn ? "[ ON ]" : "[OFF]");
 
     // Row 2: target
     gDisplay.setCursor(0, 20);
-    gDisplay.printf("Target: %.1fC", targetTempC);
+    gDisplay.printf("Target: %.1fC", state.targetTempC);
 
     // Row 3: last IR command
     gDisplay.setCursor(0, 32);
-    if (gLastIrSteps != 0) {
-        gDisplay.printf("IR: %s x%d", gLastIrCmd, abs(gLastIrSteps));
+    if (state.lastIrSteps != 0) {
+        gDisplay.printf("IR: %s x%d", state.lastIrCmd, abs(state.lastIrSteps));
     } else {
         gDisplay.print("IR: idle");
     }
@@ -179,11 +238,11 @@ void updateDisplay(float roomTempC, float targetTempC, bool heaterOn) {
     // Row 4: PID values
     gDisplay.setCursor(0, 44);
     gDisplay.printf("P:%.1f I:%.2f D:%.1f",
-                    gLastPidResult.p, gLastPidResult.i, gLastPidResult.d);
+                    state.pid.p, state.pid.i, state.pid.d);
 
     // Row 5: steps
     gDisplay.setCursor(0, 54);
-    gDisplay.printf("Steps: %+d", gLastPidResult.steps);
+    gDisplay.printf("Steps: %+d", state.pid.steps);
 
     gDisplay.display();
 }
@@ -197,8 +256,8 @@ void onHeaterTurnedOn(uint32_t nowMs, const WallClockSnapshot& wallNow,
     gTargetAtOnC      = targetTempC;
     gHeaterOnMs       = nowMs;
     gHeaterOnSnapshot = wallNow;
-    Serial.printf("[HEAT] ON  at %02d:%02d — room %.1f°C, target %.1f°C\n",
-                  wallNow.hour, wallNow.minute, roomTempC, targetTempC);
+    DIAG_LOGF(INFO, "HEAT", "ON  at %02d:%02d — room %.1f°C, target %.1f°C",
+              wallNow.hour, wallNow.minute, roomTempC, targetTempC);
     gLogger.log(wallNow, LogEventType::STATE_CHANGE, Command::ON_OFF, true);
 }
 
@@ -209,9 +268,9 @@ void onHeaterTurnedOff(uint32_t nowMs, const WallClockSnapshot& wallNow,
     const uint32_t durationMin = durationMs / 60000UL;
     const uint32_t durationSec = (durationMs % 60000UL) / 1000UL;
     const float    rise        = roomTempC - gRoomAtOnC;
-    Serial.printf("[HEAT] OFF at %02d:%02d — ran %um%02us | %.1f°C → %.1f°C (%.1f° rise) | target was %.1f°C\n",
-                  wallNow.hour, wallNow.minute, durationMin, durationSec,
-                  gRoomAtOnC, roomTempC, rise, gTargetAtOnC);
+    DIAG_LOGF(INFO, "HEAT", "OFF at %02d:%02d — ran %um%02us | %.1f°C → %.1f°C (%.1f° rise) | target was %.1f°C",
+              wallNow.hour, wallNow.minute, durationMin, durationSec,
+              gRoomAtOnC, roomTempC, rise, gTargetAtOnC);
     gLogger.log(wallNow, LogEventType::STATE_CHANGE, Command::ON_OFF, true);
     gHeaterWasOn = false;
 }
@@ -222,7 +281,7 @@ bool fetchTimezoneOffset(int32_t& outOffsetSeconds) {
     http.begin(kIpTimezoneUrl);
     const int code = http.GET();
     if (code != 200) {
-        Serial.printf("ip-api failed, HTTP %d\n", code);
+        DIAG_LOGF(WARN, "TIME", "ip-api failed, HTTP %d", code);
         http.end();
         return false;
     }
@@ -230,16 +289,16 @@ bool fetchTimezoneOffset(int32_t& outOffsetSeconds) {
     http.end();
     StaticJsonDocument<256> doc;
     if (deserializeJson(doc, body) != DeserializationError::Ok) {
-        Serial.println("JSON parse failed");
+        DIAG_LOGF(WARN, "TIME", "ip-api JSON parse failed");
         return false;
     }
     if (String(doc["status"].as<const char*>()) != "success") {
-        Serial.println("ip-api returned non-success");
+        DIAG_LOGF(WARN, "TIME", "ip-api returned non-success");
         return false;
     }
     outOffsetSeconds = doc["offset"].as<int32_t>();
     const char* tz = doc["timezone"].as<const char*>();
-    Serial.printf("Detected timezone: %s (offset=%lds)\n", tz, outOffsetSeconds);
+    DIAG_LOGF(INFO, "TIME", "Detected timezone: %s (offset=%lds)", tz, static_cast<long>(outOffsetSeconds));
     return true;
 }
 
@@ -260,9 +319,19 @@ const char* portalCSS = R"(
 void setup() {
     Serial.begin(115200);
     delay(1000);
+    if (kLogDrainEnabled) {
+        gLogger.setDrain(&gLogDrain);
+        if (!gLogDrain.begin()) {
+            DIAG_LOGF(WARN, "LOG", "Drain task not started, printing from loop()");
+        }
+    }
+    // Before WiFi and NTP: loop() loads the saved plan on its first tick.
+    if (kHubScheduleSyncEnabled && kHubScheduleCacheToNvs) {
+        gHubClient.beginScheduleCache("thermo-sched");
+    }
 
 #ifdef DEV_WIFI_SSID
-    Serial.println("[WIFI] Dev mode: connecting with hardcoded credentials...");
+    DIAG_LOGF(INFO, "WIFI", "Dev mode: connecting with hardcoded credentials...");
     if (strlen(DEV_WIFI_PASSWORD) == 0) {
         WiFi.begin(DEV_WIFI_SSID);
     } else {
@@ -278,11 +347,11 @@ void setup() {
     wifiManager.setCustomHeadElement(portalCSS);
 
     if (reprovision) {
-        Serial.println("[WIFI] Reprovisioning requested, wiping credentials...");
+        DIAG_LOGF(INFO, "WIFI", "Reprovisioning requested, wiping credentials...");
         wifiManager.resetSettings();
     }
     wifiManager.autoConnect("ESP32-Setup");
-    Serial.printf("[WIFI] Connected — dashboard: http://%s:%d/device/%s\n", kHubHost, kHubPort, DEVICE_ID);
+    DIAG_LOGF(INFO, "WIFI", "Connected — dashboard: http://%s:%d/device/%s", kHubHost, kHubPort, DEVICE_ID);
 #endif
 
     Serial.println();
@@ -293,7 +362,7 @@ void setup() {
     if (fetchTimezoneOffset(offsetSeconds)) {
         configTime(offsetSeconds, 0, kNtpServerPrimary, kNtpServerSecondary, kNtpServerTertiary);
     } else {
-        Serial.println("[TIME] Falling back to UTC");
+        DIAG_LOGF(WARN, "TIME", "Falling back to UTC");
         configTime(0, 0, kNtpServerPrimary, kNtpServerSecondary, kNtpServerTertiary);
     }
 
@@ -305,43 +374,48 @@ void setup() {
     gWallClock.setUnixTimeMs(static_cast<uint64_t>(now) * 1000ULL, millis());
     struct tm timeinfo;
     localtime_r(&now, &timeinfo);
-    Serial.printf("[TIME] Synced: %04d-%02d-%02d %02d:%02d:%02d\n",
-                  timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                  timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+    DIAG_LOGF(INFO, "TIME", "Synced: %04d-%02d-%02d %02d:%02d:%02d",
+              timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+              timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
 
     gHubConnectivity.begin(gHubReceiver, gWallClock);
-    gCommandScheduler.setEnabled(true);
+    if (kTelemetryRingSpillToNvs) {
+        gHubClient.beginTelemetrySpill("thermo-telem");
+    }
+    if (kHubWorkerEnabled && !gHubWorker.begin()) {
+        DIAG_LOGF(WARN, "HUB", "Worker task not started, servicing hub from loop()");
+    }
 
 #ifndef REAL_TEMP_SENSOR
     gTargetTempC = MockRoom::roomTempC;
     gPid.reset(MockRoom::roomTempC);
-    Serial.printf("[MOCK] Season: %s | start=%.1f°C outside=%.1f°C target=%.1f°C (synced to room)\n",
-                  MockRoom::kSeason == MockRoom::Season::WINTER ? "WINTER" : "SUMMER",
-                  MockRoom::kStartTempC, MockRoom::kOutsideTempC, gTargetTempC);
+    DIAG_LOGF(INFO, "MOCK", "Season: %s | start=%.1f°C outside=%.1f°C target=%.1f°C (synced to room)",
+              MockRoom::kSeason == MockRoom::Season::WINTER ? "WINTER" : "SUMMER",
+              MockRoom::kStartTempC, MockRoom::kOutsideTempC, gTargetTempC);
 #else
     gTempSensor.begin();
     const float initialTempC = gTempSensor.readTemperatureC();
     gTargetTempC = initialTempC;
     gPid.reset(initialTempC);
-    Serial.printf("[SENSOR] DS18B20 active. Initial temp: %.1f°C (target synced)\n", initialTempC);
+    DIAG_LOGF(INFO, "SENSOR", "DS18B20 active. Initial temp: %.1f°C (target synced)", initialTempC);
 #endif
 
 #ifdef REAL_IR_TX
     gIrLearner.begin();
     gIrSend.setLearner(&gIrLearner);  // must be before begin() — begin() calls learner_->beginSend()
     gIrSend.begin();
-    Serial.printf("[IR] Transmitter ready on GPIO %d\n", kIrTxPin);
-    Serial.printf("[IR] Learner ready (rx GPIO %d). Learned codes: ON=%s UP=%s DN=%s\n",
-                  kIrRxPin,
-                  gIrLearner.hasLearned(Command::ON_OFF)    ? "yes" : "no",
-                  gIrLearner.hasLearned(Command::TEMP_UP)   ? "yes" : "no",
-                  gIrLearner.hasLearned(Command::TEMP_DOWN) ? "yes" : "no");
+    DIAG_LOGF(INFO, "IR", "Transmitter ready on GPIO %d", kIrTxPin);
+    DIAG_LOGF(INFO, "IR", "Learner ready (rx GPIO %d). Learned codes: ON=%s UP=%s DN=%s",
+              kIrRxPin,
+              gIrLearner.hasLearned(Command::ON_OFF)    ? "yes" : "no",
+              gIrLearner.hasLearned(Command::TEMP_UP)   ? "yes" : "no",
+              gIrLearner.hasLearned(Command::TEMP_DOWN) ? "yes" : "no");
 #endif
 
 #ifdef REAL_OLED
     Wire.begin(kOledSdaPin, kOledSclPin);
     if (!gDisplay.begin(SSD1306_SWITCHCAPVCC, kOledAddress)) {
-        Serial.println("[OLED] Display not found!");
+        DIAG_LOGF(WARN, "OLED", "Display not found!");
     } else {
         gDisplay.clearDisplay();
         gDisplay.setTextColor(SSD1306_WHITE);
@@ -350,14 +424,20 @@ void setup() {
         gDisplay.println("ThermoHub");
         gDisplay.println("Starting...");
         gDisplay.display();
-        Serial.println("[OLED] Display ready.");
+        DIAG_LOGF(INFO, "OLED", "Display ready.");
     }
 #endif
+
+    if (kControlTaskEnabled && !gControlTask.begin()) {
+        DIAG_LOGF(WARN, "CTRL", "Control task not started, running control from loop()");
+    }
 }
 
 // ── LEARN RESULT POST ─────────────────────────────────────────
 #ifdef REAL_IR_TX
-static bool postLearnResult(Command cmd, bool success) {
+static bool postLearnResult(const LearnReport& report) {
+    const Command cmd     = report.target;
+    const bool    success = report.success;
     const char* cmdStr = "on_off";
     if (cmd == Command::TEMP_UP)       cmdStr = "temp_up";
     if (cmd == Command::TEMP_DOWN)     cmdStr = "temp_down";
@@ -365,12 +445,11 @@ static bool postLearnResult(Command cmd, bool success) {
 
     char body[256];
     if (cmd == Command::LEARN_CUSTOM && success) {
-        LearnedCode code;
-        if (gIrLearner.getLastCaptured(code)) {
+        if (report.hasCode) {
             snprintf(body, sizeof(body),
                 "{\"cmd\":\"%s\",\"status\":\"ok\","
                 "\"protocol\":%d,\"address\":%d,\"command\":%d}",
-                cmdStr, code.protocol, code.address, code.command);
+                cmdStr, report.protocol, report.address, report.command);
         } else {
             snprintf(body, sizeof(body), "{\"cmd\":\"%s\",\"status\":\"ok\"}", cmdStr);
         }
@@ -390,7 +469,7 @@ static bool postLearnResult(Command cmd, bool success) {
         WiFiClient wifiClient;
         HTTPClient http;
         if (!http.begin(wifiClient, url)) {
-            Serial.printf("[LEARN] http.begin() failed (attempt %d/5)\n", attempt + 1);
+            DIAG_LOGF(WARN, "LEARN", "http.begin() failed (attempt %d/5)", attempt + 1);
             continue;
         }
         http.addHeader("Content-Type", "application/json");
@@ -401,24 +480,29 @@ static bool postLearnResult(Command cmd, bool success) {
         const int code = http.POST(body);
         http.end();
         if (code == 200) {
-            Serial.printf("[LEARN] Reported %s=%s to hub\n", cmdStr, success ? "ok" : "fail");
+            DIAG_LOGF(INFO, "LEARN", "Reported %s=%s to hub", cmdStr, success ? "ok" : "fail");
             return true;
         }
-        Serial.printf("[LEARN] POST failed HTTP %d (attempt %d/5)\n", code, attempt + 1);
+        DIAG_LOGF(WARN, "LEARN", "POST failed HTTP %d (attempt %d/5)", code, attempt + 1);
     }
-    Serial.println("[LEARN] All POST attempts failed");
+    DIAG_LOGF(WARN, "LEARN", "All POST attempts failed");
     return false;
 }
 #endif
 
-// ── LOOP ─────────────────────────────────────────────────────
-void loop() {
-    const uint32_t nowMs = millis();
+// ── CONTROL STEP ─────────────────────────────────────────────
+// Runs every kControlTaskPeriodMs on the control task. Nothing in here may
+// touch the network: hub data comes through gHubLink, WiFi state through
+// gNetStatusQueue, and learn results and OLED frames go out to loop().
+void runControlStep(uint32_t nowMs) {
     const uint32_t nowUs = micros();
-    static uint32_t lastTelemetryMs = 0;
+    static uint32_t lastIdleLogMs = 0;
 
-    // ── 1. Connectivity + time ───────────────────────────────
-    gHubConnectivity.tick(nowMs, gHubReceiver, gWallClock);
+    // ── 1. Network status + time ─────────────────────────────
+    NetStatus netStatus;
+    while (gNetStatusQueue.pop(netStatus)) {
+        gWifiConnected = netStatus.wifiConnected;
+    }
     const WallClockSnapshot wallNow = gWallClock.now(nowMs, nowUs);
 
     // ── 2. Read room temperature ──────────────────────────────
@@ -433,7 +517,7 @@ void loop() {
     if (gTargetTempC < -100.0f && roomTempC > -100.0f) {
         gTargetTempC = roomTempC;
         gPid.reset(roomTempC);
-        Serial.printf("[SENSOR] Target synced to room: %.1f°C\n", roomTempC);
+        DIAG_LOGF(INFO, "SENSOR", "Target synced to room: %.1f°C", roomTempC);
     }
 #endif
 
@@ -442,13 +526,19 @@ void loop() {
     //         the user sees a "get ready" prompt before we need them to press.
     // LISTENING: pure IR polling — no WiFi calls at all (WiFi.status()
     //         at tight-loop speed corrupts the WiFi driver after a few seconds).
+    //         The suspended hub link also keeps loop() off the radio.
 #ifdef REAL_IR_TX
+    TimerExpiry expired;
+    while (gControlTimers.poll(nowMs, expired)) {
+    }
     if (gLearnState == LearnState::WARMUP) {
-        if (nowMs - gLearnStartMs >= kLearnWarmupMs) {
+        if (!gControlTimers.pending(gLearnTimer)) {
             gIrLearner.beginListen();
-            gLearnStartMs = nowMs;   // timeout counts from here, not from command receipt
+            // timeout counts from here, not from command receipt
+            gLearnTimer   = gControlTimers.start(nowMs + kLearnTimeoutMs, 0);
             gLearnState   = LearnState::LISTENING;
-            Serial.println("[LEARN] >>> PRESS YOUR REMOTE NOW <<<");
+            gHubLink.setSuspended(true);
+            DIAG_LOGF(INFO, "LEARN", ">>> PRESS YOUR REMOTE NOW <<<");
         }
         // Normal loop continues during warmup — WiFi still active
     }
@@ -457,63 +547,78 @@ void loop() {
         const LearnPollResult lpr = gIrLearner.poll(gLearnTarget);
         if (lpr == LearnPollResult::OK) {
             gLearnState = LearnState::DONE_OK;
+            gControlTimers.cancel(gLearnTimer);
             gIrLearner.stopListen();
-            Serial.printf("[LEARN] Success for %s\n", commandToString(gLearnTarget));
-        } else if (nowMs - gLearnStartMs >= kLearnTimeoutMs) {
+            gHubLink.setSuspended(false);
+            DIAG_LOGF(INFO, "LEARN", "Success for %s", commandToString(gLearnTarget));
+        } else if (!gControlTimers.pending(gLearnTimer)) {
             gLearnState = LearnState::DONE_FAIL;
             gIrLearner.stopListen();
-            Serial.printf("[LEARN] Timeout for %s\n", commandToString(gLearnTarget));
+            gHubLink.setSuspended(false);
+            DIAG_LOGF(WARN, "LEARN", "Timeout for %s", commandToString(gLearnTarget));
         }
         return;   // pure IR — nothing else
     }
 
-    // DONE: learning finished, post result to hub.
-    // Runs on the NEXT iteration after LISTENING exits.
-    // delay(500) lets the WiFi driver fully recover after seconds of
-    // zero WiFi calls in the tight IR polling loop.
+    // DONE: learning finished, hand the result to loop() to post to the hub.
+    // Runs on the NEXT cycle after LISTENING exits.
     if (gLearnState == LearnState::DONE_OK || gLearnState == LearnState::DONE_FAIL) {
-        Serial.println("[LEARN] Posting result to hub…");
-
-        // Give the WiFi radio more time to "wake up" after the tight loop
-        delay(500);
-
-        const bool ok = (gLearnState == LearnState::DONE_OK);
-
-        // We MUST successfully POST the custom IR data, or the button will be empty (0,0,0)
-        if (postLearnResult(gLearnTarget, ok)) {
-            gLearnState = LearnState::IDLE;
-            // Force a sync so the Hub knows the 'learn_custom' command is finished
-            gHubClient.tick(millis(), wallNow, true);
-        } else {
-            // If it fails after retries, reset to avoid an infinite loop.
-            gLearnState = LearnState::IDLE;
+        LearnReport report;
+        report.target  = gLearnTarget;
+        report.success = (gLearnState == LearnState::DONE_OK);
+        LearnedCode code;
+        if (report.success && gIrLearner.getLastCaptured(code)) {
+            report.hasCode  = true;
+            report.protocol = code.protocol;
+            report.address  = code.address;
+            report.command  = code.command;
+        }
+        if (!gLearnReportQueue.push(report)) {
+            DIAG_LOGF(WARN, "LEARN", "Report queue full, result not posted");
         }
+        gLearnState = LearnState::IDLE;
     }
 #endif
 
     // ── 3. Apply mode change from hub ─────────────────────────
-    const char* pendingMode = gHubClient.pendingMode();
+    const char* pendingMode = gHubLink.pendingMode();
     if (pendingMode) {
         if (strcmp(pendingMode, "ECO") == 0) {
             gPid.setMode(ThermostatMode::ECO);
-            Serial.println("[MODE] Switched to ECO");
+            DIAG_LOGF(INFO, "MODE", "Switched to ECO");
         } else if (strcmp(pendingMode, "FAST") == 0) {
             gPid.setMode(ThermostatMode::FAST);
-            Serial.println("[MODE] Switched to FAST");
+            DIAG_LOGF(INFO, "MODE", "Switched to FAST");
         }
-        gHubClient.clearPendingMode();
+        gHubLink.clearPendingMode();
     }
 
     // ── 4. Apply scheduled target from hub ────────────────────
-    const float scheduledTemp = gHubClient.scheduledTargetTemp();
+    const float scheduledTemp = gHubLink.scheduledTargetTemp();
     if (scheduledTemp > 0.0f) {
-        Serial.printf("[SCHED] Target updated: %.1f°C → %.1f°C\n", gTargetTempC, scheduledTemp);
+        DIAG_LOGF(INFO, "SCHED", "Target updated: %.1f°C → %.1f°C", gTargetTempC, scheduledTemp);
         gTargetTempC = scheduledTemp;
-        gHubClient.clearScheduledTargetTemp();
+        gHubLink.clearScheduledTargetTemp();
+    }
+
+    // ── 4b. Load the weekly schedule downloaded from the hub ──
+    {
+        size_t frameLen = 0;
+        const uint8_t* frame = gHubLink.pendingSchedule(frameLen);
+        if (frame) {
+            if (schedule_codec::load(frame, frameLen, gSchedulePlan)) {
+                DIAG_LOGF(INFO, "SCHED", "Loaded %u plan entries from hub",
+                          static_cast<unsigned>(gSchedulePlan.size()));
+            } else {
+                DIAG_LOGF(WARN, "SCHED", "Hub schedule rejected, keeping the old one");
+            }
+            gHubLink.clearPendingSchedule();
+        }
     }
 
     // ── 5. Hub tick ───────────────────────────────────────────
-    gHubClient.tick(nowMs, wallNow, gHubConnectivity.wifiConnected());
+    // Network I/O runs on the hub worker; this only swaps queued data.
+    gHubLink.tick(wallNow, gWifiConnected);
 
     // ── 6. Adaptive tuning ────────────────────────────────────
     const AdaptiveThermostatTuning::Overrides overrides = gAdaptive.update(
@@ -527,15 +632,15 @@ void loop() {
     // ── 7. PID tick (only when heater is on and auto-control enabled) ────
     PidThermostatController::Result pidResult{};
 
-    if (gHeaterPowered && gHubClient.autoControl()) {
+    if (gHeaterPowered && gHubLink.autoControl()) {
         pidResult = gPid.tick(nowMs, gTargetTempC, roomTempC);
 
         if (pidResult.ranControlCycle) {
-            Serial.printf("[PID] room=%.2f°C target=%.2f°C err=%+.2f "
-                          "P=%+.2f I=%+.3f D=%+.2f steps=%+d kp=%.2f maxSteps=%d\n",
-                          roomTempC, gTargetTempC, pidResult.errorC,
-                          pidResult.p, pidResult.i, pidResult.d, pidResult.steps,
-                          overrides.kp, overrides.maxSteps);
+            DIAG_LOGF(INFO, "PID", "room=%.2f°C target=%.2f°C err=%+.2f "
+                      "P=%+.2f I=%+.3f D=%+.2f steps=%+d kp=%.2f maxSteps=%d",
+                      roomTempC, gTargetTempC, pidResult.errorC,
+                      pidResult.p, pidResult.i, pidResult.d, pidResult.steps,
+                      overrides.kp, overrides.maxSteps);
 
             gLogger.log(wallNow, LogEventType::THERMOSTAT_CONTROL, Command::NONE, true,
                         static_cast<uint8_t>(pidResult.steps < 0 ? 0 : pidResult.steps));
@@ -547,37 +652,42 @@ void loop() {
 
 #ifndef REAL_TEMP_SENSOR
                 MockRoom::applySteps(pidResult.steps, gTargetTempC);
-                Serial.printf("[MOCK] heaterSetpoint now %.1f°C\n", MockRoom::heaterSetpointC);
+                DIAG_LOGF(INFO, "MOCK", "heaterSetpoint now %.1f°C", MockRoom::heaterSetpointC);
 #endif
                 gAdaptive.onControlStepsSent(nowMs, roomTempC, pidResult.steps);
 
 #ifdef REAL_IR_TX
-                const Command irCmd = pidResult.steps > 0 ? Command::TEMP_UP : Command::TEMP_DOWN;
-                for (int s = 0; s < abs(pidResult.steps); s++) {
-                    gIrSend.sendCommand(irCmd);
-                    delay(50);
-                }
-                Serial.printf("[IR] Sent %s x%d\n",
-                              gLastIrCmd, abs(pidResult.steps));
+                // Sent one per kIrStepGapMs below; opposite steps cancel out.
+                gIrStepsPending += pidResult.steps;
+                DIAG_LOGF(INFO, "IR", "Queued %s x%d",
+                          gLastIrCmd, abs(pidResult.steps));
 #else
-                Serial.printf("[IR]  -> %s x%d\n", gLastIrCmd, abs(pidResult.steps));
+                DIAG_LOGF(INFO, "IR", " -> %s x%d", gLastIrCmd, abs(pidResult.steps));
 #endif
             }
         }
     }
 
+#ifdef REAL_IR_TX
+    if (gIrStepsPending != 0 && !gControlTimers.pending(gIrStepTimer)) {
+        gIrSend.sendCommand(gIrStepsPending > 0 ? Command::TEMP_UP : Command::TEMP_DOWN);
+        gIrStepsPending += gIrStepsPending > 0 ? -1 : 1;
+        gIrStepTimer = gControlTimers.start(nowMs + kIrStepGapMs, 0);
+    }
+#endif
+
     // ── 8. Idle log when PID is off ───────────────────────────
-    if (!gHubClient.autoControl()) {
-        if (pidResult.ranControlCycle || (nowMs - lastTelemetryMs >= 10000)) {
-            Serial.printf("[IDLE] room=%.2f°C target=%.2f°C power=%s\n",
-                          roomTempC, gTargetTempC, gHeaterPowered ? "ON" : "OFF");
+    if (!gHubLink.autoControl()) {
+        if (pidResult.ranControlCycle || (nowMs - lastIdleLogMs >= 10000)) {
+            lastIdleLogMs = nowMs;
+            DIAG_LOGF(INFO, "IDLE", "room=%.2f°C target=%.2f°C power=%s",
+                      roomTempC, gTargetTempC, gHeaterPowered ? "ON" : "OFF");
         }
     }
 
-    // ── 8. Telemetry every 10s ────────────────────────────────
-    if (nowMs - lastTelemetryMs >= 10000) {
-        lastTelemetryMs = nowMs;
-        HubClient::Telemetry t;
+    // ── 8. Telemetry (HubLink queues changes and keyframes) ───
+    {
+        HubLink::Telemetry t;
         t.roomTempC   = roomTempC;
         t.targetTempC = gTargetTempC;
         t.powerOn     = gHeaterPowered;
@@ -587,36 +697,56 @@ void loop() {
         t.pidD        = gLastPidResult.d;
         t.pidSteps    = gLastPidResult.steps;
         t.integral    = gLastPidResult.i;
-        gHubClient.submitTelemetry(t);
+        gHubLink.submitTelemetry(t, wallNow);
     }
 
-    // ── 9. OLED update ────────────────────────────────────────
+    // ── 9. OLED frame (drawn by loop(); I2C is too slow for here) ──
 #ifdef REAL_OLED
-    updateDisplay(roomTempC, gTargetTempC, gHeaterPowered);
+    {
+        DisplayState frame;
+        frame.roomTempC   = roomTempC;
+        frame.targetTempC = gTargetTempC;
+        frame.heaterOn    = gHeaterPowered;
+        frame.lastIrCmd   = gLastIrCmd;
+        frame.lastIrSteps = gLastIrSteps;
+        frame.pid         = gLastPidResult;
+        gDisplayQueue.push(frame);  // full: loop() is behind, it gets the next one
+    }
 #endif
 
     // ── 10. Local scheduler ───────────────────────────────────
-    Command scheduledCmd;
-    if (gCommandScheduler.nextDueCommand(nowMs, wallNow, scheduledCmd)) {
-        Serial.printf("[SCHED] Firing: %s\n", commandToString(scheduledCmd));
-        gHubReceiver.push(scheduledCmd);
+    ScheduleAction scheduled;
+    bool setpointFired = false;
+    while (gSchedulePlan.nextDueAction(wallNow, scheduled)) {
+        if (!scheduled.setpoint) {
+            DIAG_LOGF(INFO, "SCHED", "Firing: %s", commandToString(scheduled.command));
+            gHubReceiver.push(scheduled.command);
+            break;
+        }
+        // Setpoints catch up in time order; the last one due wins.
+        DIAG_LOGF(INFO, "SCHED", "Setpoint: %.1f°C → %.1f°C", gTargetTempC, scheduled.setpointC);
+        gTargetTempC  = scheduled.setpointC;
+        setpointFired = true;
+    }
+    if (setpointFired && !gHeaterPowered) {
+        gHubReceiver.push(Command::ON_OFF);  // as the hub's schedule did
     }
 
     // ── 11a. Send custom IR (from custom buttons) ─────────────
 #ifdef REAL_IR_TX
-    if (gHubClient.hasPendingCustomIr()) {
-        auto ir = gHubClient.consumePendingCustomIr();
+    if (gHubLink.hasPendingCustomIr()) {
+        auto ir = gHubLink.consumePendingCustomIr();
         gIrLearner.sendCodeDirect(ir.protocol, ir.address, ir.command);
-        Serial.printf("[IR] Sent \"%s\": proto=%d addr=0x%04X cmd=0x%04X\n",
-                      ir.name[0] ? ir.name : "custom",
-                      ir.protocol, ir.address, ir.command);
+        DIAG_LOGF(INFO, "IR", "Sent \"%s\": proto=%d addr=0x%04X cmd=0x%04X",
+                  ir.name[0] ? ir.name : "custom",
+                  ir.protocol, ir.address, ir.command);
     }
 #endif
 
     // ── 11. Execute commands ──────────────────────────────────
     Command cmd;
     while (gHubReceiver.poll(cmd)) {
-        Serial.printf("[CMD] %s  target=%.1f°C  room=%.1f°C\n", commandToString(cmd), gTargetTempC, roomTempC);
+        DIAG_LOGF(INFO, "CMD", "%s  target=%.1f°C  room=%.1f°C", commandToString(cmd), gTargetTempC, roomTempC);
         gLogger.log(wallNow, LogEventType::COMMAND_SENT, cmd, true);
 
         switch (cmd) {
@@ -624,7 +754,7 @@ void loop() {
             gHeaterPowered = !gHeaterPowered;
 #ifdef REAL_IR_TX
             gIrSend.sendCommand(Command::ON_OFF);
-            Serial.printf("[IR] Sent ON/OFF\n");
+            DIAG_LOGF(INFO, "IR", "Sent ON/OFF");
 #endif
             if (gHeaterPowered) {
 #ifndef REAL_TEMP_SENSOR
@@ -638,12 +768,12 @@ void loop() {
             break;
 
         case Command::TEMP_UP:
-            if (!gHeaterPowered) { Serial.println("[CMD] Ignored TEMP_UP — heater is off"); break; }
-            if (gHubClient.autoControl()) {
+            if (!gHeaterPowered) { DIAG_LOGF(INFO, "CMD", "Ignored TEMP_UP — heater is off"); break; }
+            if (gHubLink.autoControl()) {
                 // PID mode: shift target, PID will handle IR
                 gTargetTempC += 0.5f;
-                Serial.printf("[CMD] PID target -> %.1f C\n", gTargetTempC);
-                gHubClient.forceTelemetry();
+                DIAG_LOGF(INFO, "CMD", "PID target -> %.1f C", gTargetTempC);
+                gHubLink.forceTelemetry();
             } else {
                 // Manual mode: send IR directly, but keep gTargetTempC in sync
                 gTargetTempC += 0.5f;
@@ -652,18 +782,18 @@ void loop() {
 #else
                 MockRoom::heaterSetpointC += 0.5f;
 #endif
-                Serial.printf("[CMD] Manual TEMP_UP — IR sent directly, target=%.1f\n", gTargetTempC);
-                gHubClient.forceTelemetry();
+                DIAG_LOGF(INFO, "CMD", "Manual TEMP_UP — IR sent directly, target=%.1f", gTargetTempC);
+                gHubLink.forceTelemetry();
             }
             break;
 
         case Command::TEMP_DOWN:
-            if (!gHeaterPowered) { Serial.println("[CMD] Ignored TEMP_DOWN — heater is off"); break; }
-            if (gHubClient.autoControl()) {
+            if (!gHeaterPowered) { DIAG_LOGF(INFO, "CMD", "Ignored TEMP_DOWN — heater is off"); break; }
+            if (gHubLink.autoControl()) {
                 // PID mode: shift target, PID will handle IR
                 gTargetTempC -= 0.5f;
-                Serial.printf("[CMD] PID target -> %.1f C\n", gTargetTempC);
-                gHubClient.forceTelemetry();
+                DIAG_LOGF(INFO, "CMD", "PID target -> %.1f C", gTargetTempC);
+                gHubLink.forceTelemetry();
             } else {
                 // Manual mode: send IR directly, but keep gTargetTempC in sync
                 gTargetTempC -= 0.5f;
@@ -672,8 +802,8 @@ void loop() {
 #else
                 MockRoom::heaterSetpointC -= 0.5f;
 #endif
-                Serial.printf("[CMD] Manual TEMP_DOWN — IR sent directly, target=%.1f\n", gTargetTempC);
-                gHubClient.forceTelemetry();
+                DIAG_LOGF(INFO, "CMD", "Manual TEMP_DOWN — IR sent directly, target=%.1f", gTargetTempC);
+                gHubLink.forceTelemetry();
             }
             break;
 
@@ -691,16 +821,17 @@ void loop() {
             else if (cmd == Command::LEARN_TEMP_DOWN) gLearnTarget = Command::TEMP_DOWN;
             else if (cmd == Command::LEARN_CUSTOM)   gLearnTarget = Command::LEARN_CUSTOM;
             gLearnState   = LearnState::WARMUP;
-            gLearnStartMs = nowMs;
-            Serial.printf("[LEARN] Setting up for %s — get your remote ready…\n",
-                          commandToString(cmd));
+            gControlTimers.cancel(gLearnTimer);
+            gLearnTimer   = gControlTimers.start(nowMs + kLearnWarmupMs, 0);
+            DIAG_LOGF(INFO, "LEARN", "Setting up for %s — get your remote ready…",
+                      commandToString(cmd));
 #endif
             break;
 
         case Command::LEARN_CLEAR_ALL:
 #ifdef REAL_IR_TX
             gIrLearner.clearAll();
-            Serial.println("[LEARN] All codes cleared.");
+            DIAG_LOGF(INFO, "LEARN", "All codes cleared.");
 #endif
             break;
 
@@ -708,4 +839,92 @@ void loop() {
             break;
         }
     }
-}
\ No newline at end of file
+}
+
+// ── LOOP ─────────────────────────────────────────────────────
+// Network side of core 1: WiFi/NTP upkeep, learn result posts and the OLED.
+// The control task preempts it, so nothing here delays the control cycle.
+void loop() {
+    const uint32_t nowMs = millis();
+
+    // ── 1. Connectivity + time ───────────────────────────────
+    // Skipped while IR learn is listening (the hub link is suspended then).
+    if (!gHubLink.suspended()) {
+        gHubConnectivity.tick(nowMs, gHubReceiver, gWallClock);
+        static bool lastWifiConnected = false;
+        static bool wifiPublished     = false;
+        const bool wifiConnected = gHubConnectivity.wifiConnected();
+        if (!wifiPublished || wifiConnected != lastWifiConnected) {
+            NetStatus status;
+            status.wifiConnected = wifiConnected;
+            if (gNetStatusQueue.push(status)) {
+                lastWifiConnected = wifiConnected;
+                wifiPublished     = true;
+            }
+        }
+    }
+
+    // ── 2. Post learn results ─────────────────────────────────
+#ifdef REAL_IR_TX
+    LearnReport report;
+    while (gLearnReportQueue.pop(report)) {
+        DIAG_LOGF(INFO, "LEARN", "Posting result to hub…");
+        // delay(500) lets the WiFi driver fully recover after seconds of
+        // zero WiFi calls during the IR capture.
+        delay(500);
+        // We MUST successfully POST the custom IR data, or the button will be empty (0,0,0)
+        if (postLearnResult(report)) {
+            // Force a sync so the Hub knows the 'learn_custom' command is finished
+            gHubLink.requestKeyframe();
+        }
+    }
+#endif
+
+    // ── 3. Fallbacks when a task could not be started ─────────
+    if (!gHubWorker.running()) {
+        gHubClient.service(nowMs);
+    }
+    if (!gControlTask.running()) {
+        runControlStep(nowMs);
+    }
+    if (kLogDrainEnabled && !gLogDrain.running()) {
+        gLogDrain.drain();
+    }
+
+    // ── 4. OLED update ────────────────────────────────────────
+#ifdef REAL_OLED
+    {
+        DisplayState frame;
+        bool hasFrame = false;
+        while (gDisplayQueue.pop(frame)) {
+            hasFrame = true;
+        }
+        if (hasFrame) {
+            updateDisplay(frame);
+        }
+    }
+#endif
+
+    // ── 5. Control timing report ──────────────────────────────
+    static uint32_t lastControlReportMs = 0;
+    if (gControlTask.running() && nowMs - lastControlReportMs >= kHubStatsLogIntervalMs) {
+        lastControlReportMs = nowMs;
+        const ControlTask::Stats stats = gControlTask.stats();
+        DIAG_LOGF(INFO, "CTRL", "cycles=%lu overruns=%lu maxStep=%luus maxLate=%luus",
+                  static_cast<unsigned long>(stats.cycles),
+                  static_cast<unsigned long>(stats.overruns),
+                  static_cast<unsigned long>(stats.maxStepUs),
+                  static_cast<unsigned long>(stats.maxLatenessUs));
+        const LogDrain::Stats logStats = gLogDrain.stats();
+        DIAG_LOGF(INFO, "LOG", "posted=%lu printed=%lu dropped=%lu overflows=%lu maxDepth=%lu",
+                  static_cast<unsigned long>(logStats.posted),
+                  static_cast<unsigned long>(logStats.printed),
+                  static_cast<unsigned long>(logStats.dropped),
+                  static_cast<unsigned long>(logStats.overflows),
+                  static_cast<unsigned long>(logStats.maxDepth));
+    }
+
+    if (gControlTask.running()) {
+        delay(kNetLoopPeriodMs);
+    }
+}
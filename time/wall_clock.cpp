@@ -30,6 +30,8 @@ void NtpClock::beginNtp(const char* timezone,
                         const char* ntp3) {
 #if __has_include(<Arduino.h>) && __has_include(<time.h>)
 // configures timezone and NTP servers for underlying system time functions.
+    // TZ is held under the lock too: now() calls localtime_r.
+    std::lock_guard<std::mutex> lock(mutex_);
     if (timezone != nullptr) {
         setenv("TZ", timezone, 1);
         tzset();
@@ -48,12 +50,18 @@ void NtpClock::beginNtp(const char* timezone,
 }
 
 void NtpClock::setUnixTimeMs(uint64_t unixMs, uint32_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    setBaseLocked(unixMs, nowMs);
+}
+
+void NtpClock::setBaseLocked(uint64_t unixMs, uint32_t nowMs) {
     baseUnixMs_ = unixMs;
     baseNowMs_ = nowMs;
     valid_ = true;
 }
 
 bool NtpClock::isValid() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return valid_;
 }
 
@@ -64,7 +72,7 @@ bool NtpClock::refreshFromSystemTime(uint32_t nowMs) {
         return false;
     }
 
-    setUnixTimeMs(static_cast<uint64_t>(current) * 1000ULL, nowMs);
+    setBaseLocked(static_cast<uint64_t>(current) * 1000ULL, nowMs);
     return true;
 #else
     (void)nowMs;
@@ -77,6 +85,7 @@ WallClockSnapshot NtpClock::now(uint32_t nowMs, uint32_t nowUs) {
     out.bootMs = nowMs;
     out.bootUs = nowUs;
 
+    std::lock_guard<std::mutex> lock(mutex_);
     if (!valid_ && ntpEnabled_) {
         refreshFromSystemTime(nowMs);
     }
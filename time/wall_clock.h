@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <mutex>
 
 struct WallClockSnapshot {
     uint32_t bootMs = 0;
@@ -26,6 +27,8 @@ public:
     virtual WallClockSnapshot now(uint32_t nowMs, uint32_t nowUs) = 0;
 };
 
+// now() runs on the control task while loop() may start NTP or set the time
+// through HubConnectivity, so the clock state is guarded by a mutex.
 class NtpClock : public IClock {
 public:
     // Starts system NTP sync if supported by target/runtime.
@@ -39,7 +42,9 @@ public:
 
 private:
     bool refreshFromSystemTime(uint32_t nowMs);
+    void setBaseLocked(uint64_t unixMs, uint32_t nowMs);
 
+    mutable std::mutex mutex_;
     bool valid_ = false;
     bool ntpEnabled_ = false;
     uint64_t baseUnixMs_ = 0;